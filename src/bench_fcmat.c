@@ -0,0 +1,501 @@
+/*----------------------------------------------------------------------
+  File    : bench_fcmat.c
+  Contents: parameter sweep benchmark (CSV or JSON output)
+  Author  : agent
+----------------------------------------------------------------------*/
+#ifndef _WIN32                  /* if Linux/Unix system */
+#define _POSIX_C_SOURCE 200809L /* needed for clock_gettime() */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <math.h>
+
+#include "cpuinfo.h"
+#include "stats.h"
+#include "fcmat.h"
+#include "nodedeg.h"
+#include "matrix.h"
+#include "edgestats.h"
+
+/*----------------------------------------------------------------------
+  Preprocessor definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "bench_fcmat"
+#define DESCRIPTION "parameter sweep benchmark " \
+                    "for functional connectivity matrices"
+#define VERSION     "v20261017"
+
+/*--------------------------------------------------------------------*/
+#define LIST_MAX      32        /* maximum number of values per list */
+#define REP_MAX     1024        /* maximum number of repetitions */
+
+#define PH_CREATE      0        /* fcm_create() */
+#define PH_FILL        1        /* tile fills during a traversal */
+#define PH_NEXT        2        /* fcm_first()/fcm_next() traversal */
+#define PH_NODEDEG     3        /* fcm_nodedeg() */
+#define PH_UNI         4        /* fcm_uni() (mean) */
+#define PH_CORR        5        /* fcm_corr() */
+#define PH_TSTAT2      6        /* fcm_tstat2() */
+#define PH_COHORT      7        /* fcm_cohort() */
+#define PH_CUNI        8        /* fcm_cohuni() (mean) */
+#define PH_CCORR       9        /* fcm_cohcorr() */
+#define PH_CTSTAT2    10        /* fcm_cohtstat2() */
+#define PH_CNT        11        /* number of phases */
+
+#define COH_TOL     1e-3        /* tolerance for cohort statistics */
+
+/*--------------------------------------------------------------------*/
+#define E_NONE         0        /* no error */
+#define E_NOMEM      (-1)       /* not enough memory */
+#define E_FOPEN      (-2)       /* cannot open file */
+#define E_OPTION     (-3)       /* unknown option */
+#define E_OPTARG     (-4)       /* missing option argument */
+#define E_ARGCNT     (-5)       /* wrong number of arguments */
+#define E_LIST       (-6)       /* invalid parameter list */
+#define E_THREAD     (-7)       /* thread computation error */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- a benchmark configuration */
+  DIM    V, T;                  /* number of voxels and time points */
+  int    corr;                  /* correlation type (FCM_PCC/FCM_TCC) */
+  int    r2z;                   /* flag for Fisher's r-to-z trans. */
+  int    P;                     /* number of threads */
+  DIM    C;                     /* tile size (0: on the fly, V: half) */
+} CONFIG;                       /* (one point of the sweep) */
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static const char *prgname;     /* program name for error messages */
+static FILE   *out;             /* output file for the results */
+static int    json  = 0;        /* flag for JSON output (else CSV) */
+static int    first = 1;        /* flag for the first result record */
+static double times[PH_CNT][REP_MAX];  /* measured times */
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {
+  /* E_NONE      0 */  "no error",
+  /* E_NOMEM    -1 */  "not enough memory",
+  /* E_FOPEN    -2 */  "cannot open file %s",
+  /* E_OPTION   -3 */  "unknown option -%c",
+  /* E_OPTARG   -4 */  "missing option argument",
+  /* E_ARGCNT   -5 */  "wrong number of arguments",
+  /* E_LIST     -6 */  "invalid parameter list -%c",
+  /* E_THREAD   -7 */  "thread computation error",
+  /*            -8 */  "unknown error"
+};                              /* list of error messages */
+
+static const char *phnames[PH_CNT] = {
+  "create", "fill", "traverse", "nodedeg", "uni", "corr", "tstat2",
+  "cohort", "cuni", "ccorr", "ctstat2" };
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+static double timer (void)
+{                               /* --- get current time */
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  LARGE_INTEGER c, f;           /* performance counter and frequency */
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (double)c.QuadPart /(double)f.QuadPart;
+  #else                         /* if Linux/Unix system */
+  struct timespec tp;           /* POSIX time specification */
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (double)tp.tv_sec +1e-9 *(double)tp.tv_nsec;
+  #endif                        /* return time in seconds */
+}  /* timer() */
+
+/*--------------------------------------------------------------------*/
+
+static int error (int code, ...)
+{                               /* --- print an error message */
+  int        k;                 /* maximal error code */
+  va_list    args;              /* list of variable arguments */
+  const char *msg;              /* error message */
+
+  assert(prgname);              /* check the program name */
+  va_start(args, code);         /* start variable arguments */
+  if      (code > 0) {          /* if an error message is given, */
+    msg = va_arg(args, const char*);        /* print it directly */
+    if (msg) fprintf(stderr, "\n%s: %s\n", prgname, msg); }
+  else if (code < 0) {          /* if code and arguments are given */
+    k = 1-(int)(sizeof(errmsgs)/sizeof(*errmsgs));
+    if (code < k) code = k;     /* check and adapt the error code */
+    msg = errmsgs[-code];       /* get the error message format */
+    if (!msg) msg = errmsgs[-k];/* check and adapt the message */
+    fprintf(stderr, "\n%s: ", prgname);
+    vfprintf(stderr, msg, args);/* print the error message and */
+    fputc('\n', stderr);        /* terminate the output line */
+  }
+  va_end(args);                 /* end variable arguments */
+  exit(abs(code));              /* abort the program */
+}  /* error() */
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static int getlist (char *s, char **end, long *list)
+{                               /* --- parse a list of numbers */
+  int  n = 0;                   /* number of list elements */
+  char *t;                      /* end of a number */
+
+  while (n < LIST_MAX) {        /* traverse the list elements */
+    if (*s == 'V') {            /* 'V' stands for the number */
+      list[n++] = -1; s++; }    /* of voxels (tile sizes) */
+    else {                      /* if a number is given */
+      list[n] = strtol(s, &t, 0);
+      if (t == s) break;        /* parse the number and */
+      n++; s = t;               /* check for a valid element */
+    }
+    if (*s != ',') break;       /* elements are separated */
+    s++;                        /* by commas */
+  }
+  *end = s;                     /* note the end of the list */
+  return n;                     /* return the number of elements */
+}  /* getlist() */
+
+/*--------------------------------------------------------------------*/
+
+static int dblcmp (const void *a, const void *b)
+{                               /* --- compare two doubles */
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x < y) ? -1 : (x > y) ? +1 : 0;
+}  /* dblcmp() */
+
+/*--------------------------------------------------------------------*/
+
+static double quantile (const double *t, int n, double p)
+{                               /* --- get a quantile of sorted times */
+  double x = p *(double)(n-1);  /* (linear interpolation between */
+  int    i = (int)x;            /* the two closest ranks) */
+  if (i >= n-1) return t[n-1];
+  return t[i] +(x -(double)i) *(t[i+1] -t[i]);
+}  /* quantile() */
+
+/*--------------------------------------------------------------------*/
+
+static void report (const CONFIG *cfg, int ph, int reps)
+{                               /* --- write the result of a phase */
+  double     *t = times[ph];    /* measured times of the phase */
+  double     med, e;            /* median time and number of edges */
+  const char *store;            /* storage mode */
+
+  qsort(t, (size_t)reps, sizeof(double), dblcmp);
+  med   = quantile(t, reps, 0.5);
+  e     = (double)cfg->V *(double)(cfg->V-1) /2;
+  store = (cfg->C <= 0) ? "otf" : (cfg->C >= cfg->V) ? "half" : "cache";
+  if (json)                     /* if to write a JSON object */
+    fprintf(out, "%s  {\"real\": \"%s\", \"corr\": \"%s\", "
+            "\"r2z\": %d, \"V\": %ld, \"T\": %ld, \"threads\": %d, "
+            "\"tile\": %ld, \"storage\": \"%s\", \"phase\": \"%s\", "
+            "\"reps\": %d, \"median\": %.6e, \"p10\": %.6e, "
+            "\"p90\": %.6e, \"min\": %.6e, \"max\": %.6e, "
+            "\"mccf\": %.3f}",
+            (first) ? "" : ",\n",
+            (sizeof(REAL) > 4) ? "double" : "float",
+            (cfg->corr == FCM_TCC) ? "tcc" : "pcc",
+            cfg->r2z, (long)cfg->V, (long)cfg->T, cfg->P,
+            (long)cfg->C, store, phnames[ph], reps, med,
+            quantile(t, reps, 0.1), quantile(t, reps, 0.9),
+            t[0], t[reps-1], (med > 0) ? e/med/1e6 : 0);
+  else {                        /* if to write a CSV record */
+    if (first)                  /* write a header before the first */
+      fprintf(out, "real,corr,r2z,V,T,threads,tile,storage,phase,"
+                   "reps,median,p10,p90,min,max,mccf\n");
+    fprintf(out, "%s,%s,%d,%ld,%ld,%d,%ld,%s,%s,%d,"
+                 "%.6e,%.6e,%.6e,%.6e,%.6e,%.3f\n",
+            (sizeof(REAL) > 4) ? "double" : "float",
+            (cfg->corr == FCM_TCC) ? "tcc" : "pcc",
+            cfg->r2z, (long)cfg->V, (long)cfg->T, cfg->P,
+            (long)cfg->C, store, phnames[ph], reps, med,
+            quantile(t, reps, 0.1), quantile(t, reps, 0.9),
+            t[0], t[reps-1], (med > 0) ? e/med/1e6 : 0);
+  }
+  first = 0;                    /* the next record is not the first */
+  fflush(out);                  /* (results of long sweeps are */
+}  /* report() */               /* written as soon as available) */
+
+/*--------------------------------------------------------------------*/
+
+static void check (const MATRIX *a, const MATRIX *b, const char *name)
+{                               /* --- compare cohort statistics */
+  DIM    i, j;                  /* loop variables */
+  double x, y;                  /* statistics to compare */
+
+  for (i = 0; i < mat_dim(a); i++) {
+    for (j = i+1; j < mat_dim(a); j++) {
+      x = (double)mat_get(a, i, j);
+      y = (double)mat_get(b, i, j);
+      if (fabs(x-y) <= COH_TOL *(fabs(x)+1)) continue;
+      fprintf(stderr, "\n%s %ld %ld: % 18.16f % 18.16f",
+              name, (long)i, (long)j, x, y);
+      error(1, "cohort statistics differ");
+    }                           /* (the cohort computes the same */
+  }                             /* statistics as the matrices, but */
+}  /* check() */                /* rounds differently) */
+
+/*--------------------------------------------------------------------*/
+
+static void run (const CONFIG *cfg, REAL **data, int n, int rep)
+{                               /* --- run all phases once */
+  int      mode;                /* computation mode */
+  int      i, t;                /* loop variable, traversal status */
+  double   t0;                  /* start time of a phase */
+  FCMAT    *fcm;                /* functional connectivity matrix */
+  FCMAT    **set;               /* matrices for edge statistics */
+  FCMSTATS st;                  /* runtime statistics */
+  DIM      *deg;                /* node degrees */
+  MATRIX   *mos;                /* matrix of statistics */
+  FCMCOHORT *coh = NULL;        /* cohort of subjects */
+  MATRIX   *cmo = NULL;         /* matrix of statistics of cohort */
+  REAL     *v;                  /* variable for fcm_corr() */
+  int      *g;                  /* groups for fcm_tstat2() */
+  volatile REAL a = 0;          /* sink for the traversed values */
+
+  mode = cfg->corr |FCM_THREAD |FCM_CACHE |(cfg->r2z ? FCM_R2Z : 0);
+  t0  = timer();                /* create a matrix */
+  fcm = fcm_create(data[0], cfg->V, cfg->T, mode, cfg->P, cfg->C);
+  if (!fcm) error(E_NOMEM);
+  times[PH_CREATE][rep] = timer() -t0;
+  t0 = timer();                 /* traverse the matrix */
+  for (t = fcm_first(fcm); t == 0; t = fcm_next(fcm))
+    a = fcm_value(fcm);
+  if (t < 0) error(E_THREAD);   /* check for a computation error */
+  times[PH_NEXT][rep] = timer() -t0;
+  fcm_stats(fcm, &st, -1);      /* get the tile fill time */
+  times[PH_FILL][rep] = st.time;
+  fcm_delete(fcm);              /* delete the matrix */
+
+  fcm = fcm_create(data[0], cfg->V, cfg->T, mode, cfg->P, cfg->C);
+  deg = (DIM*)malloc((size_t)cfg->V *sizeof(DIM));
+  if (!fcm || !deg) error(E_NOMEM);
+  t0 = timer();                 /* compute the node degrees */
+  if (fcm_nodedeg(fcm, (REAL)0.01, deg, FCM_THREAD, cfg->P) != 0)
+    error(E_THREAD);
+  times[PH_NODEDEG][rep] = timer() -t0;
+  free(deg); fcm_delete(fcm);   /* delete the matrix and degrees */
+
+  if (n < 2) return;            /* check for edge statistics */
+  set = (FCMAT**)malloc((size_t)n *sizeof(FCMAT*));
+  v   = (REAL*)  malloc((size_t)n *sizeof(REAL));
+  g   = (int*)   malloc((size_t)n *sizeof(int));
+  mos = mat_create(cfg->V, 0);  /* allocate the matrices, */
+  if (!set || !v || !g || !mos) /* the variable, the groups */
+    error(E_NOMEM);             /* and the result matrix */
+  for (i = 0; i < n; i++) {     /* create the matrices */
+    set[i] = fcm_create(data[i], cfg->V, cfg->T, mode, cfg->P, cfg->C);
+    if (!set[i]) error(E_NOMEM);
+    v[i] = (REAL)(rand()/((double)RAND_MAX+1));
+    g[i] = i & 1;               /* draw the variable and */
+  }                             /* alternate the groups */
+  if (cfg->corr == FCM_PCC) {    /* if Pearson correlation, */
+    cmo = mat_create(cfg->V, 0);/* also create a cohort */
+    t0  = timer();              /* (one arena for all subjects) */
+    coh = fcm_cohort(data, n, cfg->V, cfg->T, mode, cfg->P, cfg->C);
+    if (!coh || !cmo) error(E_NOMEM);
+    times[PH_COHORT][rep] = timer() -t0;
+  }
+  t0 = timer();                 /* compute the edge statistics */
+  if (fcm_uni(set, n, mean, mos, FCM_THREAD, cfg->P) != 0)
+    error(E_THREAD);
+  times[PH_UNI][rep] = timer() -t0;
+  if (coh) {                    /* compute them for the cohort */
+    t0 = timer();               /* and compare the results */
+    if (fcm_cohuni(coh, mean, cmo) != 0) error(E_THREAD);
+    times[PH_CUNI][rep] = timer() -t0;
+    check(mos, cmo, "uni");
+  }
+  t0 = timer();
+  if (fcm_corr(set, n, v, mos, FCM_THREAD, cfg->P) != 0)
+    error(E_THREAD);
+  times[PH_CORR][rep] = timer() -t0;
+  if (coh) {
+    t0 = timer();
+    if (fcm_cohcorr(coh, v, cmo) != 0) error(E_THREAD);
+    times[PH_CCORR][rep] = timer() -t0;
+    check(mos, cmo, "corr");
+  }
+  t0 = timer();
+  if (fcm_tstat2(set, n, g, mos, FCM_THREAD, cfg->P) != 0)
+    error(E_THREAD);
+  times[PH_TSTAT2][rep] = timer() -t0;
+  if (coh) {
+    t0 = timer();
+    if (fcm_cohtstat2(coh, g, cmo) != 0) error(E_THREAD);
+    times[PH_CTSTAT2][rep] = timer() -t0;
+    check(mos, cmo, "tstat2");
+    fcm_cohdel(coh); mat_delete(cmo);
+  }                             /* delete the cohort */
+  for (i = 0; i < n; i++)       /* delete the matrices */
+    fcm_delete(set[i]);
+  mat_delete(mos); free(g); free(v); free(set);
+  (void)a;                      /* (the sink only prevents that */
+}  /* run() */                  /* the traversal is optimized away) */
+
+/*----------------------------------------------------------------------
+  Main Function
+----------------------------------------------------------------------*/
+int main (int argc, char* argv[])
+{                               /* --- main function for benchmarking */
+  char    *s;                   /* to traverse the options */
+  char    **optarg = NULL;      /* option argument */
+  long    Vs[LIST_MAX] = { 1000 };      /* numbers of voxels */
+  long    Ts[LIST_MAX] = { 100 };       /* numbers of time points */
+  long    Ps[LIST_MAX] = { 0 };         /* numbers of threads */
+  long    Cs[LIST_MAX] = { 0, 256, -1 };/* tile sizes */
+  long    Zs[LIST_MAX] = { 0 };         /* r-to-z flags */
+  int     nV = 1, nT = 1, nP = 1, nC = 3, nZ = 1;
+  char    *corrs = "p";         /* correlation types */
+  int     warm  = 1;            /* number of warmup runs */
+  int     reps  = 5;            /* number of repetitions */
+  int     n     = 4;            /* number of matrices for edge stats. */
+  long    S     = time(NULL);   /* seed value for random numbers */
+  char    *fname = NULL;        /* name of the output file */
+  REAL    **data;               /* data arrays */
+  CONFIG  cfg;                  /* current configuration */
+  int     iv, it, ix, iz, ip, ic, i, r, k;  /* loop variables */
+  size_t  z;                    /* size of a data array */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+  Ps[0]   = proccnt();          /* default: use all processors */
+
+  /* --- print usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", PRGNAME, DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument is given */
+    printf("usage: %s [options]\n", argv[0]);
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-V#,#..  numbers of voxels                        "
+           "(default: 1000)\n");
+    printf("-T#,#..  numbers of time points                   "
+           "(default: 100)\n");
+    printf("-t#,#..  numbers of threads                       "
+           "(default: %ld)\n", Ps[0]);
+    printf("-c#,#..  tile sizes (0: on the fly, V: half-stored)"
+           " (default: 0,256,V)\n");
+    printf("-x pt    correlation types (p: pcc, t: tcc)       "
+           "(default: p)\n");
+    printf("-z#,#..  Fisher r-to-z transform flags            "
+           "(default: 0)\n");
+    printf("-w#      number of warmup runs                    "
+           "(default: %d)\n", warm);
+    printf("-r#      number of repetitions                    "
+           "(default: %d)\n", reps);
+    printf("-n#      number of matrices for edge statistics   "
+           "(default: %d)\n", n);
+    printf("-s#      seed value for random number generator   "
+           "(default: time)\n");
+    printf("-j       write JSON instead of CSV\n");
+    printf("-o file  output file                              "
+           "(default: stdout)\n");
+    printf("(the precision is chosen at compile time, "
+           "e.g. make REAL=double)\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  for (i = 1; i < argc; i++) {  /* traverse the arguments */
+    s = argv[i];                /* get an option argument */
+    if (optarg) { *optarg = s; optarg = NULL; continue; }
+    if ((*s == '-') && *++s) {  /* -- if argument is an option */
+      while (*s) {              /* traverse the options */
+        switch (k = *s++) {     /* evaluate the options */
+          case 'V': nV   = getlist(s, &s, Vs); break;
+          case 'T': nT   = getlist(s, &s, Ts); break;
+          case 't': nP   = getlist(s, &s, Ps); break;
+          case 'c': nC   = getlist(s, &s, Cs); break;
+          case 'z': nZ   = getlist(s, &s, Zs); break;
+          case 'x': optarg = &corrs;           break;
+          case 'w': warm = (int)strtol(s, &s, 0); break;
+          case 'r': reps = (int)strtol(s, &s, 0); break;
+          case 'n': n    = (int)strtol(s, &s, 0); break;
+          case 's': S    =      strtol(s, &s, 0); break;
+          case 'j': json = 1;                  break;
+          case 'o': optarg = &fname;           break;
+          default : error(E_OPTION, *--s);     break;
+        }                       /* set the option variables */
+        if ((nV <= 0) || (nT <= 0) || (nP <= 0) || (nC <= 0)
+        ||  (nZ <= 0)) error(E_LIST, k);   /* check the lists */
+        if (optarg && *s) { *optarg = s; optarg = NULL; break; }
+      } }                       /* get an option argument */
+    else error(E_ARGCNT);       /* there are no non-options */
+  }
+  if (optarg) error(E_OPTARG);  /* check option arguments */
+  if ((reps < 1) || (reps > REP_MAX)) error(1, "invalid repetitions");
+  if (warm < 0) warm = 0;       /* check the repetitions */
+  if (n < 0)    n    = 0;       /* and the number of matrices */
+  for (s = corrs; *s; s++)      /* check the correlation types */
+    if ((*s != 'p') && (*s != 't')) error(E_LIST, 'x');
+  if (S <  0) error(1, "S < 0");/* get the seed value and */
+  srand((unsigned)S);           /* seed the random number generator */
+  out = stdout;                 /* open the output file */
+  if (fname && !(out = fopen(fname, "w"))) error(E_FOPEN, fname);
+  fprintf(stderr, "\n");        /* terminate the startup message */
+  if (json) fprintf(out, "[\n");
+
+  /* --- run the sweep --- */
+  k = (n > 1) ? n : 1;          /* number of data arrays */
+  data = (REAL**)calloc((size_t)k, sizeof(REAL*));
+  if (!data) error(E_NOMEM);    /* allocate the data array list */
+  for (iv = 0; iv < nV; iv++) { /* traverse the numbers of voxels */
+    for (it = 0; it < nT; it++) {     /* and of time points */
+      cfg.V = (DIM)Vs[iv];      /* note the matrix dimensions */
+      cfg.T = (DIM)Ts[it];      /* and check them */
+      if (cfg.V < 2) error(E_LIST, 'V');
+      if (cfg.T < 2) error(E_LIST, 'T');
+      z = (size_t)cfg.V *(size_t)cfg.T;
+      for (i = 0; i < k; i++) { /* generate the data arrays */
+        data[i] = (REAL*)realloc(data[i], z *sizeof(REAL));
+        if (!data[i]) error(E_NOMEM);
+        for (size_t j = 0; j < z; j++)
+          data[i][j] = (REAL)(rand()/((double)RAND_MAX+1));
+      }
+      for (ix = 0; corrs[ix]; ix++) {   /* traverse the corr. types, */
+        cfg.corr = (corrs[ix] == 't') ? FCM_TCC : FCM_PCC;
+        for (iz = 0; iz < nZ; iz++) {   /* the r-to-z flags, */
+          cfg.r2z = (Zs[iz] != 0);
+          for (ip = 0; ip < nP; ip++) { /* the numbers of threads */
+            cfg.P = (Ps[ip] > 0) ? (int)Ps[ip] : 1;
+            for (ic = 0; ic < nC; ic++) {   /* and the tile sizes */
+              cfg.C = ((Cs[ic] < 0) || (Cs[ic] > Vs[iv]))
+                    ? cfg.V : (DIM)Cs[ic];
+              fprintf(stderr, "%s V=%ld T=%ld P=%d C=%ld r2z=%d ... ",
+                      (cfg.corr == FCM_TCC) ? "tcc" : "pcc",
+                      (long)cfg.V, (long)cfg.T, cfg.P, (long)cfg.C,
+                      cfg.r2z);
+              for (r = -warm; r < reps; r++)
+                run(&cfg, data, n, (r < 0) ? 0 : r);
+              for (i = 0; i < PH_CNT; i++)
+                if ((i < PH_UNI) || ((n > 1) && ((i < PH_COHORT)
+                ||  (cfg.corr == FCM_PCC))))
+                  report(&cfg, i, reps);
+              fprintf(stderr, "done.\n");
+            }                   /* run the warmup runs and the */
+          }                     /* repetitions (warmup results are */
+        }                       /* overwritten) and write the */
+      }                         /* results of all phases */
+    }
+  }
+  for (i = 0; i < k; i++)       /* delete the data arrays */
+    free(data[i]);
+  free(data);
+  if (json) fprintf(out, "\n]\n");
+  if (out != stdout) fclose(out);
+  #ifndef _WIN32                /* if Linux/Unix system */
+  fcm_poolexit();               /* stop the shared thread pool */
+  #endif
+  return 0;                     /* return 'ok' */
+}  /* main() */
@@ -0,0 +1,527 @@
+/*----------------------------------------------------------------------
+  File    : bench_kern.c
+  Contents: kernel microbenchmarks with roofline placement
+  Author  : agent
+----------------------------------------------------------------------*/
+#ifndef _WIN32                  /* if Linux/Unix system */
+#define _POSIX_C_SOURCE 200809L /* needed for clock_gettime() */
+#define _DEFAULT_SOURCE         /* needed for _SC_LEVEL1_DCACHE_SIZE */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "cpuinfo.h"
+#include "stats.h"
+#include "binarize.h"
+#include "pcc.h"
+#include "tetracc.h"
+#include "fcmat.h"
+#include "matrix.h"
+
+/*----------------------------------------------------------------------
+  Preprocessor definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "bench_kern"
+#define DESCRIPTION "kernel microbenchmarks with roofline placement"
+#define VERSION     "v20261017"
+
+/*--------------------------------------------------------------------*/
+#define INDEX(i,j,N)    ((size_t)(i)*((size_t)(N)+(size_t)(N) \
+                        -(size_t)(i)-3)/2-1+(size_t)(j))
+
+/*--------------------------------------------------------------------*/
+#define LVL_CNT        4        /* number of memory levels */
+#define PEAK_LEN     256        /* accumulators for the flop peak */
+
+/*--------------------------------------------------------------------*/
+#define E_NONE         0        /* no error */
+#define E_NOMEM      (-1)       /* not enough memory */
+#define E_OPTION     (-2)       /* unknown option */
+#define E_ARGCNT     (-3)       /* wrong number of arguments */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- result of a kernel run */
+  double ops;                   /* number of (floating point) ops. */
+  double bytes;                 /* number of bytes transferred */
+  double time;                  /* execution time in seconds */
+} RESULT;                       /* (summed over all repetitions) */
+
+typedef RESULT KERNEL (size_t size);
+                                /* --- kernel benchmark function */
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static const char *prgname;     /* program name for error messages */
+static double     mintime = 0.2;/* minimal measurement time */
+static REAL       *src;         /* random data (largest working set) */
+static size_t     srclen;       /* number of elements of the data */
+static volatile double sink;    /* sink for computed values */
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {
+  /* E_NONE      0 */  "no error",
+  /* E_NOMEM    -1 */  "not enough memory",
+  /* E_OPTION   -2 */  "unknown option -%c",
+  /* E_ARGCNT   -3 */  "wrong number of arguments",
+  /*            -4 */  "unknown error"
+};                              /* list of error messages */
+
+static const char *lvlnames[LVL_CNT] = { "L1", "L2", "L3", "DRAM" };
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+static double timer (void)
+{                               /* --- get current time */
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  LARGE_INTEGER c, f;           /* performance counter and frequency */
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (double)c.QuadPart /(double)f.QuadPart;
+  #else                         /* if Linux/Unix system */
+  struct timespec tp;           /* POSIX time specification */
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (double)tp.tv_sec +1e-9 *(double)tp.tv_nsec;
+  #endif                        /* return time in seconds */
+}  /* timer() */
+
+/*--------------------------------------------------------------------*/
+
+static int error (int code, ...)
+{                               /* --- print an error message */
+  int        k;                 /* maximal error code */
+  va_list    args;              /* list of variable arguments */
+  const char *msg;              /* error message */
+
+  assert(prgname);              /* check the program name */
+  va_start(args, code);         /* start variable arguments */
+  if      (code > 0) {          /* if an error message is given, */
+    msg = va_arg(args, const char*);        /* print it directly */
+    if (msg) fprintf(stderr, "\n%s: %s\n", prgname, msg); }
+  else if (code < 0) {          /* if code and arguments are given */
+    k = 1-(int)(sizeof(errmsgs)/sizeof(*errmsgs));
+    if (code < k) code = k;     /* check and adapt the error code */
+    msg = errmsgs[-code];       /* get the error message format */
+    if (!msg) msg = errmsgs[-k];/* check and adapt the message */
+    fprintf(stderr, "\n%s: ", prgname);
+    vfprintf(stderr, msg, args);/* print the error message and */
+    fputc('\n', stderr);        /* terminate the output line */
+  }
+  va_end(args);                 /* end variable arguments */
+  exit(abs(code));              /* abort the program */
+}  /* error() */
+
+/*----------------------------------------------------------------------
+  Machine Peaks
+----------------------------------------------------------------------*/
+
+static double peak_flops (void)
+{                               /* --- measure peak flop rate */
+  REAL   x[PEAK_LEN];           /* independent accumulators */
+  REAL   m = (REAL)0.999999;    /* factor and summand that keep */
+  REAL   a = (REAL)1e-6;        /* the accumulators bounded */
+  size_t i, k, n = 1024;        /* loop variables, repetitions */
+  double t, t0;                 /* execution time */
+
+  for (k = 0; k < PEAK_LEN; k++) x[k] = (REAL)k;
+  do {                          /* double the repetitions until */
+    n += n; t0 = timer();       /* the minimal time is reached */
+    for (i = 0; i < n; i++)     /* (the inner loop is vectorized, */
+      for (k = 0; k < PEAK_LEN; k++)   /* its iterations are */
+        x[k] = x[k]*m +a;       /* independent of each other) */
+    t = timer() -t0;
+  } while (t < mintime);
+  for (k = 0; k < PEAK_LEN; k++) sink += x[k];
+  return 2.0 *(double)PEAK_LEN *(double)n /t;
+}  /* peak_flops() */           /* return flops per second */
+
+/*--------------------------------------------------------------------*/
+
+static double peak_bw (size_t size)
+{                               /* --- measure peak read bandwidth */
+  uint64_t *a, s = 0;           /* array to read and its checksum */
+  size_t   i, k, n = 1;         /* loop variables, repetitions */
+  size_t   m = size /sizeof(uint64_t);
+  double   t, t0;               /* execution time */
+
+  a = (uint64_t*)malloc(m *sizeof(uint64_t));
+  if (!a) error(E_NOMEM);       /* allocate and fill the array */
+  for (i = 0; i < m; i++) a[i] = (uint64_t)i *0x9e3779b97f4a7c15ULL;
+  do {                          /* double the repetitions until */
+    n += n; t0 = timer();       /* the minimal time is reached */
+    for (k = 0; k < n; k++)     /* (an integer reduction may be */
+      for (i = 0; i < m; i++)   /* vectorized by the compiler) */
+        s ^= a[i];
+    t = timer() -t0;
+  } while (t < mintime);
+  sink += (double)s; free(a);   /* (keep the reduction alive) */
+  return (double)m *sizeof(uint64_t) *(double)n /t;
+}  /* peak_bw() */              /* return bytes per second */
+
+/*----------------------------------------------------------------------
+  Kernel Benchmarks
+----------------------------------------------------------------------*/
+
+static FCMAT* prep (int corr, size_t size, DIM *V)
+{                               /* --- prepare data for pair kernels */
+  FCMAT  *fcm;                  /* on-the-fly matrix (data only) */
+  DIM    T = 256;               /* number of time points */
+  size_t row;                   /* size of a prepared row in bytes */
+
+  row = (corr == FCM_PCC) ? (size_t)T *sizeof(REAL) : (size_t)T/8;
+  *V  = (DIM)(size /row);       /* (binarized data: one bit per */
+  if (*V < 2) *V = 2;           /* time point) */
+  if ((size_t)*V *(size_t)T > srclen) *V = (DIM)(srclen /(size_t)T);
+  fcm = fcm_create(src, *V, T, corr|FCM_CACHE, 0);
+  if (!fcm) error(E_NOMEM);     /* create an on-the-fly matrix */
+  return fcm;                   /* (the kernels are selected and */
+}  /* prep() */                 /* the data prepared as usual) */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT pair_pcc (size_t size)
+{                               /* --- Pearson pair kernel */
+  FCMAT  *fcm;                  /* matrix with normalized data */
+  RESULT r = { 0, 0, 0 };       /* result of the benchmark */
+  DIM    V, i, j, k;            /* loop variables */
+  REAL   *d, s = 0;             /* normalized data, sum of results */
+  double t0;                    /* start time */
+
+  fcm = prep(FCM_PCC, size, &V);/* normalize the data */
+  d   = (REAL*)fcm->data;       /* and get the rows */
+  k   = (V > 64) ? V/64 : 1;    /* stride for the second row */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* traverse pairs of rows */
+    for (i = 0; i < V; i++)
+      for (j = i+1; j < V; j += k)
+        s += fcm->pair(d +(size_t)i *(size_t)fcm->X,
+                       d +(size_t)j *(size_t)fcm->X, (int)fcm->T);
+    r.time += timer() -t0;      /* count multiply and add */
+    for (i = 0, j = 0; i < V; i++)  /* per time point and the */
+      j += (V-i-1 +k-1) /k;         /* two rows read */
+    r.ops   += 2.0 *(double)j *(double)fcm->T;
+    r.bytes += 2.0 *(double)j *(double)fcm->X *sizeof(REAL);
+  } while (r.time < mintime);
+  sink += s; fcm_delete(fcm);   /* keep the results alive */
+  return r;                     /* return the measurements */
+}  /* pair_pcc() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT pcand_tcc (size_t size)
+{                               /* --- tetrachoric pair kernel */
+  FCMAT    *fcm;                /* matrix with binarized data */
+  RESULT   r = { 0, 0, 0 };     /* result of the benchmark */
+  DIM      V, i, j, k;          /* loop variables */
+  uint32_t *d;                  /* binarized data */
+  long     s = 0;               /* sum of results */
+  double   t0;                  /* start time */
+
+  fcm = prep(FCM_TCC, size, &V);/* binarize the data */
+  d   = (uint32_t*)fcm->data;   /* and get the bit arrays */
+  k   = (V > 64) ? V/64 : 1;    /* stride for the second row */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* traverse pairs of rows */
+    for (i = 0; i < V; i++)
+      for (j = i+1; j < V; j += k)
+        s += fcm->pcand(d +(size_t)i *(size_t)fcm->X,
+                        d +(size_t)j *(size_t)fcm->X, (int)fcm->X);
+    r.time += timer() -t0;      /* count AND, popcount and add */
+    for (i = 0, j = 0; i < V; i++)  /* per 32 bit word and the */
+      j += (V-i-1 +k-1) /k;         /* two bit arrays read */
+    r.ops   += 3.0 *(double)j *(double)fcm->X;
+    r.bytes += 2.0 *(double)j *(double)fcm->X *sizeof(uint32_t);
+  } while (r.time < mintime);
+  sink += (double)s; fcm_delete(fcm);
+  return r;                     /* return the measurements */
+}  /* pcand_tcc() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT init_pcc (size_t size)
+{                               /* --- data normalization kernel */
+  RESULT r = { 0, 0, 0 };       /* result of the benchmark */
+  int    T = 256, X = 256;      /* number of time points */
+  int    V;                     /* number of voxels */
+  REAL   *norm;                 /* normalized data */
+  double t0;                    /* start time */
+
+  V = (int)(size /(2 *(size_t)T *sizeof(REAL)));
+  if (V < 1) V = 1;             /* (input and output rows) */
+  norm = (REAL*)malloc((size_t)V *(size_t)X *sizeof(REAL));
+  if (!norm) error(E_NOMEM);    /* allocate the output */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* normalize the data with the */
+    #ifdef __AVX__              /* kernel that fcm_create() uses */
+    if (hasAVX()) init_avx (src, V, T, norm, X); else
+    #endif
+    #ifdef __SSE2__
+    if (hasSSE2()) init_sse2(src, V, T, norm, X); else
+    #endif
+    init_naive(src, V, T, norm, X);
+    r.time  += timer() -t0;     /* count mean, centering, squares */
+    r.ops   += 5.0 *(double)V *(double)T;    /* and scaling */
+    r.bytes += (double)V *(double)(T+X) *sizeof(REAL);
+  } while (r.time < mintime);
+  sink += norm[0]; free(norm);  /* keep the results alive */
+  return r;                     /* return the measurements */
+}  /* init_pcc() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT binarize_tcc (size_t size)
+{                               /* --- binarization kernel */
+  RESULT   r = { 0, 0, 0 };     /* result of the benchmark */
+  int      T = 256, V;          /* number of time points and voxels */
+  uint32_t *b;                  /* binarized data */
+  double   t0;                  /* start time */
+
+  V = (int)(size /((size_t)T *sizeof(REAL)));
+  if (V < 1) V = 1;             /* (the input dominates) */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* binarize at the median */
+    b  = binarize(src, V, T, BIN_MEDIAN, 32);
+    r.time  += timer() -t0;     /* count one comparison and about */
+    if (!b) error(E_NOMEM);     /* log2(T) for the median per value */
+    sink += (double)b[0]; free(b);
+    r.ops   += (double)V *(double)T *(1 +log2((double)T));
+    r.bytes += (double)V *(double)T *(sizeof(REAL) +1.0/8);
+  } while (r.time < mintime);
+  return r;                     /* return the measurements */
+}  /* binarize_tcc() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT r2z (size_t size)
+{                               /* --- Fisher r-to-z transform */
+  RESULT r = { 0, 0, 0 };       /* result of the benchmark */
+  size_t i, n;                  /* loop variable, number of values */
+  REAL   *z;                    /* transformed values */
+  double t0;                    /* start time */
+
+  n = size /(2 *sizeof(REAL));  /* (input and output arrays) */
+  if (n < 1) n = 1;
+  z = (REAL*)malloc(n *sizeof(REAL));
+  if (!z) error(E_NOMEM);       /* allocate the output */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* transform correlation coeffs. */
+    for (i = 0; i < n; i++)     /* (the data lie in [0,1)) */
+      z[i] = fisher_r2z(src[i]);
+    r.time  += timer() -t0;     /* count the arithmetic of */
+    r.ops   += 4.0 *(double)n;  /* 0.5*log((1+r)/(1-r)) */
+    r.bytes += 2.0 *(double)n *sizeof(REAL);
+  } while (r.time < mintime);   /* (the logarithm is not counted) */
+  sink += z[n-1]; free(z);      /* keep the results alive */
+  return r;                     /* return the measurements */
+}  /* r2z() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT tri_index (size_t size)
+{                               /* --- triangle index computation */
+  RESULT r = { 0, 0, 0 };       /* result of the benchmark */
+  size_t N, i, j, s = 0;        /* matrix size, loop variables */
+  double t0;                    /* start time */
+
+  N = (size_t)sqrt(2.0 *(double)size /sizeof(REAL)) +2;
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* compute the indices of a triangle */
+    for (i = 0; i < N; i++)     /* of the given size */
+      for (j = i+1; j < N; j++)
+        s += INDEX(i, j, N);
+    r.time += timer() -t0;      /* count the integer operations */
+    r.ops  += 6.0 *(double)N *(double)(N-1)/2;
+  } while (r.time < mintime);   /* (no data are read) */
+  sink += (double)s;            /* keep the results alive */
+  return r;                     /* return the measurements */
+}  /* tri_index() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT mat_store (size_t size)
+{                               /* --- store in a result matrix */
+  RESULT r = { 0, 0, 0 };       /* result of the benchmark */
+  MATRIX *mat;                  /* matrix of statistics */
+  DIM    N, i, j;               /* matrix size, loop variables */
+  double t0;                    /* start time */
+
+  N = (DIM)sqrt(2.0 *(double)size /sizeof(REAL)) +2;
+  mat = mat_create(N, 0);       /* create a full matrix */
+  if (!mat) error(E_NOMEM);     /* of the given size */
+  do {                          /* repeat until the minimal time */
+    t0 = timer();               /* set all elements */
+    for (i = 0; i < N; i++)
+      for (j = i+1; j < N; j++)
+        mat_set(mat, i, j, (REAL)i);
+    r.time  += timer() -t0;     /* count the index computation */
+    r.ops   += 6.0 *(double)N *(double)(N-1)/2;  /* and one */
+    r.bytes += (double)N *(double)(N-1)/2 *sizeof(REAL);
+  } while (r.time < mintime);   /* element write per element */
+  sink += mat_get(mat, 0, 1); mat_delete(mat);
+  return r;                     /* return the measurements */
+}  /* mat_store() */
+
+/*--------------------------------------------------------------------*/
+
+static RESULT fill_tile (size_t size)
+{                               /* --- fill worker of the tile cache */
+  RESULT   r = { 0, 0, 0 };     /* result of the benchmark */
+  FCMAT    *fcm;                /* cache-based matrix */
+  FCMSTATS st;                  /* runtime statistics */
+  DIM      T = 256, C, V;       /* time points, tile size, voxels */
+  int      t;                   /* traversal status */
+
+  C = (DIM)(sqrt((double)T*(double)T +(double)size/sizeof(REAL))
+           -(double)T);         /* the rows and columns of a tile */
+  if (C < 16) C = 16;           /* and the tile itself are the */
+  V = 2*C;                      /* working set (2 x 2 tiles) */
+  if ((size_t)V *(size_t)T > srclen) V = (DIM)(srclen /(size_t)T);
+  do {                          /* repeat until the minimal time */
+    fcm = fcm_create(src, V, T, FCM_PCC|FCM_THREAD|FCM_CACHE, 1, C);
+    if (!fcm) error(E_NOMEM);   /* create a cache-based matrix */
+    for (t = fcm_first(fcm); t == 0; t = fcm_next(fcm))
+      sink += fcm_value(fcm);   /* traverse it (fills all tiles) */
+    fcm_stats(fcm, &st, -1);    /* and get the fill statistics */
+    fcm_delete(fcm);
+    r.time  += st.time;         /* count multiply and add */
+    r.ops   += 2.0 *(double)st.comp *(double)T;
+    r.bytes += st.bytes;        /* and the rows streamed in */
+  } while (r.time < mintime);   /* by the block kernels */
+  return r;                     /* return the measurements */
+}  /* fill_tile() */
+
+/*----------------------------------------------------------------------
+  Main Function
+----------------------------------------------------------------------*/
+int main (int argc, char* argv[])
+{                               /* --- main function for benchmarking */
+  static const struct {         /* --- list of kernels */
+    const char *name;           /* name of the kernel */
+    KERNEL     *fn;             /* benchmark function */
+    int        mem;             /* whether the working set matters */
+  } kernels[] = {
+    { "pair_pcc",  pair_pcc,     1 },
+    { "pcand_tcc", pcand_tcc,    1 },
+    { "init_pcc",  init_pcc,     1 },
+    { "binarize",  binarize_tcc, 1 },
+    { "r2z",       r2z,          1 },
+    { "index",     tri_index,    0 },
+    { "mat_set",   mat_store,    1 },
+    { "fill",      fill_tile,    1 } };
+  char   *s;                    /* to traverse the options */
+  long   sizes[LVL_CNT];        /* working set sizes */
+  double bw[LVL_CNT];           /* peak bandwidths */
+  double flops;                 /* peak flop rate */
+  double ai, roof, rate;        /* arithmetic intensity, roofline */
+  long   D = 0;                 /* DRAM working set in MiB */
+  RESULT r;                     /* result of a kernel benchmark */
+  int    i, k, n;               /* loop variables */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+
+  /* --- print usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", PRGNAME, DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument is given */
+    printf("usage: %s [options] -\n", argv[0]);
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-m#      minimal time per measurement in seconds  "
+           "(default: %g)\n", mintime);
+    printf("-D#      DRAM working set in MiB                  "
+           "(default: 4x L3, >= 2x L3)\n");
+    printf("-        run with the default settings\n");
+    printf("(ops of pcand_tcc, binarize, index and mat_set are "
+           "integer operations)\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  for (i = 1; i < argc; i++) {  /* traverse the arguments */
+    s = argv[i];                /* get an option argument */
+    if (*s != '-') error(E_ARGCNT);
+    for (s++; *s; ) {           /* traverse the options */
+      switch (*s++) {           /* evaluate the options */
+        case 'm': mintime =      strtod(s, &s);    break;
+        case 'D': D       =      strtol(s, &s, 0); break;
+        default : error(E_OPTION, *--s);           break;
+      }                         /* set the option variables */
+    }
+  }
+  if (mintime <= 0) mintime = 0.2;
+  fprintf(stderr, "\n");        /* terminate the startup message */
+
+  /* --- get the working set sizes --- */
+  #ifdef _SC_LEVEL1_DCACHE_SIZE /* if the cache sizes are known */
+  sizes[0] = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  sizes[1] = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  sizes[2] = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  #else                         /* otherwise use typical sizes */
+  sizes[0] = sizes[1] = sizes[2] = 0;
+  #endif
+  if (sizes[0] <= 0) sizes[0] = 32L << 10;
+  if (sizes[1] <= 0) sizes[1] = 1L  << 20;
+  if (sizes[2] <= 0) sizes[2] = 32L << 20;
+  sizes[3] = (D > 0) ? D << 20 : 4*sizes[2];
+  if (sizes[3] < (64L << 20)) sizes[3] = 64L << 20;
+  if (sizes[3] < 2*sizes[2])    /* the DRAM working set must not */
+    sizes[3] = 2*sizes[2];      /* fit into the last level cache */
+  for (k = 0; k < LVL_CNT-1; k++) /* use half of each cache, */
+    sizes[k] /= 2;              /* so that the set stays resident */
+  srclen = (size_t)sizes[3] /sizeof(REAL);
+  src    = (REAL*)malloc(srclen *sizeof(REAL));
+  if (!src) error(E_NOMEM);     /* generate random data */
+  for (size_t j = 0; j < srclen; j++)
+    src[j] = (REAL)(rand()/((double)RAND_MAX+1));
+
+  /* --- measure the machine peaks --- */
+  flops = peak_flops();         /* single thread flop rate and */
+  for (k = 0; k < LVL_CNT; k++) /* read bandwidth per level */
+    bw[k] = peak_bw((size_t)sizes[k]);
+  printf("peak: %.2f GFLOP/s (%s), bandwidth",
+         flops/1e9, (sizeof(REAL) > 4) ? "double" : "float");
+  for (k = 0; k < LVL_CNT; k++)
+    printf(" %s %.1f", lvlnames[k], bw[k]/1e9);
+  printf(" GB/s\n");            /* print the peaks */
+
+  /* --- run the kernels --- */
+  printf("%-10s %-5s %9s %8s %8s %7s %8s %6s %s\n", "kernel", "level",
+         "set [KiB]", "Gop/s", "GB/s", "op/B", "roof", "%roof", "bound");
+  n = (int)(sizeof(kernels)/sizeof(*kernels));
+  for (i = 0; i < n; i++) {     /* traverse the kernels */
+    for (k = 0; k < LVL_CNT; k++) {   /* and the memory levels */
+      if (!kernels[i].mem && (k > 0)) break;
+      r    = kernels[i].fn((size_t)sizes[k]);
+      rate = r.ops /r.time;     /* run the kernel benchmark */
+      ai   = (r.bytes > 0) ? r.ops /r.bytes : INFINITY;
+      roof = (ai *bw[k] < flops) ? ai *bw[k] : flops;
+      printf("%-10s %-5s %9ld %8.2f %8.2f %7.2f %8.2f %6.1f %s\n",
+             kernels[i].name, (kernels[i].mem) ? lvlnames[k] : "-",
+             sizes[k] >> 10, rate/1e9, r.bytes/r.time/1e9, ai,
+             roof/1e9, 100 *rate/roof,
+             (ai *bw[k] < flops) ? "memory" : "compute");
+      fflush(stdout);           /* print the roofline placement: */
+    }                           /* achieved rates, arithmetic */
+  }                             /* intensity and the bound that */
+  free(src);                    /* the peaks give for it */
+  #ifndef _WIN32
+  fcm_poolexit();               /* stop the shared thread pool */
+  #endif
+  return 0;                     /* return 'ok' */
+}  /* main() */
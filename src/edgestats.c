@@ -7,8 +7,8 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdarg.h>
+#include <string.h>
 #include <time.h>
-#include <pthread.h>
 #include <assert.h>
 #include "cpuinfo.h"
 #include "stats.h"
@@ -35,9 +35,15 @@
 /*----------------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------------*/
-#define THREAD    pthread_t               // use the POSIX thread type
 #define THREAD_OK NULL                    // return value is void*
 
+#define COH_TILE  32                      // nodes per side of a tile
+#define COH_PAD   ((DIM)(64/sizeof(REAL)))// series padded to 64 bytes
+
+#define COH_UNI    0                      // statistics computed from
+#define COH_CORR   1                      // the edge x subject blocks
+#define COH_TSTAT2 2                      // of a cohort
+
 /*----------------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------------*/
@@ -51,7 +57,17 @@ typedef struct {                          // --- thread worker data ---
   int      err;                           // error indicator
 } WORK;
 
-typedef void* WORKER (void*);
+typedef struct {                          // --- cohort task data ---
+  FCMCOHORT *coh;                         // cohort of subjects
+  int      kind;                          // statistic (e.g. COH_UNI)
+  STATFUNC *func;                         // function pointer (COH_UNI)
+  REAL     *var;                          // normalized var. (COH_CORR)
+  int      *perm;                         // subjects ordered by group
+  int      n1;                            // size of group 0 (COH_TSTAT2)
+  MATRIX   *mos;                          // result: matrix of statistics
+  DIM      r;                             // first row of the tile row
+  int      err;                           // error indicator
+} COHWORK;
 
 typedef void (*fn_ptr)(void);             // function pointer
 
@@ -155,7 +171,7 @@ static void* fcm_uni_wrk(void* p)
     for (i = w->s; i < w->e; i++) {       // traverse pairs of nodes
       for (int j = i+1; j < N; j++) {     // (upper triangular matrix)
         for (int k = 0; k < w->n; k++)    // traverse matrices in order to
-          a[k] = fcm_get(w->fcm[k], i, j);// populate tmp array
+          a[k] = fcm_tget(w->fcm[k], i, j);// populate tmp array
         mat_set(w->mos, i, j, (*(w->func))(a, w->n));
       }                                   // comp. statistic for current pair
     }
@@ -195,23 +211,18 @@ static int fcm_uni_multi(FCMAT **fcm, int n, fn_ptr f, MATRIX *mos, int nthd)
   int N = fcm_dim(*fcm);                  // number of nodes
   STATFUNC *func = (STATFUNC*)f;          // statistical function
 
-  // thread handles, data and worker
+  // worker data (one task per strip pair)
   int k = (N/2 +nthd-1) /nthd;            // compute the number of series
-  if (k <= 0) k = 1;                      // to be processed per thread
-  THREAD *threads = malloc((size_t)nthd *sizeof(THREAD));
-  if (!threads) {
-    DBGMSG("ERROR: malloc failed");
-    return -1; }                          // return 'failure'
+  if (k <= 0) k = 1;                      // to be processed per task
   WORK *w = malloc((size_t)nthd *sizeof(WORK));
   if (!w) {
     DBGMSG("ERROR: malloc failed");
-    free(threads);
     return -1; }                          // return 'failure'
-  WORKER *worker = fcm_uni_wrk;
+  FCMTASK *task = fcm_uni_wrk;
 
-  // execute the threads
+  // set up the tasks
   int i;
-  for (i = 0; i < nthd; i++) {            // traverse the threads
+  for (i = 0; i < nthd; i++) {            // traverse the tasks
     w[i].fcm  = fcm;
     w[i].n    = n;
     w[i].mos  = mos;
@@ -222,18 +233,15 @@ static int fcm_uni_multi(FCMAT **fcm, int n, fn_ptr f, MATRIX *mos, int nthd)
     w[i].e    = w[i].s +k;                // compute and store end index
     if (w[i].e >= N/2) w[i].e = N -w[i].s;
     w[i].err  = 0;                        // init error indicator
-    if (pthread_create(threads+i, NULL, worker, w+i)) {
-      DBGMSG("ERROR: could not create thread");
-      w[i].err = -1;                      // create a thread for each strip
-      break; }                            // to comp. the strips in parallel
   }
+
+  // run the tasks in the shared thread pool
+  // (at most nthd at a time, the calling thread is one of them)
+  fcm_poolrun(task, w, sizeof(WORK), i, nthd);
   int r = 0;                              // error status
-  while (--i >= 0) {                      // wait for threads to finish
-    pthread_join(threads[i], NULL);       // join threads with this one
+  while (--i >= 0)                        // traverse the tasks and
     r |= w[i].err;                        // join the error indicators
-  }
 
-  free(threads);
   free(w);
 
   return r;                               // return error status
@@ -294,6 +302,12 @@ int fcm_uni(FCMAT **fcm, int n, STATFUNC *func, MATRIX *mos, int mode, ...)
   DBGMSG("P: %d\n", P);
   assert(P >= 0);
 
+  // limit the threads to the memory budget of the (first) matrix
+  if (P > 0)                              // (per-thread buffers for the
+    P = fcm_memthd(fcm[0], sizeof(WORK)
+                 + (size_t)n *sizeof(REAL) +31, P);
+  DBGMSG("P: %d\n", P);                   // values of all matrices)
+
   // compute statistics
   if      (P >  0)
     return fcm_uni_multi (fcm, n, (fn_ptr)func, mos, P);
@@ -433,7 +447,7 @@ static void* fcm_corr_wrk(void* p)
         // pre-normalize the FC values
         sqr = 0;
         for (int k = 0; k < w->n; k++)
-          b[k] = fcm_get(w->fcm[k], i, j);
+          b[k] = fcm_tget(w->fcm[k], i, j);
         REAL mb = mean(b, w->n);
         for (int k = 0; k < w->n; k++) {
           b[k] -= mb;
@@ -482,23 +496,18 @@ static int fcm_corr_multi(FCMAT **fcm, int n, REAL *v, MATRIX *mos, int nthd)
 
   int N = fcm_dim(*fcm);                  // number of nodes
 
-  // thread handles, data and worker
+  // worker data (one task per strip pair)
   int k = (N/2 +nthd-1) /nthd;            // compute the number of series
-  if (k <= 0) k = 1;                      // to be processed per thread
-  THREAD *threads = malloc((size_t)nthd *sizeof(THREAD));
-  if (!threads) {
-    DBGMSG("ERROR: malloc failed");
-    return -1; }                          // return 'failure'
+  if (k <= 0) k = 1;                      // to be processed per task
   WORK *w = malloc((size_t)nthd *sizeof(WORK));
   if (!w) {
     DBGMSG("ERROR: malloc failed");
-    free(threads);
     return -1; }                          // return 'failure'
-  WORKER *worker = fcm_corr_wrk;
+  FCMTASK *task = fcm_corr_wrk;
 
-  // execute the threads
+  // set up the tasks
   int i;
-  for (i = 0; i < nthd; i++) {            // traverse the threads
+  for (i = 0; i < nthd; i++) {            // traverse the tasks
     w[i].fcm  = fcm;
     w[i].n    = n;
     w[i].mos  = mos;
@@ -509,18 +518,15 @@ static int fcm_corr_multi(FCMAT **fcm, int n, REAL *v, MATRIX *mos, int nthd)
     w[i].e    = w[i].s +k;                // compute and store end index
     if (w[i].e >= N/2) w[i].e = N -w[i].s;
     w[i].err  = 0;                        // init error indicator
-    if (pthread_create(threads+i, NULL, worker, w+i)) {
-      DBGMSG("ERROR: could not create thread");
-      w[i].err = -1;                      // create a thread for each strip
-      break; }                            // to comp. the strips in parallel
   }
+
+  // run the tasks in the shared thread pool
+  // (at most nthd at a time, the calling thread is one of them)
+  fcm_poolrun(task, w, sizeof(WORK), i, nthd);
   int r = 0;                              // error status
-  while (--i >= 0) {                      // wait for threads to finish
-    pthread_join(threads[i], NULL);       // join threads with this one
+  while (--i >= 0)                        // traverse the tasks and
     r |= w[i].err;                        // join the error indicators
-  }
 
-  free(threads);
   free(w);
 
   return r;                               // return error status
@@ -581,6 +587,12 @@ int fcm_corr(FCMAT **fcm, int n, REAL *v, MATRIX *mos, int mode, ...)
   DBGMSG("P: %d\n", P);
   assert(P >= 0);
 
+  // limit the threads to the memory budget of the (first) matrix
+  if (P > 0)                              // (per-thread buffers for the
+    P = fcm_memthd(fcm[0], sizeof(WORK)
+                 + 2*((size_t)n *sizeof(REAL) +31), P);
+  DBGMSG("P: %d\n", P);                   // values of all matrices)
+
   // compute correlation coefficients
   if      (P >  0)
     return fcm_corr_multi (fcm, n, v, mos, P);
@@ -729,9 +741,9 @@ static void* fcm_tstat2_wrk(void* p)
     for (i = w->s; i < w->e; i++) {       // traverse row indices
       for (int j = i+1; j < N; j++) {     // traverse column indices
         for (int k = 0; k < n1; k++)      // traverse samples in order to
-          tmp1[k] = fcm_get(fcm1[k], i, j);
+          tmp1[k] = fcm_tget(fcm1[k], i, j);
         for (int k = 0; k < n2; k++)      // populate temp. arrays
-          tmp2[k] = fcm_get(fcm2[k], i, j);
+          tmp2[k] = fcm_tget(fcm2[k], i, j);
         mat_set(w->mos, i, j, tstat2(tmp1, tmp2, n1, n2));
       }                                   // compute t statistic
     }
@@ -773,23 +785,18 @@ static int fcm_tstat2_multi(FCMAT **fcm, int n, int *g, MATRIX *mos, int nthd)
 
   int    N = fcm_dim(*fcm);               // number of nodes
 
-  // thread handles, data and worker
+  // worker data (one task per strip pair)
   int k = (N/2 +nthd-1) /nthd;            // compute the number of series
-  if (k <= 0) k = 1;                      // to be processed per thread
-  THREAD *threads = malloc((size_t)nthd *sizeof(THREAD));
-  if (!threads) {
-    DBGMSG("ERROR: malloc failed");
-    return -1; }                          // return 'failure'
+  if (k <= 0) k = 1;                      // to be processed per task
   WORK *w = malloc((size_t)nthd *sizeof(WORK));
   if (!w) {
     DBGMSG("ERROR: malloc failed");
-    free(threads);
     return -1; }                          // return 'failure'
-  WORKER *worker = fcm_tstat2_wrk;
+  FCMTASK *task = fcm_tstat2_wrk;
 
-  // execute the threads
+  // set up the tasks
   int i;
-  for (i = 0; i < nthd; i++) {            // traverse the threads
+  for (i = 0; i < nthd; i++) {            // traverse the tasks
     w[i].fcm  = fcm;
     w[i].n    = n;
     w[i].mos  = mos;
@@ -800,18 +807,15 @@ static int fcm_tstat2_multi(FCMAT **fcm, int n, int *g, MATRIX *mos, int nthd)
     w[i].e    = w[i].s +k;                // compute and store end index
     if (w[i].e >= N/2) w[i].e = N -w[i].s;
     w[i].err  = 0;                        // init error indicator
-    if (pthread_create(threads+i, NULL, worker, w+i)) {
-      DBGMSG("ERROR: could not create thread");
-      w[i].err = -1;                      // create a thread for each strip
-      break; }                            // to comp. the strips in parallel
   }
+
+  // run the tasks in the shared thread pool
+  // (at most nthd at a time, the calling thread is one of them)
+  fcm_poolrun(task, w, sizeof(WORK), i, nthd);
   int r = 0;                              // error status
-  while (--i >= 0) {                      // wait for threads to finish
-    pthread_join(threads[i], NULL);       // join threads with this one
+  while (--i >= 0)                        // traverse the tasks and
     r |= w[i].err;                        // join the error indicators
-  }
 
-  free(threads);
   free(w);
 
   return r;                               // return error status
@@ -873,6 +877,12 @@ int fcm_tstat2(FCMAT **fcm, int n, int *g, MATRIX *mos, int mode, ...)
   DBGMSG("P: %d\n", P);
   assert(P >= 0);
 
+  // limit the threads to the memory budget of the (first) matrix
+  if (P > 0)                              // (per-thread buffers for the
+    P = fcm_memthd(fcm[0], sizeof(WORK)
+                 + (size_t)n *(sizeof(FCMAT*) +sizeof(REAL)) +62, P);
+  DBGMSG("P: %d\n", P);                   // values of all matrices)
+
   // compute t statistics
   if      (P >  0)
     return fcm_tstat2_multi (fcm, n, g, mos, P);
@@ -881,3 +891,432 @@ int fcm_tstat2(FCMAT **fcm, int n, int *g, MATRIX *mos, int mode, ...)
   else
     return -1;
 }  // fcm_tstat2()
+
+/*----------------------------------------------------------------------------
+  Cohort Functions
+----------------------------------------------------------------------------*/
+// The series of all subjects are normalized (mean 0, norm 1) into one
+// aligned arena (subject by subject, each series padded to 64 bytes), so
+// that a correlation coefficient is a single dot product. The statistics
+// traverse the upper triangle in tiles of COH_TILE x COH_TILE nodes (one
+// task per row of tiles). For each tile the coefficients of all subjects
+// are computed into an edge x subject block, in which the values of an
+// edge are contiguous, and the statistic is computed directly from it.
+// The series of a tile (2*COH_TILE per subject) stay in the cache while
+// the coefficients of a subject are computed.
+
+/* coh_memreq
+ * ----------
+ * estimate the memory needed by a cohort (in bytes)
+ *
+ * parameters
+ * coh   cohort of subjects (n, V and X must have been set)
+ * nthd  number of threads (0: single-threaded version)
+ *
+ * returns
+ * arena, base structure, task data and the blocks of the running tasks
+ */
+static double coh_memreq(FCMCOHORT *coh, int nthd)
+{
+  assert(coh);
+
+  size_t n = (size_t)coh->n;              // number of subjects
+  size_t t = ((size_t)coh->V +COH_TILE-1) /COH_TILE;
+  size_t z = sizeof(FCMCOHORT)            // base structure and
+           + n *(size_t)coh->V *(size_t)coh->X *sizeof(REAL) +63
+           + t *sizeof(COHWORK)           // arena, task data and the
+           + n *(sizeof(REAL) +sizeof(int));  // var. or the permutation
+  size_t b = (n +(size_t)COH_TILE *COH_TILE *n) *sizeof(REAL) +31;
+  return (double)z +(double)((nthd > 0) ? nthd : 1) *(double)b;
+}  // coh_memreq()                        // (one block per running task)
+
+/*--------------------------------------------------------------------------*/
+
+/* fcm_cohort
+ * ----------
+ * create a cohort: the normalized time series of all subjects in one arena
+ *
+ * mandatory parameters
+ * data  data: array of n data arrays (V series of T values each)
+ * n     number of subjects
+ * V     number of nodes
+ * T     number of time points
+ * mode  contains bit flags
+ *         FCM_PCC     Pearson correlation (the only supported variant)
+ *         FCM_THREAD  set number of threads (optional parameter #1)
+ *         FCM_MAXMEM  set memory limit (optional parameter #2)
+ *         FCM_XFORM   transform stage (as for fcm_create)
+ *
+ * optional parameters
+ * #1    number of threads
+ *         -1          auto-determine
+ *          0          use single-threaded version
+ *          1-p        use multi-threaded version with p threads
+ * #2    memory limit in GiB (FCM_MAXMEM, < 0: FCM_MEMDEF)
+ * #3    bound for clamping (FCM_CLAMP)
+ * #4    threshold for binarization (FCM_BIN)
+ *
+ * returns
+ * the created cohort or NULL on failure
+ */
+FCMCOHORT* fcm_cohort(REAL **data, int n, DIM V, DIM T, int mode, ...)
+{
+  assert(data && (n > 0) && (V > 1) && (T > 1));
+
+  if ((mode & FCM_CORR) != FCM_PCC) {     // check the correlation type
+    fprintf(stderr, "fcm_cohort: only Pearson correlation "
+                    "is supported\n");
+    return NULL;                          // (tetrachoric correlation has
+  }                                       // no dot product form)
+  FCMCOHORT *coh = malloc(sizeof(FCMCOHORT));
+  if (!coh) {
+    DBGMSG("ERROR: malloc failed");
+    return NULL; }                        // return 'failure'
+  memset(coh, 0, sizeof(FCMCOHORT));
+  coh->n    = n;                          // note the number of subjects,
+  coh->V    = V;                          // of nodes and of time points
+  coh->T    = T;                          // and pad the series
+  coh->X    = (T +COH_PAD-1) /COH_PAD *COH_PAD;
+  coh->nthd = -1;                         // default: auto-determine
+  coh->xf.mode   = mode & FCM_XFORM;      // set up the transform stage
+  coh->xf.clamp  = 1;                     // (default: no clamping and
+  coh->xf.thresh = 0;                     // binarization at zero)
+  coh->xf.isa    = fcm_isa();             // (kernels as for a matrix)
+  double maxmem  = -1;                    // default: FCM_MEMDEF
+
+  // get optional input
+  va_list args;
+  va_start(args, mode);
+  if (mode & FCM_THREAD)                  // number of threads
+    coh->nthd = va_arg(args, int);
+  if (mode & FCM_CACHE)                   // skip the tile size
+    va_arg(args, DIM);                    // (not used by a cohort)
+  if (mode & FCM_MAXMEM)                  // memory limit (in GiB)
+    maxmem = va_arg(args, double);
+  if (mode & FCM_DISK)                    // skip the store directory
+    va_arg(args, const char*);
+  if (mode & FCM_SLOTS)                   // and the tile slots
+    va_arg(args, int);
+  if (mode & FCM_CLAMP)                   // bound for clamping
+    coh->xf.clamp  = (REAL)va_arg(args, double);
+  if (mode & FCM_BIN)                     // threshold for binarization
+    coh->xf.thresh = (REAL)va_arg(args, double);
+  va_end(args);
+  DBGMSG("P: %d\n", coh->nthd);
+  assert((coh->nthd == -1) || (coh->nthd >= 0));
+
+  // auto-determine number of threads
+  if (coh->nthd == -1) {
+    int nprocs = proccnt();
+    coh->nthd = (nprocs > 1) ? nprocs : 0;
+  }
+
+  // memory limit (the arena and the blocks of the tasks must fit)
+  if (maxmem < 0)                         // if auto-determine,
+    maxmem = FCM_MEMDEF;                  // use the default limit
+  maxmem *= 1024.0*1024.0*1024.0;         // (as for fcm_create)
+  if (coh_memreq(coh, 0) > maxmem) {      // if even a single task
+    fprintf(stderr, "fcm_cohort: the series of %d subjects "
+                    "exceed the memory limit\n", n);
+    free(coh);                            // does not fit,
+    return NULL;                          // return 'failure'
+  }
+  if (coh_memreq(coh, coh->nthd) > maxmem) {
+    while (coh_memreq(coh, coh->nthd) > maxmem)
+      coh->nthd--;                        // reduce the number of threads
+    WARNING("coh->nthd has been set to %d to enforce the specified "
+            "memory limit.\n", coh->nthd);
+  }
+
+  // allocate the arena (aligned) for the series of all subjects
+  size_t z = (size_t)n *(size_t)V *(size_t)coh->X;
+  coh->mem = malloc(z *sizeof(REAL) +63);
+  if (!coh->mem) {
+    DBGMSG("ERROR: malloc failed");
+    free(coh);
+    return NULL; }                        // return 'failure'
+  coh->data = (REAL*)(((uintptr_t)coh->mem +63) & ~(uintptr_t)63);
+
+  // normalize the series (in double precision)
+  for (int k = 0; k < n; k++) {           // traverse the subjects
+    for (DIM i = 0; i < V; i++) {         // and their series
+      const REAL *x = data[k] +(size_t)i *(size_t)T;
+      REAL *y = coh->data +((size_t)k *(size_t)V +(size_t)i)
+                          * (size_t)coh->X;
+      double m = 0, q = 0;                // mean and sum of squares
+      for (DIM t = 0; t < T; t++)
+        m += (double)x[t];
+      m /= (double)T;
+      for (DIM t = 0; t < T; t++)
+        q += ((double)x[t] -m) *((double)x[t] -m);
+      q = (q > 0) ? 1/sqrt(q) : 0;
+      for (DIM t = 0; t < T; t++)         // center and scale the series
+        y[t] = (REAL)(((double)x[t] -m) *q);
+      for (DIM t = T; t < coh->X; t++)    // clear the padding
+        y[t] = 0;
+    }
+  }
+
+  return coh;                             // return the created cohort
+}  // fcm_cohort()
+
+/*--------------------------------------------------------------------------*/
+
+/* fcm_cohdel
+ * ----------
+ * delete a cohort
+ *
+ * parameters
+ * coh   cohort to delete
+ */
+void fcm_cohdel(FCMCOHORT *coh)
+{
+  assert(coh);
+  free(coh->mem);                         // delete the arena
+  free(coh);                              // and the base structure
+}  // fcm_cohdel()
+
+/*--------------------------------------------------------------------------*/
+
+/* coh_wrk
+ * -------
+ * worker function for coh_run (processes one row of tiles)
+ *
+ * parameters
+ * p     pointer to the data
+ *
+ * returns
+ * THREAD_OK
+ */
+static void* coh_wrk(void* p)
+{
+  assert(p);
+
+  COHWORK   *w   = p;
+  FCMCOHORT *coh = w->coh;
+  int       n    = coh->n;                // number of subjects
+  DIM       V    = coh->V;                // number of nodes
+  DIM       X    = coh->X;                // padded length of a series
+  DIM       rb   = (w->r +COH_TILE < V) ? w->r +COH_TILE : V;
+
+  // allocate aligned memory for a temp. array and an edge x subject block
+  size_t z = (size_t)COH_TILE *COH_TILE *(size_t)n;
+  void *mem = malloc(((size_t)n +z) *sizeof(REAL) +31);
+  if (!mem) {
+    DBGMSG("ERROR: malloc failed");
+    w->err = -1;                          // set error indicator
+    return THREAD_OK; }                   // return a dummy result
+  REAL *b   = (REAL*)(((uintptr_t)mem +31) & ~(uintptr_t)31);
+  REAL *blk = b +n;
+
+  for (DIM ca = w->r; ca < V; ca += COH_TILE) {
+    DIM cb = (ca +COH_TILE < V) ? ca +COH_TILE : V;
+
+    // compute the correlation coefficients of all subjects
+    size_t m = 0;                         // number of edges of the tile
+    for (int k = 0; k < n; k++) {         // traverse the subjects
+      int  s = (w->perm) ? w->perm[k] : k;
+      const REAL *x = coh->data +(size_t)s *(size_t)V *(size_t)X;
+      REAL *e = blk +k;                   // (values of an edge are
+      for (DIM i = w->r; i < rb; i++)     //  contiguous in the block)
+        for (DIM j = (ca > i+1) ? ca : i+1; j < cb; j++, e += n)
+          *e = dot(x +(size_t)i *(size_t)X, x +(size_t)j *(size_t)X,
+                   (int)X);
+      m = (size_t)(e -blk -k) /(size_t)n;
+    }
+    if (m == 0) continue;                 // skip tiles without edges
+    for (size_t l = 0; l < m *(size_t)n; l++)
+      blk[l] = (blk[l] > 1) ? 1 : (blk[l] < -1) ? -1 : blk[l];
+    if (coh->xf.mode & FCM_XFORM)         // clamp the coefficients and
+      fcm_xfvec(&coh->xf, blk, m *(size_t)n);  // apply the transform
+
+    // compute the statistics from the block
+    REAL *e = blk;                        // traverse the edges
+    for (DIM i = w->r; i < rb; i++) {
+      for (DIM j = (ca > i+1) ? ca : i+1; j < cb; j++, e += n) {
+        REAL v;                           // statistic of the edge
+        if      (w->kind == COH_UNI)
+          v = (*(w->func))(e, n);
+        else if (w->kind == COH_CORR) {   // pre-normalize the FC values
+          REAL sqr = 0;
+          for (int k = 0; k < n; k++)
+            b[k] = e[k];
+          REAL mb = mean(b, n);
+          for (int k = 0; k < n; k++) {
+            b[k] -= mb;
+            sqr += b[k]*b[k]; }
+          sqr = (REAL)sqrt(sqr);
+          sqr = (sqr > 0) ? 1/sqr : 0;
+          for (int k = 0; k < n; k++)
+            b[k] *= sqr;
+          v = dot(w->var, b, n); }
+        else                              // (groups are consecutive)
+          v = tstat2(e, e +w->n1, w->n1, n -w->n1);
+        mat_set(w->mos, i, j, v);
+      }
+    }
+  }
+
+  free(mem);
+
+  return THREAD_OK;                       // return a dummy result
+}  // coh_wrk()
+
+/*--------------------------------------------------------------------------*/
+
+/* coh_run
+ * -------
+ * compute a statistic across a cohort (one task per row of tiles)
+ *
+ * parameters
+ * coh   cohort of subjects
+ * w     task data template (statistic and its parameters)
+ *
+ * returns
+ * 0 on success
+ */
+static int coh_run(FCMCOHORT *coh, COHWORK *w)
+{
+  assert(coh && w);
+
+  int nt = (int)((coh->V +COH_TILE-1) /COH_TILE);
+  COHWORK *t = malloc((size_t)nt *sizeof(COHWORK));
+  if (!t) {
+    DBGMSG("ERROR: malloc failed");
+    return -1; }                          // return 'failure'
+
+  // set up the tasks
+  for (int i = 0; i < nt; i++) {          // traverse the rows of tiles
+    t[i]     = *w;                        // (the first rows have the
+    t[i].r   = (DIM)i *COH_TILE;          // most tiles and are started
+    t[i].err = 0;                         // first by the pool)
+  }
+
+  // run the tasks in the shared thread pool
+  // (at most nthd at a time, the calling thread is one of them)
+  if (coh->nthd > 0)
+    fcm_poolrun(coh_wrk, t, sizeof(COHWORK), nt, coh->nthd);
+  else                                    // single-threaded version
+    for (int i = 0; i < nt; i++)
+      coh_wrk(t+i);
+  int r = 0;                              // error status
+  for (int i = 0; i < nt; i++)            // traverse the tasks and
+    r |= t[i].err;                        // join the error indicators
+
+  free(t);
+
+  return r;                               // return error status
+}  // coh_run()
+
+/*--------------------------------------------------------------------------*/
+
+/* fcm_cohuni
+ * ----------
+ * comp. descriptive statistics for univariate data across a cohort
+ *
+ * parameters
+ * coh   cohort of subjects
+ * func  function pointer
+ * mos   result: matrix of statistics
+ *
+ * returns
+ * 0 on success
+ */
+int fcm_cohuni(FCMCOHORT *coh, STATFUNC *func, MATRIX *mos)
+{
+  assert(coh && func && mos);
+
+  COHWORK w = { coh, COH_UNI, func, NULL, NULL, 0, mos, 0, 0 };
+  return coh_run(coh, &w);                // compute statistics
+}  // fcm_cohuni()
+
+/*--------------------------------------------------------------------------*/
+
+/* fcm_cohcorr
+ * -----------
+ * compute correlation coefficients across a cohort
+ *
+ * parameters
+ * coh   cohort of subjects
+ * v     additional variable (one value per subject)
+ * mos   result: matrix of correlation coefficients
+ *
+ * returns
+ * 0 on success
+ */
+int fcm_cohcorr(FCMCOHORT *coh, REAL *v, MATRIX *mos)
+{
+  assert(coh && v && mos);
+
+  int n = coh->n;                         // number of subjects
+
+  // allocate (aligned) memory for the pre-normalized values (add. variable)
+  void *mem = malloc((size_t)n *sizeof(REAL) +31);
+  if (!mem) {
+    DBGMSG("ERROR: malloc failed");
+    return -1; }                          // return 'failure'
+  REAL *a = (REAL*)(((uintptr_t)mem +31) & ~(uintptr_t)31);
+
+  // pre-normalize the add. variable
+  REAL sqr = 0;
+  REAL ma = mean(v, n);
+  for (int k = 0; k < n; k++) {
+    a[k] = v[k] - ma;
+    sqr += a[k]*a[k]; }
+  sqr = (REAL)sqrt(sqr);
+  sqr = (sqr > 0) ? 1/sqr : 0;
+  for (int k = 0; k < n; k++)
+    a[k] *= sqr;
+
+  // compute correlation coefficients
+  COHWORK w = { coh, COH_CORR, NULL, a, NULL, 0, mos, 0, 0 };
+  int r = coh_run(coh, &w);
+
+  free(mem);
+
+  return r;                               // return error status
+}  // fcm_cohcorr()
+
+/*--------------------------------------------------------------------------*/
+
+/* fcm_cohtstat2
+ * -------------
+ * compute t statistics across a cohort
+ *
+ * parameters
+ * coh   cohort of subjects (representing two independent samples)
+ * g     binary vector of length n indicating sample membership:
+ *       0 -> sample #1;  1 -> sample #2
+ * mos   result: matrix of t statistics
+ *
+ * returns
+ * 0 on success
+ */
+int fcm_cohtstat2(FCMCOHORT *coh, int *g, MATRIX *mos)
+{
+  assert(coh && g && mos);
+
+  int n = coh->n;                         // number of subjects
+
+  // order the subjects by sample membership
+  // (so that the values of a sample are consecutive in the blocks)
+  int *perm = malloc((size_t)n *sizeof(int));
+  if (!perm) {
+    DBGMSG("ERROR: malloc failed");
+    return -1; }                          // return 'failure'
+  int n1 = 0;
+  for (int k = 0; k < n; k++)             // collect sample #1
+    if (g[k] == 0) perm[n1++] = k;
+  int n2 = n1;
+  for (int k = 0; k < n; k++)             // collect sample #2
+    if (g[k] != 0) perm[n2++] = k;
+  assert(n2 == n);
+
+  // compute t statistics
+  COHWORK w = { coh, COH_TSTAT2, NULL, NULL, perm, n1, mos, 0, 0 };
+  int r = coh_run(coh, &w);
+
+  free(perm);
+
+  return r;                               // return error status
+}  // fcm_cohtstat2()
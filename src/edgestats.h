@@ -14,6 +14,17 @@
 ----------------------------------------------------------------------------*/
 typedef REAL STATFUNC (REAL* array, int len);
 
+typedef struct {                /* --- a cohort of subjects --- */
+  int    n;                     /* number of subjects */
+  DIM    V;                     /* number of nodes */
+  DIM    T;                     /* number of time points */
+  DIM    X;                     /* padded length of a series */
+  int    nthd;                  /* number of threads */
+  REAL   *data;                 /* normalized series of all subjects */
+  void   *mem;                  /* allocated arena (aligned data) */
+  FCMXF  xf;                    /* parameters of the transform stage */
+} FCMCOHORT;
+
 /*----------------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------------*/
@@ -91,4 +102,75 @@ extern int fcm_corr (FCMAT **fcm, int n, REAL *v, MATRIX *mos, int mode, ...);
  */
 extern int fcm_tstat2(FCMAT **fcm, int n, int *g, MATRIX *mos, int mode, ...);
 
+/* fcm_cohort
+ * ----------
+ * create a cohort: the normalized time series of all subjects in one arena
+ *
+ * mandatory parameters
+ * data  data: array of n data arrays (V series of T values each)
+ * n     number of subjects
+ * V     number of nodes
+ * T     number of time points
+ * mode  contains bit flags
+ *       FCM_PCC    -> Pearson correlation (the only supported variant)
+ *       FCM_THREAD -> set number of threads (optional parameter 'nthd')
+ *       FCM_MAXMEM -> set memory limit (optional parameter 'maxmem')
+ *       FCM_ABS, FCM_CLAMP, FCM_R2Z, FCM_BIN -> transform stage
+ *                     (as for fcm_create, FCM_CLAMP/FCM_BIN need a bound)
+ *
+ * optional parameters (in this order, other parameters of fcm_create
+ * are skipped)
+ * #1    number of threads
+ *         -1          auto-determine
+ *          0          use single-threaded version
+ *          1-p        use multi-threaded version with p threads
+ * #2    memory limit in GiB (< 0: FCM_MEMDEF; the arena and the blocks
+ *       of the running tasks must fit, otherwise fewer threads are used
+ *       or the cohort is not created)
+ * #3    bound for clamping
+ * #4    threshold for binarization
+ *
+ * returns
+ * the created cohort or NULL on failure
+ *
+ * The statistics functions fcm_cohuni, fcm_cohcorr and fcm_cohtstat2
+ * agree with fcm_uni, fcm_corr and fcm_tstat2 for a set of matrices
+ * created with fcm_create from the same data and mode only within a
+ * tolerance: the series are normalized in double precision, so the
+ * coefficients may differ in the last bits (which a binarization may
+ * turn into a full step for coefficients close to the threshold).
+ * The correlations are computed tile by tile as an edge x subject block
+ * that is consumed directly by the statistic (no matrix per subject).
+ */
+extern FCMCOHORT* fcm_cohort (REAL **data, int n, DIM V, DIM T,
+                              int mode, ...);
+
+/* fcm_cohdel
+ * ----------
+ * delete a cohort
+ */
+extern void fcm_cohdel (FCMCOHORT *coh);
+
+/* fcm_cohuni
+ * ----------
+ * comp. descriptive statistics for univariate data across a cohort
+ * (see fcm_uni; returns 0 on success)
+ */
+extern int fcm_cohuni (FCMCOHORT *coh, STATFUNC *func, MATRIX *mos);
+
+/* fcm_cohcorr
+ * -----------
+ * compute correlation coefficients across a cohort
+ * (see fcm_corr; v has one value per subject; returns 0 on success)
+ */
+extern int fcm_cohcorr (FCMCOHORT *coh, REAL *v, MATRIX *mos);
+
+/* fcm_cohtstat2
+ * -------------
+ * compute t statistics across a cohort
+ * (see fcm_tstat2; g has one group (0 or 1) per subject;
+ *  returns 0 on success)
+ */
+extern int fcm_cohtstat2 (FCMCOHORT *coh, int *g, MATRIX *mos);
+
 #endif  /* #ifndef EDGESTATS_H */
@@ -5,14 +5,18 @@
 ----------------------------------------------------------------------*/
 #ifndef _WIN32                  /* if Linux/Unix system */
 #define _POSIX_C_SOURCE 200809L /* needed for clock_gettime() */
+#define _FILE_OFFSET_BITS 64    /* out-of-core stores exceed 2 GiB */
 #endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <stdarg.h>
+#include <limits.h>
 #include <time.h>
 #include <assert.h>
 #include <math.h>
+#include <errno.h>
 
 #ifdef __SSE2__
 #include <emmintrin.h>
@@ -79,29 +83,776 @@
   Function Prototypes (on-demand functions defined in fcmat1.h)
 ----------------------------------------------------------------------*/
 extern REAL fcm_pccotf (FCMAT *fcm, DIM row, DIM col);
-extern REAL fcm_pccr2z (FCMAT *fcm, DIM row, DIM col);
+extern REAL fcm_pccxf  (FCMAT *fcm, DIM row, DIM col);
 extern REAL fcm_tccotf (FCMAT *fcm, DIM row, DIM col);
-extern REAL fcm_tccr2z (FCMAT *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_isa)    (void);
+extern int  SFXNAME(fcm_blksz)  (SFXNAME(FCMAT) *fcm);
+extern size_t SFXNAME(fcm_datasz) (SFXNAME(FCMAT) *fcm);
+extern int  SFXNAME(fcm_prep)   (SFXNAME(FCMAT) *fcm, REAL *data);
+extern REAL SFXNAME(fcm_xval)   (SFXNAME(FCMAT) *fcm, REAL r);
+extern int  SFXNAME(fcm_winprep) (SFXNAME(FCMAT) *fcm, REAL *data);
+extern void SFXNAME(fcm_wincc)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                 DIM k, DIM n, double *sum, REAL *r);
+extern REAL SFXNAME(fcm_pccwin) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 
 /*----------------------------------------------------------------------
   Function Prototypes (cache-based functions defined in fcmat2.h)
 ----------------------------------------------------------------------*/
 extern REAL SFXNAME(pcc_pure)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(pcc_r2z)   (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(pcc_xf)    (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 extern REAL SFXNAME(tcc_pure)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(tcc_r2z)   (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(pcc_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+extern void SFXNAME(tcc_run)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb, int raw);
+extern void SFXNAME(tcc_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+extern void SFXNAME(win_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+extern void SFXNAME(tcc_cnt)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern void SFXNAME(rec_rct)   (SFXNAME(WORK) *w,
                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern void SFXNAME(rec_trg)   (SFXNAME(WORK) *w, DIM a, DIM b);
+extern void SFXNAME(rec_dyn)   (SFXNAME(WORK) *w);
+extern DIM  SFXNAME(fcm_subs)  (SFXNAME(FCMAT) *fcm, int shape,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern WORKERDEF(fill, p);
+#ifndef _WIN32
+extern WORKERDEF(spin, p);
+extern int  SFXNAME(fcm_start) (SFXNAME(FCMAT) *fcm);
+extern void SFXNAME(fcm_stop)  (SFXNAME(FCMAT) *fcm);
+#endif
+extern int  SFXNAME(fcm_post)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_wait)  (SFXNAME(FCMAT) *fcm);
 extern int  SFXNAME(fcm_fill)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 extern REAL SFXNAME(fcm_cache) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_pipe)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_slots) (SFXNAME(FCMAT) *fcm, int k);
+extern int  SFXNAME(fcm_slot)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                SFXNAME(FCMFILLFN) *fillfn);
 
 /*----------------------------------------------------------------------
   Function Prototypes (half-stored functions defined in fcmat3.h)
 ----------------------------------------------------------------------*/
 extern REAL SFXNAME(fcm_full)     (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_full_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_xf)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_f16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#if defined FCM_ALL_ISA || defined __F16C__
+extern REAL SFXNAME(fcm_full_f16c)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#endif
+extern REAL SFXNAME(fcm_full_bf16)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n8)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n32) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(fcm_enc16)    (SFXNAME(FCMAT) *fcm, uint16_t *dst,
+                                   const REAL *src, size_t n);
+extern int  SFXNAME(fcm_save)     (SFXNAME(FCMAT) *fcm, const char *fname);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_open)     (const char *fname);
+extern void SFXNAME(fcm_unmap)    (SFXNAME(FCMAT) *fcm);
+extern REAL SFXNAME(fcm_onl)      (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void*SFXNAME(fcm_onlrows)  (void *p);
+extern void SFXNAME(fcm_onlupd)   (SFXNAME(FCMAT) *fcm, double w);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_online)   (REAL *data, DIM V, DIM T, int mode, ...);
+extern int  SFXNAME(fcm_append)   (SFXNAME(FCMAT) *fcm, const REAL *vol);
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#ifndef HALF_TILE
+#define HALF_TILE   1024        /* tile size for filling a triangle */
+#endif                          /* that is stored with 8 or 16 bits */
+#ifndef DISK_TILE
+#define DISK_TILE   1024        /* tile size of an out-of-core store */
+#endif
+#ifndef DISK_AHEAD
+#define DISK_AHEAD  4           /* number of tiles to read ahead */
+#endif
+#define DISK_PATH   1024        /* max. length of the store path */
+#ifndef XF_CHUNK
+#define XF_CHUNK    65536       /* elements per post-pass task */
+#endif
+#define PIPED(f)    ((((f)->mode & (FCM_PIPE|FCM_JOIN)) == FCM_PIPE) \
+                  && ((f)->slot.cnt <= 1) && ((f)->fd < 0))
+                                /* whether the next tile of */
+                                /* a traversal is filled ahead */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- post-pass task data --- */
+  SFXNAME(FCMAT) *fcm;          /* matrix with transform parameters */
+  REAL   *v;                    /* part of the triangle to transform */
+  size_t n;                     /* number of elements in the part */
+} SFXNAME(XFTASK);              /* (see fcm_xfall()) */
+
+/*----------------------------------------------------------------------
+  Memory Functions
+----------------------------------------------------------------------*/
+
+static size_t SFXNAME(fcm_elsz) (SFXNAME(FCMAT) *fcm)
+{                               /* --- size of a half-stored element */
+  if ((fcm->mode & FCM_CORR) == FCM_TCC) {
+    if (fcm->T < 256)           /* tetrachoric: numbers of 11 configs. */
+      return sizeof(uint8_t);   /* (at most T, so 8 bits suffice */
+    if (fcm->T < 65536)         /* for fewer than 256 scans and */
+      return sizeof(uint16_t);  /* 16 bits for fewer than 65536) */
+    return sizeof(uint32_t);    /* more scans: 32 bit counts */
+  }
+  if (fcm->mode & FCM_HALF)     /* fp16/bf16: 16 bit floats */
+    return sizeof(uint16_t);
+  return sizeof(REAL);          /* otherwise: full precision */
+}  /* fcm_elsz() */
+
+/*--------------------------------------------------------------------*/
+
+static int SFXNAME(fcm_packed) (SFXNAME(FCMAT) *fcm)
+{                               /* --- check for packed elements */
+  return ((fcm->mode & FCM_CORR) == FCM_TCC)
+      || ((fcm->mode & FCM_HALF) != 0);
+}  /* fcm_packed() */           /* (counts or 16 bit floats, which */
+                                /* need not be smaller than a REAL) */
+
+/*--------------------------------------------------------------------*/
+
+static double SFXNAME(fcm_memreq) (SFXNAME(FCMAT) *fcm, DIM tile)
+{                               /* --- estimate memory for a tile size */
+  size_t z, d;                  /* memory for structure and data */
+  double e;                     /* number of elements of triangle */
+
+  z = sizeof(SFXNAME(FCMAT));   /* base structure and prepared data */
+  d = SFXNAME(fcm_datasz)(fcm); /* (fcm_blksz() must have been called) */
+  if ((fcm->mode & FCM_CORR) == FCM_TCC)
+    d += (size_t)(fcm->T+1) *sizeof(REAL);
+  e = (double)fcm->V *(double)(fcm->V-1)/2;
+  if ((tile >= fcm->V)          /* if half-stored and tiled: */
+  &&  (fcm->mode & FCM_TILED)) {/* tiles (with padding), offsets */
+    e  = (double)tri_size(fcm->V);  /* and a buffer for tiling */
+    z += ((size_t)fcm->V +TRI_MASK) /TRI_BLK *sizeof(size_t);
+    if (!SFXNAME(fcm_packed)(fcm))
+      z += (size_t)TRI_BLK *(size_t)fcm->V *sizeof(REAL);
+  }                             /* (a triangle of REALs is tiled */
+  if ((tile >= fcm->V)          /* after pccx(), see tri_tile()) */
+  &&  !SFXNAME(fcm_packed)(fcm))
+    return (double)z +(double)d +e *(double)sizeof(REAL);
+  z += d;                       /* and the data prepared temporarily */
+  if (tile >= fcm->V) {         /* by pccx(); if packed elements: */
+    z   += (size_t)fcm->nthd *(sizeof(THREAD) +sizeof(SFXNAME(WORK))
+                              +sizeof(FCMSTATS));
+    tile = (fcm->V < HALF_TILE) ? fcm->V : HALF_TILE;
+    z   += (size_t)tile *(size_t)tile *sizeof(REAL);
+    return (double)z +e *(double)SFXNAME(fcm_elsz)(fcm);
+  }                             /* the triangle is filled tile by */
+                                /* tile with the cache kernels */
+  if (tile > 0)                 /* cache-based: tile cache, */
+    z += (size_t)tile *(size_t)tile *sizeof(REAL)
+      *  (size_t)(fcm->slot.cnt +(PIPED(fcm) ? 1 : 0))
+      +  (size_t)fcm->nthd *(sizeof(THREAD) +sizeof(SFXNAME(WORK))
+                            +sizeof(FCMSTATS));
+  if ((tile > 0) && (fcm->slot.cnt > 1))
+    z += slot_memsz(fcm->slot.cnt); /* slot management */
+  return (double)z;             /* thread handles and worker data */
+}  /* fcm_memreq() */
+
+/*--------------------------------------------------------------------*/
+
+static int SFXNAME(fcm_work) (SFXNAME(FCMAT) *fcm)
+{                               /* --- set up tile cache and workers */
+  SFXNAME(FCMGETFN) *get;       /* element computation function */
+  SFXNAME(WORK)     *w;         /* to initialize the worker data */
+  int    i;                     /* loop variable for threads */
+  int    corr;                  /* correlation type */
+  size_t z;                     /* cache size */
+
+  z = (size_t)fcm->tile *(size_t)fcm->tile;
+  fcm->cache    = (REAL*)  malloc(z *sizeof(REAL));
+  fcm->threads  = (THREAD*)malloc((size_t)fcm->nthd *sizeof(THREAD));
+  fcm->work = w = malloc((size_t)fcm->nthd *sizeof(SFXNAME(WORK)));
+  if (!fcm->tst)                /* (thread statistics are kept) */
+    fcm->tst = (FCMSTATS*)calloc((size_t)fcm->nthd, sizeof(FCMSTATS));
+  if (!fcm->cache || !fcm->threads || !fcm->work || !fcm->tst)
+    return -1;                  /* allocate cache and worker data */
+  fcm->use.cache  = z *sizeof(REAL);
+  fcm->use.thread = (size_t)fcm->nthd
+                  * (sizeof(THREAD) +sizeof(SFXNAME(WORK))
+                                    +sizeof(FCMSTATS));
+  corr = fcm->mode & FCM_CORR;  /* get the correlation type */
+  if      (fcm->mode & FCM_WINDOW)
+    get = SFXNAME(fcm_pccwin);  /* if to summarize sliding windows */
+  else if ((corr == FCM_PCC) && (fcm->mode & FCM_XFORM))
+    get = SFXNAME(pcc_xf);      /* if to apply the transform stage */
+  else                          /* (tetrachoric: folded into cmap) */
+    get = (corr == FCM_PCC) ? SFXNAME(pcc_pure) : SFXNAME(tcc_pure);
+  for (i = 0; i < fcm->nthd; i++) {
+    w[i].work = 0;              /* clear assigned work flag */
+    w[i].fcm  = fcm;            /* store func. con. matrix object */
+    w[i].get  = get;            /* and the functions that */
+    w[i].blk  = (fcm->mode & FCM_WINDOW) ? SFXNAME(win_blk)
+              : (corr == FCM_PCC) ? SFXNAME(pcc_blk) : SFXNAME(tcc_blk);
+    w[i].beg  = w[i].end  = 0;  /* compute a matrix element/block */
+    w[i].comp = w[i].rows = 0;  /* and clear the time stamps */
+  }                             /* and the counters */
+  return 0;                     /* return 'ok' */
+}  /* fcm_work() */
+
+/*--------------------------------------------------------------------*/
+
+static void SFXNAME(fcm_pack) (SFXNAME(FCMAT) *fcm, void *dst,
+                               const REAL *src, size_t n)
+{                               /* --- encode elements for storage */
+  size_t i;                     /* loop variable */
+
+  if      ((fcm->mode & FCM_CORR) == FCM_TCC) {
+    if      (fcm->T < 256)      /* 8 bit counts */
+      for (i = 0; i < n; i++) ((uint8_t*) dst)[i] = (uint8_t) src[i];
+    else if (fcm->T < 65536)    /* 16 bit counts */
+      for (i = 0; i < n; i++) ((uint16_t*)dst)[i] = (uint16_t)src[i];
+    else                        /* 32 bit counts */
+      for (i = 0; i < n; i++) ((uint32_t*)dst)[i] = (uint32_t)src[i]; }
+  else if (fcm->mode & FCM_HALF)/* fp16/bf16 */
+    SFXNAME(fcm_enc16)(fcm, (uint16_t*)dst, src, n);
+  else                          /* full precision */
+    memcpy(dst, src, n *sizeof(REAL));
+}  /* fcm_pack() */             /* (format as given by fcm_elsz()) */
+
+/*--------------------------------------------------------------------*/
+
+static int SFXNAME(fcm_half) (SFXNAME(FCMAT) *fcm, void *tri)
+{                               /* --- fill a packed half-stored mat. */
+  DIM    V = fcm->V;            /* number of voxels */
+  DIM    i, j, m, r, c;         /* loop variables */
+  size_t k, n, e;               /* index of first element in row */
+  REAL   *src;                  /* row of a tile */
+  char   *dst;                  /* packed (or tiled) triangle */
+
+  fcm->tile = (V < HALF_TILE) ? V : HALF_TILE;
+  if (SFXNAME(fcm_work)(fcm) != 0)
+    return -1;                  /* set up a tile cache and workers */
+  if (fcm->cnts)                /* if tetrachoric correlation, */
+    for (n = 0; n < (size_t)fcm->nthd; n++)   /* only count the */
+      ((SFXNAME(WORK)*)fcm->work)[n].blk = SFXNAME(tcc_cnt);
+                                /* 11 configurations */
+  #ifndef _WIN32                /* not yet available for Windows */
+  fcm->join = (fcm->nthd <= 1) || (fcm->mode & FCM_JOIN);
+  #endif                        /* fill the tiles with the pool */
+  fcm->gc = 1;                  /* split rectangles into strips */
+  fcm->gr = fcm->nthd;          /* (a grid with one column) */
+  dst = (char*)tri;             /* get the packed triangle */
+  e   = SFXNAME(fcm_elsz)(fcm); /* and the size of its elements */
+  for (r = 0; r < V; r += fcm->tile) {
+    for (c = r; c < V; c += fcm->tile) {
+      if (SFXNAME(fcm_fill)(fcm, r, c) != 0)
+        return -1;              /* compute the tiles of the */
+      for (i = fcm->ra; i < fcm->rb; i++) { /* upper triangle */
+        j = (i+1 > fcm->ca) ? i+1 : fcm->ca;
+        for ( ; j < fcm->cb; j = m) {
+          m = (fcm->toff)       /* tiled: split at the tile borders */
+            ? (j | TRI_MASK) +1 : fcm->cb;
+          if (m > fcm->cb) m = fcm->cb;
+          k   = TRIIDX(fcm, i, j);  /* encode the tile rows and */
+          n   = (size_t)(m-j);      /* store them in the triangle */
+          src = fcm->cache +(size_t)(i-fcm->ra) *(size_t)fcm->tile
+                           +(size_t)(j-fcm->ca);
+          SFXNAME(fcm_pack)(fcm, dst +k*e, src, n);
+        }                       /* (the rows of a tile are contiguous */
+      }                         /* parts of the rows of the triangle */
+    }                           /* or of the rows of its tiles) */
+  }
+  free(fcm->work);    fcm->work    = NULL;
+  free(fcm->threads); fcm->threads = NULL;
+  free(fcm->cache);   fcm->cache   = NULL;
+  fcm->use.cache  = (fcm->toff)
+                  ? tri_size(V) *e +((size_t)V +TRI_MASK) /TRI_BLK
+                                   *sizeof(size_t)
+                  : (size_t)V *(size_t)(V-1)/2 *e;
+  fcm->use.thread = (size_t)fcm->nthd *sizeof(FCMSTATS);
+  fcm->tile = V;                /* release the tile cache and the */
+                                /* worker data (keep thread stats.) */
+  fcm->ra   = 0; fcm->rb = V;   /* and restore the parameters */
+  fcm->ca   = 0; fcm->cb = V;   /* of a half-stored matrix */
+  fcm->gr   = fcm->gc = 0;
+  return 0;                     /* return 'ok' */
+}  /* fcm_half() */
+
+/*--------------------------------------------------------------------*/
+
+static WORKERDEF(xf_task, p)
+{                               /* --- transform part of a triangle */
+  SFXNAME(XFTASK) *t = p;       /* type the argument pointer */
+  SFXNAME(fcm_xform)(t->fcm, t->v, t->n);
+  return THREAD_OK;             /* return a dummy result */
+}  /* xf_task() */
+
+/*--------------------------------------------------------------------*/
+
+static void SFXNAME(fcm_xfall) (SFXNAME(FCMAT) *fcm, REAL *v, size_t n)
+{                               /* --- transform a stored triangle */
+  SFXNAME(XFTASK) *t;           /* task data */
+  size_t k, i, c;               /* number of tasks, loop var., chunk */
+
+  k = (n +XF_CHUNK-1) /XF_CHUNK;/* get the number of chunks */
+  #ifndef _WIN32                /* not yet available for Windows */
+  if ((k > 1) && (fcm->nthd > 1)) {
+    if (fcm->mode & FCM_JOIN)   /* threads to be joined: one part */
+      k = (size_t)fcm->nthd;    /* per thread, otherwise chunks */
+    t = (SFXNAME(XFTASK)*)malloc(k *sizeof(SFXNAME(XFTASK))
+                                +k *sizeof(THREAD));
+    if (t) {                    /* (fall back to a single thread */
+      c = (n +k-1) /k;          /* if the tasks cannot be created) */
+      for (i = 0; i < k; i++) { /* split the triangle into parts */
+        t[i].fcm = fcm;
+        t[i].v   = v +i*c;
+        t[i].n   = (i*c >= n) ? 0 : (n-i*c < c) ? n-i*c : c;
+      }
+      if (!(fcm->mode & FCM_JOIN))  /* if to use the shared pool */
+        fcm_poolrun(SFXNAME(xf_task), t, sizeof(SFXNAME(XFTASK)),
+                    (int)k, (int)fcm->nthd);
+      else {                    /* if to create new threads */
+        THREAD *thd = (THREAD*)(t+k);
+        for (i = 0; i < k; i++) /* create a thread for each part */
+          if (pthread_create(thd+i, NULL, SFXNAME(xf_task), t+i) != 0)
+            break;              /* (on failure, the remaining parts */
+        for (c = i; c < k; c++) /* are transformed by this thread) */
+          SFXNAME(xf_task)(t+c);
+        while (i > 0)           /* wait for threads to finish */
+          pthread_join(thd[--i], NULL);
+      }                         /* (join threads with this one) */
+      free(t); return;          /* deallocate the task data */
+    }
+  }
+  #endif
+  SFXNAME(fcm_xform)(fcm, v, n);/* transform in the calling thread */
+}  /* fcm_xfall() */
+
+/*----------------------------------------------------------------------
+  Out-of-core Functions
+----------------------------------------------------------------------*/
+/* If the half-stored matrix exceeds the memory limit and FCM_DISK is */
+/* given, the triangle is computed once, tile by tile, into a scratch */
+/* file (tiles of the upper triangle in the order of fcm_next(), i.e. */
+/* column strips, each tile stored as a full square in the format of  */
+/* fcm_elsz()). Traversals read the tiles back into the tile cache    */
+/* and let the kernel read the next tiles ahead; fcm_get() computes   */
+/* single elements on demand, as for a cache-based matrix.           */
+#ifndef _WIN32                  /* not yet available for Windows */
+#ifndef DISK_DEFINED            /* functions independent of REAL */
+#define DISK_DEFINED
+
+static int disk_write (int fd, const char *buf, size_t n, off_t off)
+{                               /* --- write a block to a store */
+  ssize_t k;                    /* number of bytes written */
+
+  while (n > 0) {               /* while not all bytes are written */
+    k = pwrite(fd, buf, n, off);
+    if (k < 0) { if (errno == EINTR) continue; return -1; }
+    buf += k; n -= (size_t)k; off += (off_t)k;
+  }                             /* write the next part of the block */
+  return 0;                     /* return 'ok' */
+}  /* disk_write() */
+
+/*--------------------------------------------------------------------*/
+
+static int disk_read (int fd, char *buf, size_t n, off_t off)
+{                               /* --- read a block from a store */
+  ssize_t k;                    /* number of bytes read */
+
+  while (n > 0) {               /* while not all bytes are read */
+    k = pread(fd, buf, n, off);
+    if (k < 0) { if (errno == EINTR) continue; return -1; }
+    if (k == 0) return -1;      /* check for a truncated store */
+    buf += k; n -= (size_t)k; off += (off_t)k;
+  }                             /* read the next part of the block */
+  return 0;                     /* return 'ok' */
+}  /* disk_read() */
+
+/*--------------------------------------------------------------------*/
+
+static int disk_open (const char *dir)
+{                               /* --- create a scratch file */
+  char path[DISK_PATH];         /* path of the scratch file */
+  int  fd;                      /* file descriptor */
+
+  if (!dir) dir = getenv("TMPDIR");
+  if (!dir || !*dir) dir = "/tmp";
+  if (snprintf(path, sizeof(path), "%s/fcmat-XXXXXX", dir)
+      >= (int)sizeof(path))     /* build a template for the name */
+    return -1;                  /* and create a unique file */
+  fd = mkstemp(path);           /* (it is removed from the directory */
+  if (fd >= 0) unlink(path);    /* at once and vanishes on close) */
+  return fd;                    /* return the file descriptor */
+}  /* disk_open() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static DIM SFXNAME(disk_tile) (SFXNAME(FCMAT) *fcm)
+{                               /* --- tile size of a store */
+  return (fcm->V > DISK_TILE) ? DISK_TILE : (fcm->V+1)/2;
+}  /* disk_tile() */            /* (must be less than V) */
+
+/*--------------------------------------------------------------------*/
+
+static size_t SFXNAME(disk_bufsz) (SFXNAME(FCMAT) *fcm, DIM tile)
+{                               /* --- size of the tile buffer */
+  size_t e = SFXNAME(fcm_elsz)(fcm);
+  size_t z = (size_t)tile *(size_t)tile *e;
+  if (!SFXNAME(fcm_packed)(fcm))
+    return 0;                   /* full precision: no buffer */
+  if ((fcm->mode & FCM_CORR) == FCM_TCC)
+    z = ((z +7) & ~(size_t)7) +(size_t)(fcm->T+1) *sizeof(REAL);
+  return z;                     /* tetrachoric: add a cosine map */
+}  /* disk_bufsz() */           /* (r-to-z is folded into it) */
+
+/*--------------------------------------------------------------------*/
+
+static double SFXNAME(disk_memreq) (SFXNAME(FCMAT) *fcm)
+{                               /* --- estimate memory for a store */
+  DIM n = SFXNAME(disk_tile)(fcm);
+  return SFXNAME(fcm_memreq)(fcm, n)
+       + (double)SFXNAME(disk_bufsz)(fcm, n);
+}  /* disk_memreq() */          /* (tile cache and tile buffer) */
+
+/*--------------------------------------------------------------------*/
+
+static off_t SFXNAME(disk_off) (SFXNAME(FCMAT) *fcm, DIM ra, DIM ca)
+{                               /* --- offset of a tile in a store */
+  off_t r = (off_t)(ra /fcm->tile);
+  off_t c = (off_t)(ca /fcm->tile);
+  return (c *(c+1)/2 +r) *(off_t)fcm->tile *(off_t)fcm->tile
+       * (off_t)SFXNAME(fcm_elsz)(fcm);
+}  /* disk_off() */             /* (tiles in column strips) */
+
+/*--------------------------------------------------------------------*/
+
+static int SFXNAME(fcm_spill) (SFXNAME(FCMAT) *fcm)
+{                               /* --- compute an out-of-core store */
+  DIM    D = fcm->tile;         /* tile size of the store */
+  DIM    i, j, r, c;            /* loop variables */
+  size_t e, n, k;               /* element size, elements per tile */
+  char   *buf;                  /* buffer for a packed tile */
+  REAL   *map;                  /* cosine map for reading tiles */
+
+  e = SFXNAME(fcm_elsz)(fcm);   /* get the element size */
+  n = (size_t)D *(size_t)D;     /* and the tile size */
+  if (SFXNAME(fcm_work)(fcm) != 0)
+    return -1;                  /* set up a tile cache and workers */
+  if (!SFXNAME(fcm_packed)(fcm)) { /* full precision tiles are written */
+    memset(fcm->cache, 0, n *sizeof(REAL));    /* from the cache */
+    buf = (char*)fcm->cache; }  /* (unused parts keep zeros) */
+  else {                        /* packed tiles need a buffer */
+    k = SFXNAME(disk_bufsz)(fcm, D);  /* (also used to read them) */
+    fcm->buf = buf = (char*)calloc(k, 1);
+    if (!buf) return -1;        /* allocate a tile buffer */
+    fcm->use.cache += k;        /* and note its size */
+  }
+  if ((fcm->mode & FCM_CORR) == FCM_TCC) {
+    map = (REAL*)(buf +((n *e +7) & ~(size_t)7));
+    memcpy(map, fcm->cmap, (size_t)(fcm->T+1) *sizeof(REAL));
+  }                             /* copy the cosine map (the transform */
+                                /* is already folded into it) */
+  if ((fcm->mode & FCM_CORR) == FCM_TCC)
+    for (i = 0; i < fcm->nthd; i++)  /* if tetrachoric correlation, */
+      ((SFXNAME(WORK)*)fcm->work)[i].blk = SFXNAME(tcc_cnt);
+  fcm->join = (fcm->nthd <= 1) || (fcm->mode & FCM_JOIN);
+  fcm->gc   = 1;                /* only count the 11 configurations, */
+  fcm->gr   = fcm->nthd;        /* fill the tiles with the pool and */
+                                /* split rectangles into strips */
+  for (c = 0; c < fcm->V; c += D) {
+    for (r = 0; r <= c; r += D) {
+      if (SFXNAME(fcm_fill)(fcm, r, c) != 0)
+        return -1;              /* compute the tiles of the */
+      for (i = fcm->ra; (i < fcm->rb) && fcm->buf; i++) {
+        j = (i+1 > fcm->ca) ? i+1 : fcm->ca;
+        if (j >= fcm->cb) continue;
+        SFXNAME(fcm_pack)(fcm,  /* pack the upper part of the tile */
+          buf +((size_t)(i-r) *(size_t)D +(size_t)(j-c)) *e,
+          fcm->cache +(size_t)(i-r) *(size_t)D +(size_t)(j-c),
+          (size_t)(fcm->cb-j)); /* (unused parts of the buffer */
+      }                         /* keep zeros) and write the tile */
+      if (disk_write(fcm->fd, buf, n *e,
+                     SFXNAME(disk_off)(fcm, r, c)) != 0)
+        return -1;              /* (tiles are written in the order */
+    }                           /* in which fcm_next() reads them) */
+  }
+  free(fcm->work);    fcm->work    = NULL;
+  free(fcm->threads); fcm->threads = NULL;
+  fcm->use.thread = (size_t)fcm->nthd *sizeof(FCMSTATS);
+                                /* release the worker data */
+  fcm->ra = fcm->rb = -1;       /* invalidate row and column range */
+  fcm->ca = fcm->cb = -1;       /* (the cache holds a computed tile, */
+  fcm->gr = fcm->gc = 0;        /* which is read again from the file) */
+  posix_fadvise(fcm->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return 0;                     /* traversals read the file in order */
+}  /* fcm_spill() */
+
+/*--------------------------------------------------------------------*/
+
+static int SFXNAME(fcm_load) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- load a tile from a store */
+  DIM    D = fcm->tile;         /* tile size of the store */
+  DIM    i, j;                  /* loop variables */
+  size_t e, n, k, m;            /* element size, number of elements */
+  off_t  off, prv = -1;         /* offsets of the new and old tile */
+  REAL   *dst;                  /* row of the tile cache */
+  REAL   *map;                  /* cosine map (with r-to-z) */
+
+  if (fcm->ra >= 0)             /* get the offset of the old tile */
+    prv = SFXNAME(disk_off)(fcm, fcm->ra, fcm->ca);
+  fcm->ra = row -(row % D);     /* compute the new row    range */
+  fcm->rb = fcm->ra +D; if (fcm->rb > fcm->V) fcm->rb = fcm->V;
+  fcm->ca = col -(col % D);     /* compute the new column range */
+  fcm->cb = fcm->ca +D; if (fcm->cb > fcm->V) fcm->cb = fcm->V;
+  e   = SFXNAME(fcm_elsz)(fcm); /* get the element size, */
+  n   = (size_t)D *(size_t)D;   /* the number of elements per tile */
+  off = SFXNAME(disk_off)(fcm, fcm->ra, fcm->ca);
+  if ((prv >= 0) && (off == prv +(off_t)(n*e)))
+    posix_fadvise(fcm->fd, off +(off_t)(n*e), (off_t)(DISK_AHEAD*n*e),
+                  POSIX_FADV_WILLNEED); /* if reading sequentially, */
+                                /* read the next tiles ahead */
+  if (disk_read(fcm->fd, (fcm->buf) ? (char*)fcm->buf
+                                    : (char*)fcm->cache, n*e, off) != 0) {
+    fcm->ra = fcm->rb = fcm->ca = fcm->cb = -1;
+    return fcm->err = -1;       /* read the tile and */
+  }                             /* check for a read error */
+  if (!fcm->buf) return 0;      /* full precision: tile is in cache */
+  map = ((fcm->mode & FCM_CORR) != FCM_TCC) ? NULL
+      : (REAL*)((char*)fcm->buf +((n *e +7) & ~(size_t)7));
+  for (i = fcm->ra; i < fcm->rb; i++) {
+    j   = (i+1 > fcm->ca) ? i+1 : fcm->ca;
+    k   = (size_t)(i-fcm->ra) *(size_t)D +(size_t)(j-fcm->ca);
+    dst = fcm->cache +k;        /* traverse the rows of the tile */
+    m   = (size_t)((fcm->cb > j) ? fcm->cb-j : 0);
+    if      ((fcm->mode & FCM_CORR) == FCM_TCC) {
+      if      (fcm->T < 256)    /* map numbers of 11 configurations */
+        while (m--) *dst++ = map[((uint8_t*) fcm->buf)[k++]];
+      else if (fcm->T < 65536)
+        while (m--) *dst++ = map[((uint16_t*)fcm->buf)[k++]];
+      else
+        while (m--) *dst++ = map[((uint32_t*)fcm->buf)[k++]]; }
+    else if (fcm->mode & FCM_BF16)    /* decode 16 bit floats */
+      while (m--) *dst++ = (REAL)bf16_dec(((uint16_t*)fcm->buf)[k++]);
+    else
+      while (m--) *dst++ = (REAL) f16_dec(((uint16_t*)fcm->buf)[k++]);
+  }                             /* (only the upper part of the tile) */
+  return 0;                     /* return 'ok' */
+}  /* fcm_load() */
+
+/*--------------------------------------------------------------------*/
+
+static REAL SFXNAME(fcm_disk) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr. coeff. from a store */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  if (row > col) {              /* ensure col >= row (upper triangle) */
+    DIM t = row; row = col; col = t; }
+  if (((row < fcm->ra) || (row >= fcm->rb)
+  ||   (col < fcm->ca) || (col >= fcm->cb))
+  &&  (((fcm->slot.cnt > 1)     /* if outside the current tile, */
+  ?     SFXNAME(fcm_slot)(fcm, row, col, SFXNAME(fcm_load))
+  :     SFXNAME(fcm_load)(fcm, row, col)) != 0))
+    return -INFINITY;           /* switch slots or load the tile */
+  row -= fcm->ra;               /* compute row and column in cache */
+  col -= fcm->ca;               /* and retrieve correlation coeff. */
+  return fcm->cache[(size_t)row *(size_t)fcm->tile +(size_t)col];
+}  /* fcm_disk() */
+
+#endif
+
+/*----------------------------------------------------------------------
+  Tuning Functions
+----------------------------------------------------------------------*/
+#ifndef TUNE_DEFINED            /* functions independent of REAL */
+#define TUNE_DEFINED
+#define TUNE_TIME   0.05        /* min. time per candidate (seconds) */
+#define TUNE_VOX    2048        /* max. voxels for half-stored test */
+#define TUNE_MIN    256         /* minimal tile size to try */
+#define TUNE_MAX    8192        /* maximal tile size to try */
+#define TUNE_PATH   1024        /* max. length of profile path */
+
+/*--------------------------------------------------------------------*/
+
+static FILE* tune_open (const char *how)
+{                               /* --- open the per-host profile */
+  const char *dir;              /* directory of the profile */
+  char path[TUNE_PATH];         /* path of the profile file */
+  char host[256];               /* name of the host */
+
+  dir = getenv("FCM_PROFILE");  /* if a profile file is given, */
+  if (dir)                      /* use it (empty name: no profile) */
+    return (*dir) ? fopen(dir, how) : NULL;
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  dir = getenv("USERPROFILE");  /* get the user and host names */
+  strncpy(host, getenv("COMPUTERNAME") ? getenv("COMPUTERNAME")
+               : "localhost", sizeof(host));
+  #else                         /* if Linux/Unix system */
+  dir = getenv("HOME");         /* get the home directory */
+  if (gethostname(host, sizeof(host)) != 0)
+    strcpy(host, "localhost");  /* get the host name */
+  #endif                        /* (profiles differ between hosts */
+  host[sizeof(host)-1] = 0;     /* even with a shared home) */
+  if (!dir) return NULL;        /* check for a home directory */
+  snprintf(path, sizeof(path), "%s/.fcmat-%s", dir, host);
+  return fopen(path, how);      /* open the profile file */
+}  /* tune_open() */
+
+/*--------------------------------------------------------------------*/
+
+static int tune_get (const long *key, DIM *tile, DIM *gr, DIM *gc)
+{                               /* --- look up a tuned setting */
+  FILE   *file;                 /* profile file */
+  char   buf[256];              /* read buffer for a line */
+  long   k[7], t, r, c;         /* key and setting from the file */
+  int    i, found = 0;          /* loop variable, flag for key found */
+
+  file = tune_open("r");        /* open the profile for reading */
+  if (!file) return -1;         /* (may not exist yet) */
+  while (fgets(buf, sizeof(buf), file)) {
+    if (sscanf(buf, "%ld %ld %ld %ld %ld %ld %ld %ld %ld %ld",
+               k, k+1, k+2, k+3, k+4, k+5, k+6, &t, &r, &c) != 10)
+      continue;                 /* skip comments and broken lines */
+    for (i = 0; i < 7; i++)     /* compare the key */
+      if (k[i] != key[i]) break;
+    if (i < 7) continue;        /* skip entries for other keys */
+    *tile = (DIM)t; *gr = (DIM)r; *gc = (DIM)c;
+    found = 1;                  /* note the setting; the last entry */
+  }                             /* wins (re-tuning appends a line) */
+  fclose(file);                 /* close the profile file */
+  return (found) ? 0 : -1;      /* return whether key was found */
+}  /* tune_get() */
+
+/*--------------------------------------------------------------------*/
+
+static void tune_put (const long *key, DIM tile, DIM gr, DIM gc,
+                      double rate)
+{                               /* --- store a tuned setting */
+  FILE   *file;                 /* profile file */
+
+  file = tune_open("a");        /* open the profile for appending */
+  if (!file) return;            /* (tuning result is just not kept) */
+  fseek(file, 0, SEEK_END);     /* write a header to a new file */
+  if (ftell(file) <= 0)
+    fprintf(file, "# corr real V T nthd maxmem[MiB] req.tile"
+                  " : tile grid-rows grid-cols rate[elem/s]\n");
+  fprintf(file, "%ld %ld %ld %ld %ld %ld %ld %ld %ld %ld %.4g\n",
+          key[0], key[1], key[2], key[3], key[4], key[5], key[6],
+          (long)tile, (long)gr, (long)gc, rate);
+  fclose(file);                 /* append the setting and */
+}  /* tune_put() */             /* close the profile file */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static double SFXNAME(tune_rate) (SFXNAME(FCMAT) *fcm, REAL *data,
+                                  DIM V, DIM tile, DIM *grid, int n)
+{                               /* --- measure a candidate setting */
+  SFXNAME(FCMAT) *c;            /* candidate matrix */
+  double t, e;                  /* start time, number of elements */
+  double rate, best = -1;       /* element rates (per second) */
+  DIM    i, j, r;               /* loop variables */
+  int    k;                     /* loop variable for grid shapes */
+
+  t = timer();                  /* create a matrix for the candidate */
+  c = SFXNAME(fcm_create)(data, V, fcm->T,
+        (fcm->mode & (FCM_CORR|FCM_R2Z|FCM_JOIN|FCM_HALF|FCM_TILED))
+        |FCM_THREAD|FCM_CACHE|FCM_MAXMEM, (int)fcm->nthd, (int)tile,
+        fcm->maxmem /(1024.0*1024.0*1024.0));
+  if (!c) return -1;            /* (no tuning; inherit memory limit) */
+  if      (tile >= V) {         /* if half-stored matrix */
+    e = (double)V *(double)(V-1)/2;
+    best = e /(timer() -t); }   /* all elements are computed by */
+  else if (tile <= 0) {         /* fcm_create(); if on demand */
+    t = timer(); e = 0;         /* traverse rows of the matrix */
+    for (i = 0; i < V-1; i++) { /* for a minimum amount of time */
+      for (j = i+1; j < V; j++) c->get(c, i, j);
+      e += (double)(V-1-i);     /* compute elements on the fly */
+      if (timer() -t >= TUNE_TIME) break;
+    }                           /* (same order as fcm_next()) */
+    best = e /(timer() -t); }
+  else {                        /* if cache-based */
+    for (k = 0; k < n; k++) {   /* traverse the grid shapes */
+      c->gr = grid[2*k]; c->gc = grid[2*k+1];
+      t = timer(); e = 0;       /* set the grid shape */
+      for (j = 0; j < V; j += tile) {
+        for (r = 0; r <= j; r += tile) {
+          if (SFXNAME(fcm_fill)(c, r, j) != 0) break;
+          e += (c->ra == c->ca) /* fill tiles in traversal order */
+             ? (double)(c->cb-c->ca) *(double)(c->cb-c->ca-1)/2
+             : (double)(c->rb-c->ra) *(double)(c->cb-c->ca);
+          if (timer() -t >= TUNE_TIME) break;
+        }                       /* count the computed elements */
+        if (r <= j) break;      /* until the minimum time is used */
+      }
+      rate = e /(timer() -t);   /* compute the element rate and */
+      if (rate > best) {        /* note the best grid shape */
+        best = rate; grid[0] = c->gr; grid[1] = c->gc; }
+    }                           /* (first grid shape is the best */
+  }                             /* when the function returns) */
+  SFXNAME(fcm_delete)(c);       /* delete the candidate matrix */
+  return best;                  /* return the element rate */
+}  /* tune_rate() */
+
+/*--------------------------------------------------------------------*/
+
+static void SFXNAME(fcm_tune) (SFXNAME(FCMAT) *fcm, REAL *data)
+{                               /* --- tune tile size and partition */
+  long   key[7];                /* key for the per-host profile */
+  DIM    grid[6], best[3];      /* grid shapes, best setting */
+  DIM    g, t, tile, gr, gc;    /* candidate setting */
+  int    n;                     /* number of grid shapes */
+  double rate, max = -1;        /* element rates (per second) */
+
+  key[0] = (long)(fcm->mode & (FCM_CORR|FCM_R2Z|FCM_HALF));
+  key[1] = (long)sizeof(REAL);  /* build the key for the profile */
+  key[2] = (long)fcm->V;        /* from the parameters that */
+  key[3] = (long)fcm->T;        /* influence the best setting */
+  key[4] = (long)fcm->nthd;
+  key[5] = (long)(fcm->maxmem /(1024*1024));
+  key[6] = (long)fcm->tile;     /* (requested tile, -1 if auto) */
+  if (tune_get(key, &tile, &gr, &gc) == 0) {
+    fcm->tile = tile; fcm->gr = gr; fcm->gc = gc; return; }
+  best[0] = fcm->tile; best[1] = best[2] = 0;
+
+  if (((fcm->tile < 0) || (fcm->tile >= fcm->V))
+  &&  (SFXNAME(fcm_memreq)(fcm, fcm->V) <= fcm->maxmem)) {
+    t = (fcm->V < TUNE_VOX) ? fcm->V : TUNE_VOX;
+    rate = SFXNAME(tune_rate)(fcm, data, t, t, grid, 0);
+    if (rate > max) {           /* half-stored: measure creation */
+      max = rate; best[0] = fcm->V; best[1] = best[2] = 0; }
+  }                             /* on a subset of the voxels */
+  if (fcm->tile <= 0) {         /* on demand: measure computation */
+    rate = SFXNAME(tune_rate)(fcm, data, fcm->V, 0, grid, 0);
+    if (rate > max) { max = rate; best[0] = 0; best[1] = best[2] = 0; }
+  }
+  for (g = (DIM)floor(sqrt((double)fcm->nthd)); g > 1; g--)
+    if (g *(fcm->nthd/g) == fcm->nthd)
+      break;                    /* compute factors as close as */
+  n = 0;                        /* possible to the square root */
+  grid[n++] = fcm->nthd;   grid[n++] = 1;
+  if ((g > 1) && (g < fcm->nthd)) {
+    grid[n++] = fcm->nthd/g; grid[n++] = g; }
+  if (fcm->nthd > 1) {          /* collect candidate grid shapes: */
+    grid[n++] = 1; grid[n++] = fcm->nthd; }
+  n /= 2;                       /* row strips, grid, column strips */
+  for (t = TUNE_MIN; (t < fcm->V) && (t <= TUNE_MAX); t *= 2) {
+    tile = ((fcm->tile > 0) && (fcm->tile < fcm->V)) ? fcm->tile : t;
+    if ((fcm->tile == 0) || (fcm->tile >= fcm->V)
+    ||  (SFXNAME(fcm_memreq)(fcm, tile) > fcm->maxmem))
+      break;                    /* check whether tile is admissible */
+    rate = SFXNAME(tune_rate)(fcm, data, fcm->V, tile, grid, n);
+    if (rate > max) {           /* cache-based: measure tile fills */
+      max = rate; best[0] = tile; best[1] = grid[0]; best[2] = grid[1]; }
+    if (tile != t) break;       /* if tile size is fixed, */
+  }                             /* only try the grid shapes */
+  fcm->tile = best[0];          /* set the best setting found */
+  fcm->gr   = best[1];          /* and store it in the profile */
+  fcm->gc   = best[2];          /* (if no candidate could be measured, */
+  if (max > 0)                  /* the heuristics of fcm_create() */
+    tune_put(key, fcm->tile, fcm->gr, fcm->gc, max);
+}  /* fcm_tune() */             /* are used instead) */
 
 /*----------------------------------------------------------------------
   Functions
@@ -110,12 +861,13 @@ extern REAL SFXNAME(fcm_full_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 {                               /* --- create a func. connect. matrix */
   SFXNAME(FCMAT)    *fcm;       /* func. con. matrix to be created */
-  SFXNAME(FCMGETFN) *get;       /* element computation function */
-  SFXNAME(WORK)     *w;         /* to initialize the worker data */
-  WORKER  *worker;              /* worker for parallel execution */
-  int     i, n;                 /* loop variable for threads */
   va_list args;                 /* list of variable arguments */
   size_t  z;                    /* cache size */
+  void    *tri;                 /* packed or tiled triangle */
+  const char *dir = NULL;       /* directory for out-of-core store */
+  int     k = 1;                /* number of tile slots */
+  double  m;                    /* memory left for further slots */
+  int     s;                    /* number of tile slots that fit */
   #ifdef RECTGRID               /* if to split rectangle into grid */
   DIM     g;                    /* loop variable for grid size */
   #endif
@@ -133,21 +885,42 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   fcm->mem     = NULL;          /* clear memory block, */
   fcm->cmap    = NULL;          /* cosine map and cache */
   fcm->cache   = NULL;          /* for easier cleanup */
-  fcm->diag    = (REAL)((mode & FCM_R2Z) ? R2Z_MAX : 1.0);
+  fcm->slots   = NULL;          /* (a single tile slot) */
+  fcm->slot.cnt = 1;
+  fcm->slot.key = NULL;
+  fcm->dst     = NULL;          /* no tile is filled ahead */
+  fcm->ahead   = NULL;
+  fcm->pend    = 0;
+  fcm->half    = NULL;          /* and packed triangles */
+  fcm->cnts    = NULL;
+  fcm->avg     = NULL;          /* (no online moments, */
+  fcm->mom     = NULL;          /* see fcm_online()) */
+  fcm->map     = NULL;          /* (not opened from a file) */
+  fcm->toff    = NULL;          /* (default: row-major triangle) */
+  fcm->fd      = -1;            /* no out-of-core store */
+  fcm->buf     = NULL;
+  fcm->diag    = 1;             /* (transformed below) */
+  fcm->clamp   = 1;             /* default: no clamping and */
+  fcm->thresh  = 0;             /* binarization at zero */
+  fcm->win     = fcm->step = 0; /* default: no sliding windows */
+  fcm->nwin    = 0;
   fcm->value   = fcm->diag;     /* set the value and coordinates */
   fcm->row     = fcm->col = 0;  /* of the current element */
   fcm->ra      = 0; fcm->rb = V;
   fcm->ca      = 0; fcm->cb = V;/* init. the coordinate ranges */
+  fcm->gr      = fcm->gc = 0;   /* default: set grid shape later */
   fcm->err     = 0;             /* clear the error status */
   fcm->threads = NULL;          /* clear thread handles and */
   fcm->work    = NULL;          /* worker data for easier cleanup */
+  memset(&fcm->use, 0, sizeof(FCMMEM));
+  fcm->use.base = sizeof(SFXNAME(FCMAT));
   #ifndef _WIN32                /* not yet available for Windows */
   fcm->join    = 1;             /* set the thread join flag */
-  #endif                        /* (default, to be changed later) */
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
-  fcm->sum     = fcm->beg = fcm->end = 0;
-  fcm->cnt     = 0;             /* initialize benchmark variables */
-  #endif                        /* (for time loss computation) */
+  fcm->bar.n   = 0;             /* (default, to be changed later) */
+  #endif                        /* and note no dedicated workers */
+  memset(&fcm->stats, 0, sizeof(FCMSTATS));
+  fcm->tst     = NULL;          /* clear the runtime statistics */
+  fcm->post[0] = fcm->post[1] = 0;
   DBGMSG("T: %d  N: %d  P: %4d  C: %d  maxmem [GiB]: %f\n",
           fcm->T, fcm->V, fcm->nthd, fcm->tile, fcm->maxmem);
 
@@ -167,6 +940,23 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   if (mode & FCM_MAXMEM)        /* max. amount of memory */
     fcm->maxmem = va_arg(args, double);
 
+  if (mode & FCM_DISK)          /* directory for out-of-core store */
+    dir = va_arg(args, const char*);
+
+  if (mode & FCM_SLOTS)         /* number of tile slots */
+    k = va_arg(args, int);
+
+  if (mode & FCM_CLAMP)         /* bound for clamping */
+    fcm->clamp  = (REAL)va_arg(args, double);
+
+  if (mode & FCM_BIN)           /* threshold for binarization */
+    fcm->thresh = (REAL)va_arg(args, double);
+
+  if (mode & FCM_WINDOW) {      /* window length and step */
+    fcm->win  = va_arg(args, int);
+    fcm->step = va_arg(args, int);
+  }
+
   va_end(args);
   DBGMSG("T: %d  N: %d  P: %4d  C: %d  maxmem [GiB]: %f\n",
           fcm->T, fcm->V, fcm->nthd, fcm->tile, fcm->maxmem);
@@ -176,39 +966,105 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
     fcm->nthd = proccnt();      /* use number of logical processors */
 
   /* max memory */
-  if (fcm->maxmem < 0)          /* if auto-determine */
-    fcm->maxmem = 2.0;          /* use 2 GiB */
+  if (fcm->maxmem < 0)          /* if auto-determine, */
+    fcm->maxmem = FCM_MEMDEF;   /* use the default limit */
   fcm->maxmem = fcm->maxmem * 1024*1024*1024;
   DBGMSG("maxmem [B]: %f\n", fcm->maxmem);
 
-  /* cache size */
-  size_t E = (size_t)V * (size_t)(V-1)/2;
-  if (fcm->tile == fcm->V) {    /* if half-stored */
-    if ((E * sizeof(REAL)) > fcm->maxmem) {
-      if (fcm->nthd <= 6)
-        fcm->tile = 1024;
-      else
-        fcm->tile = 0;
-      WARNING("fcm->tile has been set to %d to enforce the specified"
-              "memory limit.\n", fcm->tile);
-    }
+  /* correlation type and data block size */
+  if (((mode & FCM_CORR) != FCM_PCC) && ((mode & FCM_CORR) != FCM_TCC)) {
+    fprintf(stderr, "fcm_create: unknown correlation variant\n");
+    free(fcm); return NULL;     /* print an error message */
+  }                             /* and abort the function */
+
+  /* sliding windows */
+  if (mode & FCM_WINDOW) {      /* if to summarize windowed corr.c. */
+    if (((mode & FCM_CORR) != FCM_PCC)
+    ||  (fcm->win < 2) || (fcm->win > T) || (fcm->step < 1)) {
+      fprintf(stderr, "fcm_create: invalid sliding windows\n");
+      free(fcm); return NULL;   /* (Pearson correlation only, */
+    }                           /* at least two scans per window) */
+    fcm->nwin = (T -fcm->win) /fcm->step +1;
+  }                             /* get the number of windows */
+  SFXNAME(fcm_blksz)(fcm);      /* get the size of the prepared data */
+  fcm->diag  = SFXNAME(fcm_xval)(fcm, (REAL)1);
+  if (mode & FCM_WVAR)          /* the variance of the diagonal */
+    fcm->diag = 0;              /* is zero for all windows */
+  fcm->value = fcm->diag;       /* transform the diagonal value */
+
+  /* tuning */
+  if ((mode & FCM_TUNE)         /* if to tune tile size and partition */
+  &&  !(mode & FCM_WINDOW))     /* (not for sliding windows) */
+    SFXNAME(fcm_tune)(fcm, data);
+
+  /* out-of-core store (instead of a smaller tile or on demand) */
+  #ifndef _WIN32                /* not yet available for Windows */
+  if ((mode & FCM_DISK)         /* if a store may be used and */
+  &&  ((fcm->tile == V) || (fcm->tile == -1))   /* half-stored, */
+  &&  (SFXNAME(fcm_memreq)(fcm, V)  >  fcm->maxmem)
+  &&  (SFXNAME(disk_memreq)(fcm)    <= fcm->maxmem)) {
+    fcm->fd = disk_open(dir);   /* but exceeds the memory limit, */
+    if (fcm->fd >= 0)           /* create a scratch file */
+      fcm->tile = SFXNAME(disk_tile)(fcm);
+    else WARNING("cannot create an out-of-core store in %s.\n",
+                 (dir) ? dir : "the temporary directory");
+  }                             /* (fall back to the tile below) */
+  #endif
+
+  /* cache size (the whole footprint must fit into maxmem) */
+  if ((fcm->tile == fcm->V)     /* if half-stored */
+  &&  (SFXNAME(fcm_memreq)(fcm, V) > fcm->maxmem)) {
+    fcm->tile = ((fcm->nthd <= 6) && (1024 < V)
+              && (SFXNAME(fcm_memreq)(fcm, 1024) <= fcm->maxmem))
+              ? 1024 : 0;
+    WARNING("fcm->tile has been set to %d to enforce the specified "
+            "memory limit.\n", fcm->tile);
   }
   if ((fcm->tile < V)           /* if cache-based */
-      && (fcm->tile > 0)) {
-    if (((size_t)fcm->tile *(size_t)fcm->tile *sizeof(REAL)) > fcm->maxmem) {
-      fcm->tile = 0;
-      WARNING("fcm->tile has been set to %d to enforce the specified"
-              "memory limit.\n", fcm->tile);
-    }
+  &&  (fcm->tile > 0)
+  &&  (SFXNAME(fcm_memreq)(fcm, fcm->tile) > fcm->maxmem)) {
+    fcm->tile = 0;
+    WARNING("fcm->tile has been set to %d to enforce the specified "
+            "memory limit.\n", fcm->tile);
   }
   if (fcm->tile == -1) {        /* if auto-determine */
-    if ((E * sizeof(REAL)) <= fcm->maxmem)
+    if (SFXNAME(fcm_memreq)(fcm, V) <= fcm->maxmem)
       fcm->tile = fcm->V;       /* use half-stored */
-    else if ((1024*1024 * sizeof(REAL) <= fcm->maxmem) && (fcm->nthd <= 6))
+    else if ((fcm->nthd <= 6) && (1024 < V)
+    &&       (SFXNAME(fcm_memreq)(fcm, 1024) <= fcm->maxmem))
       fcm->tile = 1024;         /* use cache-based (tile size: 1024) */
     else
       fcm->tile = 0;            /* use on-demand */
   }
+  if (SFXNAME(fcm_memreq)(fcm, fcm->tile) > fcm->maxmem)
+    WARNING("the prepared data alone exceed the specified "
+            "memory limit.\n");
+
+  /* tile slots (the remaining memory limit bounds their number) */
+  if ((mode & FCM_SLOTS)        /* if to cache several tiles */
+  &&  (fcm->tile > 0) && (fcm->tile < V)) {
+    #ifndef _WIN32              /* not yet available for Windows */
+    m = fcm->maxmem -((fcm->fd >= 0) ? SFXNAME(disk_memreq)(fcm)
+                      : SFXNAME(fcm_memreq)(fcm, fcm->tile));
+    #else
+    m = fcm->maxmem -SFXNAME(fcm_memreq)(fcm, fcm->tile);
+    #endif                      /* memory left for further slots */
+    z = (size_t)fcm->tile *(size_t)fcm->tile *sizeof(REAL);
+    s = (m <= 0) ? 1 : (m/(double)z < INT_MAX/4) ? (int)(m/(double)z)+1
+      : INT_MAX/4;              /* (one slot is the cache itself, */
+                                /* the hash table needs up to 4s) */
+    while ((s > 1) && ((double)(s-1) *(double)z
+                      +(double)slot_memsz(s) > m))
+      s--;                      /* reduce the number of slots until */
+    if      (k <= 0)            /* their management data also fits */
+      k = s;                    /* if auto-determine, */
+    else if (k >  s) {          /* use as many slots as fit */
+      k = s;                    /* if too many slots requested, */
+      WARNING("the number of tile slots has been set to %d to enforce "
+              "the specified memory limit.\n", k);
+    }                           /* (at least one slot, the cache */
+    fcm->slot.cnt = k;          /* of fcm_work(), is always used) */
+  }                             /* (fcm_slots() may reduce it) */
   DBGMSG("T: %d  N: %d  P: %4d  C: %d  maxmem [B]: %f\n",
           fcm->T, fcm->V, fcm->nthd, fcm->tile, fcm->maxmem);
   assert((fcm->nthd >= 1) && (fcm->nthd <= 1024));
@@ -216,115 +1072,143 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   assert((fcm->maxmem >= 0));
 
   mode &= FCM_CORR;             /* get the correlation type */
-  if      (mode == FCM_PCC) {   /* if Pearson's correlation coeff. */
-    #ifdef __AVX__              /* use AVX if possible */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+7) & ~7); /* process blocks with 8 numbers */
-    #endif
-    #else                       /* otherwise fall back to SSE2 */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+1) & ~1); /* process blocks with 2 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #endif                      /* get the data block size */
-    #endif                      /* allocate memory for norm.ed data */
-    fcm->mem = malloc((size_t)V*(size_t)fcm->X *sizeof(REAL) +31);
-    if (!fcm->mem) { SFXNAME(fcm_delete)(fcm); return NULL; }
-    fcm->data = (REAL*)(((uintptr_t)fcm->mem +31) & ~(uintptr_t)31);
-    INIT_PCC(data, (int)V, (int)T, fcm->data, (int)fcm->X); }
-  else if (mode == FCM_TCC) {   /* if tetrachoric correlation coeff. */
-    #if defined __POPCNT__ \
-    &&  defined __SSE4_1__      /* use 128 bit and popcnt if possible */
-    fcm->X = 4 *(((int)T+127) >> 7);
-    #else                       /* otherwise fall back to LUT16 */
-    fcm->X = ((int)T+31) >> 5;  /* get block size of binarized data */
-    #endif
-    fcm->mem  =                 /* allocate memory for binarized data */
-    fcm->data = SFXNAME(binarize)(data, (int)V, (int)T, BIN_MEDIAN,BPI);
-    if (!fcm->data) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    fcm->cmap = SFXNAME(make_cmap)((int)T); /* create cosine map */
-    if (!fcm->cmap) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    init_popcnt(); }            /* initialize bit count table */
-  else {                        /* if unknown correlation variant */
-    fprintf(stderr, "fcm_create: unknown correlation variant\n");
-    free(fcm); return NULL;     /* print an error message */
-  }                             /* and abort the function */
+  if (((fcm->tile < V)          /* if not half-stored or if the */
+  ||   SFXNAME(fcm_packed)(fcm)  /* triangle is */
+  ||   (fcm->mode & FCM_WINDOW))
+  &&  (SFXNAME(fcm_prep)(fcm, data) != 0)) {
+    SFXNAME(fcm_delete)(fcm); return NULL; }
+                                /* filled tile by tile, select */
+                                /* kernels and prepare data */
 
-  if (!(fcm->mode & FCM_R2Z))   /* if pure correlation coefficients */
-    fcm->get = (mode == FCM_PCC)
-             ? SFXNAME(fcm_pccotf) : SFXNAME(fcm_tccotf);
-  else {                        /* if to apply Fisher's r to z trans. */
-    fcm->get = (mode == FCM_PCC)
-             ? SFXNAME(fcm_pccr2z) : SFXNAME(fcm_tccr2z);
-  }                             /* get the element retrieval function */
+  if (mode == FCM_TCC)          /* tetrachoric: transform is folded */
+    fcm->get = SFXNAME(fcm_tccotf);     /* into the cosine map */
+  else if (fcm->mode & FCM_WINDOW)    /* sliding windows */
+    fcm->get = SFXNAME(fcm_pccwin);
+  else                          /* Pearson: apply transform stage */
+    fcm->get = (fcm->mode & FCM_XFORM)
+             ? SFXNAME(fcm_pccxf) : SFXNAME(fcm_pccotf);
+                                /* get the element retrieval function */
 
   if      (fcm->tile <= 0)      /* if computation on the fly */
     fcm->cget = fcm->get;       /* get the element retrieval function */
+  #ifndef _WIN32                /* not yet available for Windows */
+  else if (fcm->fd >= 0) {      /* if to use an out-of-core store */
+    fcm->use.peak = (size_t)SFXNAME(disk_memreq)(fcm);
+    if (SFXNAME(fcm_spill)(fcm) != 0) {
+      SFXNAME(fcm_delete)(fcm); return NULL; }
+    if (SFXNAME(fcm_slots)(fcm, fcm->slot.cnt) != 0) {
+      SFXNAME(fcm_delete)(fcm); return NULL; }
+    fcm->cget = SFXNAME(fcm_disk);
+    fcm->tget = fcm->get;       /* (threads compute on the fly) */
+    if (fcm->slot.cnt > 1)      /* with several tile slots, */
+      fcm->get = fcm->cget;     /* also fcm_get() reads the store */
+  }                             /* traversals read the store */
+  #endif
   else if (fcm->tile <  V) {    /* if to cache smaller areas */
-    z = (size_t)fcm->tile *(size_t)fcm->tile;
-    fcm->cache    = (REAL*)  malloc(z *sizeof(REAL));
-    fcm->threads  = (THREAD*)malloc((size_t)fcm->nthd *sizeof(THREAD));
-    fcm->work = w = malloc((size_t)fcm->nthd *sizeof(SFXNAME(WORK)));
-    if (!fcm->cache || !fcm->threads || !fcm->work)  {
+    if ((SFXNAME(fcm_work)(fcm) != 0)
+    ||  (SFXNAME(fcm_slots)(fcm, fcm->slot.cnt) != 0)) {
       SFXNAME(fcm_delete)(fcm); return NULL; }
-    if (!(fcm->mode & FCM_R2Z)) /* if to compute pure corr. coeffs. */
-      get = (mode == FCM_PCC) ? SFXNAME(pcc_pure) : SFXNAME(tcc_pure);
-    else                        /* if to apply Fisher's r to z trans. */
-      get = (mode == FCM_PCC) ? SFXNAME(pcc_r2z)  : SFXNAME(tcc_r2z);
-    for (i = 0; i < fcm->nthd; i++) {
-      w[i].work = 0;            /* clear assigned work flag */
-      w[i].fcm  = fcm;          /* store func. con. matrix object */
-      w[i].get  = get;          /* and the function that */
-    }                           /* computes a matrix element */
+                                /* set up tile cache(s) and workers */
     #ifndef _WIN32              /* not yet available for Windows */
-    fcm->join = ((fcm->nthd <= 1) || (fcm->mode & FCM_JOIN));
-    if (!fcm->join) {           /* if to block and signal threads */
-      pthread_mutex_init(&fcm->mutex,     NULL);
-      pthread_cond_init (&fcm->cond_idle, NULL);
-      pthread_cond_init (&fcm->cond_work, NULL);
-      fcm->idle = 0;            /* init. thread synchronization */
-      worker = SFXNAME(fill);   /* get the worker function */
-      for (n = 0; n < fcm->nthd; n++)
-        if (pthread_create(fcm->threads+n, NULL, worker, w+n) != 0) {
-          fcm->err = -1; break;}/* start the worker threads */
-      pthread_mutex_lock(&fcm->mutex);
-      while (fcm->idle < n)     /* wait for all threads to start */
-        pthread_cond_wait(&fcm->cond_idle, &fcm->mutex);
-      pthread_mutex_unlock(&fcm->mutex);
-      if (fcm->err) {           /* if starting the threads failed */
-        fcm->nthd = n; SFXNAME(fcm_delete)(fcm); return NULL; }
-    }                           /* delete the matrix and abort */
-    #endif
-    #ifdef RECTGRID             /* if to split rectangle into grid */
-    for (g = (DIM)floor(sqrt((REAL)fcm->nthd)); g > 1; g--)
-      if (g *(fcm->nthd/g) == fcm->nthd)
-        break;                  /* compute factors as close as */
-    fcm->gc = g;                /* possible to the square root */
-    fcm->gr = fcm->nthd/g;      /* for the rectangle grid */
+    if (PIPED(fcm)) {           /* if to fill the next tile ahead */
+      z = (size_t)fcm->tile *(size_t)fcm->tile *sizeof(REAL);
+      fcm->ahead = (REAL*)malloc(z);
+      if (!fcm->ahead) { SFXNAME(fcm_delete)(fcm); return NULL; }
+      fcm->use.cache += z;      /* allocate a second tile buffer */
+    }                           /* (filled by pool workers) */
+    fcm->join = !fcm->ahead     /* use the shared pool unless */
+             && ((fcm->nthd <= 1) || (fcm->mode & FCM_JOIN));
+    if (!fcm->join && (fcm->mode & FCM_SPIN)    /* threads are to be */
+    &&  (SFXNAME(fcm_start)(fcm) != 0)) {       /* joined or workers */
+      SFXNAME(fcm_delete)(fcm); return NULL; }  /* are dedicated */
     #endif
-    fcm->cget = SFXNAME(fcm_cache);
+    if ((fcm->gr <= 0) || (fcm->gc <= 0)
+    ||  (fcm->gr *fcm->gc > fcm->nthd)) {
+      #ifdef RECTGRID           /* if to split rectangle into grid */
+      for (g = (DIM)floor(sqrt((REAL)fcm->nthd)); g > 1; g--)
+        if (g *(fcm->nthd/g) == fcm->nthd)
+          break;                /* compute factors as close as */
+      fcm->gc = g;              /* possible to the square root */
+      fcm->gr = fcm->nthd/g;    /* for the rectangle grid */
+      #else                     /* if to split rectangle into strips */
+      fcm->gc = 1;              /* (a grid with one column) */
+      fcm->gr = fcm->nthd;
+      #endif                    /* if grid shape was not tuned, */
+    }                           /* use the default grid shape */
+    fcm->cget = (fcm->ahead) ? SFXNAME(fcm_pipe) : SFXNAME(fcm_cache);
     fcm->ra = fcm->rb = -1;     /* get element retrieval function and */
-    fcm->ca = fcm->cb = -1; }   /* invalidate row and column range */
+    fcm->ca = fcm->cb = -1;     /* invalidate row and column range */
+    fcm->tget = fcm->get;       /* (threads compute on the fly) */
+    if (fcm->slot.cnt > 1)      /* with several tile slots, */
+      fcm->get = fcm->cget;     /* also fcm_get() uses the cache */
+  }                             /* (random access hits cached tiles) */
+  else if (SFXNAME(fcm_packed)(fcm)
+  ||       (fcm->mode & FCM_WINDOW)) {
+    z = (size_t)V *(size_t)(V-1)/2; /* if to store the whole matrix */
+    if (fcm->mode & FCM_TILED) {    /* with 8 or 16 bits per element */
+      fcm->toff = tri_toff(V);      /* (row by row or as tiles) */
+      if (!fcm->toff) {
+        SFXNAME(fcm_delete)(fcm); return NULL; }
+      z = tri_size(V);          /* clear the padding of the tiles */
+    }                           /* (saved files are deterministic) */
+    z *= SFXNAME(fcm_elsz)(fcm);
+    tri = (fcm->toff) ? calloc(z, 1) : malloc(z);
+    if (!tri) { SFXNAME(fcm_delete)(fcm); return NULL; }
+    if      (mode == FCM_TCC)   fcm->cnts = tri;
+    else if (fcm->mode & FCM_HALF) fcm->half = (uint16_t*)tri;
+    fcm->use.peak = (size_t)SFXNAME(fcm_memreq)(fcm, V);
+    if (SFXNAME(fcm_half)(fcm, tri) != 0) {
+      if (!fcm->cnts && !fcm->half) free(tri);
+      SFXNAME(fcm_delete)(fcm); return NULL; }
+    if (fcm->mode & FCM_WINDOW) /* keep the series for fcm_winget() */
+      fcm->use.data = SFXNAME(fcm_datasz)(fcm);
+    else {                      /* release the prepared data */
+      free(fcm->mem); fcm->mem  = fcm->data = NULL;
+      fcm->use.data = 0;        /* (only needed to fill triangle) */
+    }
+    if      (mode == FCM_TCC)   /* if numbers of 11 configurations */
+      fcm->get = (T <   256) ? SFXNAME(fcm_full_n8)  /* (transform */
+               : (T < 65536) ? SFXNAME(fcm_full_n16) /* is in cmap) */
+               :               SFXNAME(fcm_full_n32);
+    else if (!(fcm->mode & FCM_HALF)) {
+      fcm->cache = (REAL*)tri;  /* sliding windows: summaries */
+      fcm->get   = SFXNAME(fcm_full); } /* with full precision */
+    else if (fcm->mode & FCM_BF16)
+      fcm->get = SFXNAME(fcm_full_bf16);
+    #if defined FCM_ALL_ISA || defined __F16C__
+    else if (fcm->isa & FCM_ISA_F16C)
+      fcm->get = SFXNAME(fcm_full_f16c);
+    #endif
+    else fcm->get = SFXNAME(fcm_full_f16);
+    fcm->cget = fcm->get;       /* set the element retrieval function */
+  }                             /* (fp16/bf16: transform is applied */
+                                /* when filling the triangle) */
   else {                        /* if to cache the whole matrix */
     z = (size_t)V *(size_t)(V-1)/2; /* cache for upper triangle */
+    if (fcm->mode & FCM_TILED) {    /* if to store it as tiles, */
+      fcm->toff = tri_toff(V);      /* create the tile offset table */
+      if (!fcm->toff) { SFXNAME(fcm_delete)(fcm); return NULL; }
+      z = tri_size(V);          /* (the tiles need at least as many */
+    }                           /* elements as the row-major triangle) */
     fcm->cache = (REAL*)malloc(z *sizeof(REAL));
     if (!fcm->cache) { SFXNAME(fcm_delete)(fcm); return NULL; }
-    if (mode == FCM_PCC)        /* if Pearson correlation cofficient */
-      SFXNAME(pccx)    (data, fcm->cache, (int)V, (int)T,
-                        PCC_AUTO|PCC_THREAD, fcm->nthd);
-    else                        /* if tetrachoric correlation coeff. */
-      SFXNAME(tetraccx)(data, fcm->cache, (int)V, (int)T,
-                        TCC_AUTO|TCC_THREAD, fcm->nthd);
-    if (!(fcm->mode & FCM_R2Z)) {/* if to compute pure corr. coeffs. */
-      fcm->cget = SFXNAME(fcm_full);
-      fcm->get = SFXNAME(fcm_full); }
-    else {                       /* if to apply Fisher's r to z trans. */
-      fcm->cget = SFXNAME(fcm_full_r2z);
-      fcm->get = SFXNAME(fcm_full_r2z);
-    }                            /* set the element retrieval function */
-  }
+    fcm->use.cache = z *sizeof(REAL);
+    fcm->use.peak  = (size_t)SFXNAME(fcm_memreq)(fcm, V);
+    SFXNAME(pccx)(data, fcm->cache, (int)V, (int)T,
+                  PCC_AUTO|PCC_THREAD, fcm->nthd);
+    fcm->stats.comp = (size_t)V *(size_t)(V-1)/2;
+                                /* (only Pearson correlation coeffs., */
+                                /* tetrachoric ones are kept as counts) */
+    if (fcm->mode & FCM_XFORM)  /* apply the transform stage once */
+      SFXNAME(fcm_xfall)(fcm, fcm->cache, fcm->stats.comp);
+    if (fcm->toff) {            /* rearrange the triangle into tiles */
+      if (tri_tile(fcm->cache, V, sizeof(REAL), fcm->toff) != 0) {
+        SFXNAME(fcm_delete)(fcm); return NULL; }
+      fcm->use.cache += ((size_t)V +TRI_MASK) /TRI_BLK *sizeof(size_t);
+    }                           /* (in place, see fcmat3.h) */
+    fcm->cget = SFXNAME(fcm_full);  /* set the element retrieval */
+    fcm->get  = SFXNAME(fcm_full);  /* function (the transform has */
+  }                             /* been applied to the triangle) */
   return fcm;                   /* return created FC matrix */
 } /* fcm_create() */
 
@@ -332,44 +1216,43 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 
 void SFXNAME(fcm_delete) (SFXNAME(FCMAT) *fcm)
 {                               /* --- delete a func. connect. matrix */
+  #ifdef FCM_BENCH              /* if to do some benchmarking */
+  FCMSTATS st;                  /* runtime statistics */
+  #endif
+
   assert(fcm);                  /* check the function argument */
   #ifdef FCM_BENCH              /* if to do some benchmarking */
-  double loss = fcm->beg +fcm->end;
-  if (fcm->cnt <= 0) fcm->cnt = 1;
+  SFXNAME(fcm_stats)(fcm, &st, -1);
+  if (st.fills <= 0) st.fills = 1;
   fprintf(stderr, "fcm_delete()\n");
-  fprintf(stderr, "%d tiles\n", fcm->cnt);
+  fprintf(stderr, "%zu tiles\n", st.fills);
   fprintf(stderr, "time: %10.6f (%10.6f)\n",
-          fcm->sum, fcm->sum/(double)fcm->cnt);
-  fprintf(stderr, "loss: %10.6f (%10.6f/%10.6f)\n",
-          loss,     loss    /(double)fcm->nthd,
-          loss    /(double)fcm->cnt);
-  fprintf(stderr, "beg : %10.6f (%10.6f/%10.6f)\n",
-          fcm->beg, fcm->beg/(double)fcm->nthd,
-          fcm->beg/(double)fcm->cnt);
-  fprintf(stderr, "end : %10.6f (%10.6f/%10.6f)\n",
-          fcm->end, fcm->end/(double)fcm->nthd,
-          fcm->end/(double)fcm->cnt);
+          st.time, st.time/(double)st.fills);
+  fprintf(stderr, "idle: %10.6f (%10.6f/%10.6f)\n",
+          st.idle, st.idle/(double)fcm->nthd,
+          st.idle/(double)st.fills);
+  fprintf(stderr, "sync: %10.6f (%10.6f)\n",
+          st.sync, st.sync/(double)st.fills);
   #endif                        /* print benchmarking information */
   #ifndef _WIN32                /* not yet available for Windows */
-  if (!fcm->join) {             /* if to block and signal threads */
-    int i;                      /* loop variable for threads */
-    SFXNAME(WORK) *w = fcm->work;     /* get the worker data */
-    pthread_mutex_lock(&fcm->mutex);
-    for (i = 0; i < fcm->nthd; i++)
-      w[i].work = -1;           /* set the thread stop indicators */
-    fcm->idle = 0;              /* signal that work was assigned */
-    pthread_cond_broadcast(&fcm->cond_work);
-    pthread_mutex_unlock(&fcm->mutex);
-    for (i = 0; i < fcm->nthd; i++) /* wait for all threads to finish */
-      pthread_join(fcm->threads[i], NULL);
-    pthread_cond_destroy (&fcm->cond_work);
-    pthread_cond_destroy (&fcm->cond_idle);
-    pthread_mutex_destroy(&fcm->mutex);
-  }                             /* clean up thread synchronization */
+  if (fcm->work)                /* wait for a tile filled ahead */
+    SFXNAME(fcm_wait)(fcm);     /* (no pool task may refer to it) */
+  if (fcm->bar.n > 0)           /* stop the dedicated workers */
+    SFXNAME(fcm_stop)(fcm);
+  if (fcm->fd >= 0) close(fcm->fd);   /* remove the store */
   #endif
+  if (fcm->map) SFXNAME(fcm_unmap)(fcm); /* unmap a saved matrix */
+  if (fcm->buf)     free(fcm->buf);
   if (fcm->work)    free(fcm->work);
+  if (fcm->tst)     free(fcm->tst);
   if (fcm->threads) free(fcm->threads);
+  if (fcm->slots)   fcm->cache = fcm->slots;
   if (fcm->cache)   free(fcm->cache);
+  if (fcm->slot.key) free(fcm->slot.key);
+  if (fcm->ahead)   free(fcm->ahead);
+  if (fcm->half)    free(fcm->half);
+  if (fcm->cnts)    free(fcm->cnts);
+  if (fcm->toff)    free(fcm->toff);
   if (fcm->cmap)    free(fcm->cmap);
   if (fcm->mem)     free(fcm->mem);/* delete cache, cosine map, */
   free(fcm);                    /* data, and the base structure */
@@ -13,11 +13,14 @@
 #include <stdint.h>
 #endif
 
+#include <stddef.h>
+
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
 #include <pthread.h>
+#include "fcmpool.h"
 #endif
 
 /*----------------------------------------------------------------------
@@ -59,13 +62,59 @@
 #define FCM_PCC     0x0001      /* Pearson correlation coefficient  */
 #define FCM_TCC     0x0002      /* tetrachoric correlation coeff. */
 
+#define FCM_XFORM   0x00f0      /* mask for post-correlation transforms */
 #define FCM_R2Z     0x0010      /* Fisher r-to-z transform */
+#define FCM_ABS     0x0020      /* absolute value (before r-to-z) */
+#define FCM_CLAMP   0x0040      /* clamp to [-c,+c] (needs bound c,
+                                 * applied before r-to-z) */
+#define FCM_BIN     0x0080      /* binarize at a threshold (needs
+                                 * threshold, applied last) */
 
 #define FCM_CACHE   0x0100      /* use a cache (needs tile size) */
 #define FCM_THREAD  0x0200      /* threads (needs thread count) */
 #define FCM_JOIN    0x0400      /* join and re-create threads (default is
-                                 * block and signal) */
-#define FCM_MAXMEM  0x0800      /* max. amount of memory (needs mem. limit) */
+                                 * the shared pool, see fcmpool.h) */
+#define FCM_MAXMEM  0x0800      /* max. amount of memory (needs mem. limit
+                                 * in GiB, < 0: FCM_MEMDEF) */
+#define FCM_TUNE    0x1000      /* tune tile size and partition (uses
+                                 * a per-host profile, see fcm_create) */
+#define FCM_F16     0x2000      /* store half-stored matrix as fp16 */
+#define FCM_BF16    0x4000      /* store half-stored matrix as bf16 */
+#define FCM_HALF    0x6000      /* mask for 16 bit storage formats */
+#define FCM_DISK    0x8000      /* out-of-core half-stored matrix if it
+                                 * exceeds the memory limit (needs dir.) */
+#define FCM_TILED   0x10000     /* store half-stored matrix as tiles */
+#define FCM_SLOTS   0x20000     /* cache several tiles (needs number of
+                                 * slots, <= 0: as many as maxmem allows;
+                                 * fcm_get() is then not thread-safe,
+                                 * concurrent callers use fcm_tget()) */
+#define FCM_PIPE    0x40000     /* fill the next tile of a traversal
+                                 * while the current one is read */
+#define FCM_SPIN    0x80000     /* dedicated workers that synchronize
+                                 * with spin-then-futex barriers */
+#define FCM_DYNAMIC 0x100000    /* threads pull the sub-blocks of a tile
+                                 * from a shared counter */
+#define FCM_ONLINE  0x200000    /* online matrix that is updated as scans
+                                 * arrive (set by fcm_online()) */
+#define FCM_WINDOW  0x400000    /* mean of sliding-window correlations
+                                 * (needs window length and step) */
+#define FCM_WVAR    0x800000    /* variance instead of the mean
+                                 * of the windows (with FCM_WINDOW) */
+
+#define FCM_MEMDEF  2.0         /* default memory limit (in GiB) */
+
+#define FCM_ISA_SSE2    0x0001  /* SSE2 instructions */
+#define FCM_ISA_AVX     0x0002  /* AVX instructions */
+#define FCM_ISA_AVX2    0x0004  /* AVX2 instructions */
+#define FCM_ISA_POPCNT  0x0008  /* popcnt and SSE4.1 instructions */
+#define FCM_ISA_VPOPCNT 0x0010  /* AVX-512F and AVX-512 VPOPCNTDQ */
+#define FCM_ISA_AVX512  0x0020  /* AVX-512F instructions */
+#define FCM_ISA_AVX512BW 0x0040 /* AVX-512F and AVX-512BW */
+#define FCM_ISA_F16C    0x0080  /* AVX and F16C (fp16 conversion) */
+#define FCM_ISA_AVX512BF16 0x0100 /* AVX-512F and AVX-512 BF16 */
+                                /* (the environment variable FCM_ISA
+                                 * may hold a mask of these flags
+                                 * that restricts the kernels used) */
 #endif
 
 #ifndef THREAD                  /* if not yet defined */
@@ -73,9 +122,7 @@
 #define THREAD      HANDLE      /* threads are identified by handles */
 #else                           /* if Linux/Unix system */
 #define THREAD      pthread_t   /* use the POSIX thread type */
-#define MUTEX       pthread_mutex_t
-#define TCOND       pthread_cond_t
-#endif                          /* thread signaling variables */
+#endif
 #endif
 
 #ifdef NDEBUG
@@ -88,9 +135,9 @@
                            while(0)
 #  else
 #    include <stdio.h>
-#    define WARNING(...) do { fprintf(stderr, "WARNING: ");
+#    define WARNING(...) do { fprintf(stderr, "WARNING: "); \
                               fprintf(stderr, __VA_ARGS__); } while(0)
-#    define ERROR(...)   do { fprintf(stderr, "ERROR: ");
+#    define ERROR(...)   do { fprintf(stderr, "ERROR: "); \
                               fprintf(stderr, __VA_ARGS__); } while(0)
 #  endif
 #else
@@ -116,7 +163,7 @@
 #    define WARNING(...) do { fprintf(stderr, "WARNING @ %s:%d:%s()\n", \
                               __FILE__, __LINE__, __func__); \
                               fprintf(stderr, __VA_ARGS__); } while(0)
-#    define WARNING(...) do { fprintf(stderr, "ERROR @ %s:%d:%s()\n", \
+#    define ERROR(...)   do { fprintf(stderr, "ERROR @ %s:%d:%s()\n", \
                               __FILE__, __LINE__, __func__); \
                               fprintf(stderr, __VA_ARGS__); } while(0)
 #  endif
@@ -128,43 +175,122 @@
 struct SFXNAME(fcmat);          /* --- element retrieval function */
 typedef REAL SFXNAME(FCMGETFN) (struct SFXNAME(fcmat) *fcmat,
                                 DIM row, DIM col);
+typedef REAL SFXNAME(FCMPAIRFN) (REAL *a, REAL *b, int n);
+                                /* --- pair kernel (Pearson) */
+#ifndef FCM_ANDFN_DEFINED       /* --- pair kernel (tetrachoric) */
+#define FCM_ANDFN_DEFINED       /* (counts the 11 configurations) */
+typedef int FCMANDFN (uint32_t *a, uint32_t *b, int n);
+#endif
+
+#ifndef FCM_MEM_DEFINED         /* --- memory usage (in bytes) */
+#define FCM_MEM_DEFINED         /* (see fcm_memusage()) */
+typedef struct {                /* --- memory usage of an FC matrix */
+  size_t base;                  /* base structure */
+  size_t data;                  /* normalized/binarized data */
+  size_t cmap;                  /* map from n_11 to cosine values */
+  size_t cache;                 /* cached tile or half-stored matrix */
+  size_t thread;                /* thread handles and worker data */
+  size_t total;                 /* sum of the components above */
+  size_t peak;                  /* peak usage while creating */
+} FCMMEM;                       /* (includes temporary memory) */
+#endif
+
+#ifndef FCM_STATS_DEFINED       /* --- runtime statistics */
+#define FCM_STATS_DEFINED       /* (see fcm_stats()) */
+typedef struct {                /* --- statistics of an FC matrix */
+  size_t fills;                 /* number of tile fills */
+  size_t comp;                  /* number of computed elements */
+  size_t hits;                  /* number of elements served from */
+                                /* a tile or a half-stored matrix */
+  double bytes;                 /* bytes of data read by the kernels */
+  double time;                  /* wall time of the tile fills */
+  double busy;                  /* busy time of the threads */
+  double idle;                  /* idle time of the threads in fills */
+  double sync;                  /* time the caller spends in posting */
+} FCMSTATS;                     /* and waiting for fills while no */
+#endif                          /* thread works (times in seconds) */
+
+#ifndef FCM_SLOT_DEFINED        /* --- multi-tile cache */
+#define FCM_SLOT_DEFINED        /* (see FCM_SLOTS, fcm_slot()) */
+typedef struct {                /* --- tile slots of the cache */
+  int    cnt;                   /* number of tile slots (K) */
+  int    hand;                  /* clock hand for replacement */
+  int    bits;                  /* log2 of the hash table size */
+  DIM    *key;                  /* first row/column of slot tiles */
+  int    *hash;                 /* hash table: tile -> slot (or -1) */
+  uint8_t *ref;                 /* reference bits of the slots */
+} FCMSLOT;                      /* (key, hash and ref: one block) */
+#endif
+
+typedef struct {                /* --- transform stage parameters */
+  int    mode;                  /* transforms (FCM_XFORM flags) */
+  REAL   clamp;                 /* bound for clamping (FCM_CLAMP) */
+  REAL   thresh;                /* threshold (FCM_BIN) */
+  int    isa;                   /* instruction sets of the kernels */
+} SFXNAME(FCMXF);               /* (see fcm_xfvec()) */
 
 typedef struct SFXNAME(fcmat) { /* --- a func. connectivity matrix */
   DIM    V;                     /* number of voxels */
   DIM    T;                     /* number of scans */
   DIM    X;                     /* size of padded/binarized data */
+  DIM    win, step;             /* window length and step (FCM_WINDOW) */
+  DIM    nwin;                  /* number of windows */
   int    mode;                  /* processing mode (e.g. FCM_PCC) */
   DIM    tile;                  /* size of tiles/blocks for caching */
-  double maxmem;                /* max. memory (in GiB) */
+  double maxmem;                /* max. memory (in bytes, <0: no limit,
+                                 * only for opened matrices and the
+                                 * variants fcmat1/2/3.c, which ignore
+                                 * FCM_MAXMEM; see FCM_MEMDEF) */
   DIM    nthd;                  /* number of threads for computation */
   void   *data;                 /* normalized/binarized data */
   void   *mem;                  /* allocated memory block */
   REAL   *cmap;                 /* map from n_11 to cosine values */
   REAL   *cache;                /* cached rectangle/triangle */
+  REAL   *slots;                /* tile slots (cache is one of them) */
+  FCMSLOT slot;                 /* management of the tile slots */
+  uint16_t *half;               /* half-stored triangle (fp16/bf16) */
+  void   *cnts;                 /* half-stored n_11 counts (tetra.) */
+  void   *map;                  /* memory-mapped file (fcm_open()) */
+  size_t mapsz;                 /* size of the mapped file */
+  size_t *toff;                 /* tile offsets (FCM_TILED, or NULL) */
+  int    fd;                    /* out-of-core store (-1 if none) */
+  void   *buf;                  /* buffer for tiles of the store */
+  double *avg;                  /* running means (FCM_ONLINE) */
+  double *mom;                  /* co-moments: variances, triangle */
   REAL   diag;                  /* value of diagonal element */
+  REAL   clamp;                 /* bound for clamping (FCM_CLAMP) */
+  REAL   thresh;                /* threshold (FCM_BIN) */
   REAL   value;                 /* value of current matrix element */
   DIM    row, col;              /* row and column of current element */
   DIM    ra, rb;                /* row    range of cached area */
   DIM    ca, cb;                /* column range of cached area */
+  REAL   *dst;                  /* destination of a tile fill */
+  DIM    dr, dc;                /* first row/column of that tile */
+  REAL   *ahead;                /* tile filled ahead (FCM_PIPE) */
+  int    pend;                  /* workers of a posted tile fill */
+  DIM    sub;                   /* size of sub-blocks (FCM_DYNAMIC) */
+  int    subn;                  /* number of sub-blocks of the tile */
+  int    subi;                  /* next sub-block to be filled */
   DIM    gr, gc;                /* rows/columns of grid */
   int    err;                   /* error status */
   THREAD *threads;              /* thread handles for parallelization */
   void   *work;                 /* data for worker threads */
   SFXNAME(FCMGETFN) *get;       /* element retrieval function */
   SFXNAME(FCMGETFN) *cget;      /* element retrieval function (cache) */
+  SFXNAME(FCMGETFN) *tget;      /* element retrieval function (threads,
+                                 * only set if slot.cnt > 1) */
+  int    isa;                   /* instruction sets used by kernels */
+  SFXNAME(FCMPAIRFN) *pair;     /* pair kernel (Pearson) */
+  FCMANDFN *pcand;              /* pair kernel (tetrachoric) */
+  FCMMEM use;                   /* memory usage of the components */
   #ifndef _WIN32                /* not yet available for Windows */
   int    join;                  /* flag for joining threads */
-  int    idle;                  /* number of idle threads */
-  MUTEX  mutex;                 /* access control variable */
-  TCOND  cond_idle;             /* notify main thread of idle worker */
-  TCOND  cond_work;             /* order threads to start working */
-  #endif                        /* (thread signaling/communication) */
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
-  int    cnt;                   /* number of times cache was filled */
-  double sum;                   /* total thread execution time */
-  double beg;                   /* loss due to thread start times */
-  double end;                   /* loss due to thread end   times */
-  #endif                        /* (for time loss computation) */
+  FCMJOB job;                   /* tile fill posted to the pool */
+  FCMBAR bar;                   /* barrier of dedicated workers */
+  #endif                        /* (shared with other matrices) */
+  FCMSTATS stats;               /* runtime statistics */
+  FCMSTATS *tst;                /* statistics of the threads */
+  double post[2];               /* start/end time of fcm_post() */
 } SFXNAME(FCMAT);               /* (functional connectivity matrix) */
 
 /*----------------------------------------------------------------------
@@ -185,8 +311,29 @@ extern REAL SFXNAME(fcm_error)  (SFXNAME(FCMAT) *fcm);
 
 extern REAL SFXNAME(fcm_get)    (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 
+extern size_t SFXNAME(fcm_memusage) (SFXNAME(FCMAT) *fcm, FCMMEM *mem);
+extern int    SFXNAME(fcm_memthd)   (SFXNAME(FCMAT) *fcm, size_t size,
+                                     int nthd);
+
+extern void SFXNAME(fcm_stats)  (SFXNAME(FCMAT) *fcm, FCMSTATS *stats,
+                                 int thd);
+extern void SFXNAME(fcm_xform)  (SFXNAME(FCMAT) *fcm, REAL *v, size_t n);
+extern void SFXNAME(fcm_xfvec)  (const SFXNAME(FCMXF) *xf, REAL *v,
+                                 size_t n);
+extern int  SFXNAME(fcm_isa)    (void);
+extern DIM  SFXNAME(fcm_winget) (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                 REAL *r);
 extern void SFXNAME(fcm_show)   (SFXNAME(FCMAT) *fcm);
 
+extern int  SFXNAME(fcm_save)   (SFXNAME(FCMAT) *fcm, const char *fname);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_open)   (const char *fname);
+
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_online) (REAL *data, DIM V, DIM T,
+                                 int mode, ...);
+extern int  SFXNAME(fcm_append) (SFXNAME(FCMAT) *fcm, const REAL *vol);
+
 /*----------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
@@ -197,6 +344,8 @@ extern void SFXNAME(fcm_show)   (SFXNAME(FCMAT) *fcm);
 #define fcm_value(m)        ((m)->value)
 #define fcm_error(m)        ((m)->err)
 #define fcm_get(m,r,c)      ((m)->get(m,r,c))
+#define fcm_tget(m,r,c)     (((m)->slot.cnt > 1) \
+                            ? (m)->tget(m,r,c) : (m)->get(m,r,c))
 #elif _FCM_PASS <= 1
 #define fcm_dim_flt(m)      ((m)->V)
 #define fcm_row_flt(m)      ((m)->row)
@@ -204,6 +353,8 @@ extern void SFXNAME(fcm_show)   (SFXNAME(FCMAT) *fcm);
 #define fcm_value_flt(m)    ((m)->value)
 #define fcm_error_flt(m)    ((m)->err)
 #define fcm_get_flt(m,r,c)  ((m)->get(m,r,c))
+#define fcm_tget_flt(m,r,c) (((m)->slot.cnt > 1) \
+                            ? (m)->tget(m,r,c) : (m)->get(m,r,c))
 #elif _FCM_PASS <= 2
 #define fcm_dim_dbl(m)      ((m)->V)
 #define fcm_row_dbl(m)      ((m)->row)
@@ -211,6 +362,8 @@ extern void SFXNAME(fcm_show)   (SFXNAME(FCMAT) *fcm);
 #define fcm_value_dbl(m)    ((m)->value)
 #define fcm_error_dbl(m)    ((m)->err)
 #define fcm_get_dbl(m,r,c)  ((m)->get(m,r,c))
+#define fcm_tget_dbl(m,r,c) (((m)->slot.cnt > 1) \
+                            ? (m)->tget(m,r,c) : (m)->get(m,r,c))
 #endif
 
 /*----------------------------------------------------------------------
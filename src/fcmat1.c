@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <stdarg.h>
 #include <time.h>
 #include <assert.h>
@@ -22,6 +23,7 @@
 #endif
 
 #include "fcmat1.h"
+#include "fcmat3.h"
 
 /*----------------------------------------------------------------------------
   Data Type Definition / Recursion Handling
@@ -72,9 +74,43 @@
   Function Prototypes
 ----------------------------------------------------------------------------*/
 extern REAL SFXNAME(fcm_pccotf) (FCMAT *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_pccr2z) (FCMAT *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_pccxf)  (FCMAT *fcm, DIM row, DIM col);
 extern REAL SFXNAME(fcm_tccotf) (FCMAT *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_tccr2z) (FCMAT *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_isa)    (void);
+extern int  SFXNAME(fcm_blksz)  (SFXNAME(FCMAT) *fcm);
+extern size_t SFXNAME(fcm_datasz) (SFXNAME(FCMAT) *fcm);
+extern int  SFXNAME(fcm_prep)   (SFXNAME(FCMAT) *fcm, REAL *data);
+extern REAL SFXNAME(fcm_xval)   (SFXNAME(FCMAT) *fcm, REAL r);
+extern int  SFXNAME(fcm_winprep) (SFXNAME(FCMAT) *fcm, REAL *data);
+extern void SFXNAME(fcm_wincc)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                 DIM k, DIM n, double *sum, REAL *r);
+extern REAL SFXNAME(fcm_pccwin) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+
+/*----------------------------------------------------------------------------
+  Function Prototypes (file functions defined in fcmat3.h)
+----------------------------------------------------------------------------*/
+extern REAL SFXNAME(fcm_full)     (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_xf)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_f16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#if defined FCM_ALL_ISA || defined __F16C__
+extern REAL SFXNAME(fcm_full_f16c)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#endif
+extern REAL SFXNAME(fcm_full_bf16)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n8)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n32) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(fcm_enc16)    (SFXNAME(FCMAT) *fcm, uint16_t *dst,
+                                   const REAL *src, size_t n);
+extern int  SFXNAME(fcm_save)     (SFXNAME(FCMAT) *fcm, const char *fname);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_open)     (const char *fname);
+extern void SFXNAME(fcm_unmap)    (SFXNAME(FCMAT) *fcm);
+extern REAL SFXNAME(fcm_onl)      (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void*SFXNAME(fcm_onlrows)  (void *p);
+extern void SFXNAME(fcm_onlupd)   (SFXNAME(FCMAT) *fcm, double w);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_online)   (REAL *data, DIM V, DIM T, int mode, ...);
+extern int  SFXNAME(fcm_append)   (SFXNAME(FCMAT) *fcm, const REAL *vol);
 
 /*----------------------------------------------------------------------------
   Functions
@@ -83,6 +119,7 @@ extern REAL SFXNAME(fcm_tccr2z) (FCMAT *fcm, DIM row, DIM col);
 SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 {                               /* --- create a func. connect. matrix */
   SFXNAME(FCMAT) *fcm;          /* func. con. matrix to be created */
+  va_list args;                 /* list of variable arguments */
 
   assert(data && (V > 1) && (T > 1)); /* check the function arguments */
   fcm = (SFXNAME(FCMAT)*)malloc(sizeof(SFXNAME(FCMAT)));
@@ -90,60 +127,88 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   fcm->V       = V;             /* note the number of voxels */
   fcm->T       = T;             /* and  the number of scans */
   fcm->X       = T;             /* default: data blocks like scans */
+  fcm->tile    = 0;             /* (elements are computed on demand) */
   fcm->mode    = mode;          /* note the processing mode */
   fcm->mem     = NULL;          /* clear memory block, */
   fcm->cmap    = NULL;          /* cosine map and cache */
-  fcm->diag    = (REAL)((mode & FCM_R2Z) ? R2Z_MAX : 1.0);
+  fcm->cache   = NULL;          /* (no cache in this variant, */
+  fcm->half    = NULL;          /* cleared for fcm_save()) */
+  fcm->slots   = NULL;
+  fcm->slot.cnt = 1;
+  fcm->slot.key = NULL;
+  fcm->dst     = fcm->ahead = NULL;
+  fcm->pend    = 0;
+  fcm->cnts    = NULL;
+  fcm->avg     = NULL;          /* (no online moments, */
+  fcm->mom     = NULL;          /* see fcm_online()) */
+  fcm->map     = NULL;          /* (not opened from a file) */
+  fcm->toff    = NULL;
+  fcm->diag    = 1;             /* (transformed below) */
+  fcm->clamp   = 1;             /* default: no clamping and */
+  fcm->thresh  = 0;             /* binarization at zero */
+  fcm->win     = fcm->step = 0; /* default: no sliding windows */
+  fcm->nwin    = 0;
   fcm->value   = fcm->diag;     /* set the value and coordinates */
   fcm->row     = fcm->col = 0;  /* of the current element */
   fcm->ra      = 0; fcm->rb = V;
   fcm->ca      = 0; fcm->cb = V;/* init. the coordinate ranges */
   fcm->err     = 0;             /* clear the error status */
+  fcm->maxmem  = -1;            /* no memory limit */
+  memset(&fcm->use, 0, sizeof(FCMMEM));
+  fcm->use.base = sizeof(SFXNAME(FCMAT));
+  memset(&fcm->stats, 0, sizeof(FCMSTATS));
+  fcm->tst     = NULL;          /* clear the runtime statistics */
+  fcm->post[0] = fcm->post[1] = 0;
+
+  va_start(args, mode);         /* start variable arguments */
+  if (mode & FCM_THREAD)        /* skip the parameters that */
+    va_arg(args, int);          /* are not used by this variant */
+  if (mode & FCM_CACHE)         /* (threads, tile size, memory limit, */
+    va_arg(args, DIM);          /* store directory, tile slots) */
+  if (mode & FCM_MAXMEM)
+    va_arg(args, double);
+  if (mode & FCM_DISK)
+    va_arg(args, const char*);
+  if (mode & FCM_SLOTS)
+    va_arg(args, int);
+  if (mode & FCM_CLAMP)         /* get the bound for clamping */
+    fcm->clamp  = (REAL)va_arg(args, double);
+  if (mode & FCM_BIN)           /* get the threshold */
+    fcm->thresh = (REAL)va_arg(args, double);
+  if (mode & FCM_WINDOW) {      /* get the window length and step */
+    fcm->win  = va_arg(args, int);
+    fcm->step = va_arg(args, int);
+  }
+  va_end(args);                 /* end variable arguments */
 
   mode &= FCM_CORR;             /* get the correlation type */
-  if      (mode == FCM_PCC) {   /* if Pearson's correlation coeff. */
-    #ifdef __AVX__              /* use AVX if possible */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+7) & ~7); /* process blocks with 8 numbers */
-    #endif
-    #else                       /* otherwise fall back to SSE2 */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+1) & ~1); /* process blocks with 2 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #endif                      /* get the data block size */
-    #endif                      /* allocate memory for norm.ed data */
-    fcm->mem = malloc((size_t)V*(size_t)fcm->X *sizeof(REAL) +31);
-    if (!fcm->mem) { SFXNAME(fcm_delete)(fcm); return NULL; }
-    fcm->data = (REAL*)(((uintptr_t)fcm->mem +31) & ~(uintptr_t)31);
-    INIT_PCC(data, (int)V, (int)T, fcm->data, (int)fcm->X); }
-  else if (mode == FCM_TCC) {   /* if tetrachoric correlation coeff. */
-    #if defined __POPCNT__ \
-    &&  defined __SSE4_1__      /* use 128 bit and popcnt if possible */
-    fcm->X = 4 *(((int)T+127) >> 7);
-    #else                       /* otherwise fall back to LUT16 */
-    fcm->X = ((int)T+31) >> 5;  /* get block size of binarized data */
-    #endif
-    fcm->mem  =                 /* allocate memory for binarized data */
-    fcm->data = SFXNAME(binarize)(data, (int)V, (int)T, BIN_MEDIAN,BPI);
-    if (!fcm->data) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    fcm->cmap = SFXNAME(make_cmap)((int)T); /* create cosine map */
-    if (!fcm->cmap) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    init_popcnt(); }            /* initialize bit count table */
-  else {                        /* if unknown correlation variant */
+  if ((mode != FCM_PCC) && (mode != FCM_TCC)) {
     fprintf(stderr, "fcm_create: unknown correlation variant\n");
     free(fcm); return NULL;     /* print an error message */
   }                             /* and abort the function */
-
-  if (!(fcm->mode & FCM_R2Z))   /* if pure correlation coefficients */
-    fcm->get = (mode == FCM_PCC)
-             ? SFXNAME(fcm_pccotf) : SFXNAME(fcm_tccotf);
-  else {                        /* if to apply Fisher's r to z trans. */
-    fcm->get = (mode == FCM_PCC)
-             ? SFXNAME(fcm_pccr2z) : SFXNAME(fcm_tccr2z);
-  }                             /* get the element retrieval function */
+  if (fcm->mode & FCM_WINDOW) { /* if to summarize windowed corr.c. */
+    if ((mode != FCM_PCC)       /* (Pearson correlation only, */
+    ||  (fcm->win < 2) || (fcm->win > T) || (fcm->step < 1)) {
+      fprintf(stderr, "fcm_create: invalid sliding windows\n");
+      free(fcm); return NULL;   /* at least two scans per window) */
+    }                           /* get the number of windows */
+    fcm->nwin = (T -fcm->win) /fcm->step +1;
+  }
+  if (SFXNAME(fcm_prep)(fcm, data) != 0) {
+    SFXNAME(fcm_delete)(fcm); return NULL; }
+                                /* select kernels and prepare data */
+  fcm->diag  = (fcm->mode & FCM_WVAR) ? 0   /* (the variance of */
+             : SFXNAME(fcm_xval)(fcm, (REAL)1); /* windows is zero) */
+  fcm->value = fcm->diag;       /* transform the diagonal value */
+
+  if (mode == FCM_TCC)          /* tetrachoric: transform is folded */
+    fcm->get = SFXNAME(fcm_tccotf);     /* into the cosine map */
+  else if (fcm->mode & FCM_WINDOW)    /* sliding windows */
+    fcm->get = SFXNAME(fcm_pccwin);
+  else                          /* Pearson: apply transform stage */
+    fcm->get = (fcm->mode & FCM_XFORM)
+             ? SFXNAME(fcm_pccxf) : SFXNAME(fcm_pccotf);
+                                /* get the element retrieval function */
   fcm->cget = fcm->get;         /* get the element retrieval function */
 
   return fcm;                   /* return created FC matrix */
@@ -154,6 +219,8 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 void SFXNAME(fcm_delete) (SFXNAME(FCMAT) *fcm)
 {                               /* --- delete a func. connect. matrix */
   assert(fcm);                  /* check the function argument */
+  if (fcm->map)   SFXNAME(fcm_unmap)(fcm);
+  if (fcm->toff)  free(fcm->toff);
   if (fcm->cmap)  free(fcm->cmap);
   if (fcm->mem)   free(fcm->mem);/* delete cache, cosine map, */
   free(fcm);                    /* data, and the base structure */
@@ -5,10 +5,12 @@
 ----------------------------------------------------------------------------*/
 #ifndef FCMAT1_H
 
+#include <stdlib.h>
 #include "stats.h"
 #include "pcc.h"
 #include "binarize.h"
 #include "tetracc.h"
+#include "cpuinfo.h"
 #include "fcmat.h"
 
 /*----------------------------------------------------------------------------
@@ -38,6 +40,23 @@
 #define SFXNAME_2(n,s)  n##s    /* the two step recursion is needed */
 #endif                          /* to ensure proper expansion */
 
+/*--------------------------------------------------------------------------*/
+#define float  1                /* to check the definition of REAL */
+#define double 2
+
+#if   REAL == float             /* if single precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  0       /* clear indicator for double */
+#elif REAL == double            /* if double precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  1       /* set   indicator for double */
+#else
+#error "REAL must be either 'float' or 'double'"
+#endif
+
+#undef float                    /* delete definitions */
+#undef double                   /* used for type checking */
+
 /*--------------------------------------------------------------------------*/
 #define int         1           /* to check definitions */
 #define long        2           /* for certain types */
@@ -82,24 +101,588 @@
 /*----------------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------------*/
-#if   defined __AVX__           /* if AVX instructions available */
-#  define INIT_PCC SFXNAME(init_avx)
-#  define PAIR_PCC SFXNAME(pair_avx)
-#elif defined __SSE2__          /* if SSE2 instructions available */
-#  define INIT_PCC SFXNAME(init_sse2)
-#  define PAIR_PCC SFXNAME(pair_sse2)
-#else                           /* if neither extension available */
-#  define INIT_PCC SFXNAME(init_naive)
-#  define PAIR_PCC SFXNAME(pair_naive)
-#endif                          /* fall back to naive computations */
-
-#if defined __POPCNT__ && defined __SSE4_1__
-#  define PCAND_TCC pcand_m128i /* use m128i implementation */
-#  define BPI       128         /* 128 bits per integer */
-#else
-#  define PCAND_TCC pcand_lut16 /* use lut16 implemenation */
-#  define BPI       32          /* 32 bits per integer */
+#ifndef FCM_TARGET              /* if not yet defined */
+#if defined __GNUC__ \
+&& (defined __x86_64__ || defined __i386__)
+#  define FCM_ALL_ISA           /* compile kernels for all instruction */
+#  define FCM_TARGET(t)  __attribute__((target(t)))
+#  include <immintrin.h>        /* sets (selected at run time) */
+#else                           /* otherwise compile only the kernels */
+#  define FCM_TARGET(t)         /* for the instruction sets that are */
+#endif                          /* enabled by the compiler options */
+#endif
+
+#ifndef WIN_BUF                 /* --- sliding windows (FCM_WINDOW) */
+#define WIN_BUF     256         /* windows transformed at a time */
+#endif
+#define WIN_EPS     1e-12       /* min. rel. sum of squared deviations */
+
+/*----------------------------------------------------------------------------
+  Kernel Selection Functions
+----------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_isa) (void)
+{                               /* --- get usable instruction sets */
+  int        isa = 0;           /* set of instruction set flags */
+  const char *s;                /* mask from the environment */
+
+  #if defined FCM_ALL_ISA || defined __SSE2__
+  if (hasSSE2())   isa |= FCM_ISA_SSE2;
+  #endif                        /* check only for the instruction */
+  #if defined FCM_ALL_ISA || defined __AVX__
+  if (hasAVX())    isa |= FCM_ISA_AVX;
+  #endif                        /* sets for which kernels have */
+  #if defined FCM_ALL_ISA || defined __AVX2__
+  if (hasAVX2())   isa |= FCM_ISA_AVX2;
+  #endif                        /* been compiled */
+  #if defined FCM_ALL_ISA || (defined __POPCNT__ && defined __SSE4_1__)
+  if (hasPOPCNT() && hasSSE41()) isa |= FCM_ISA_POPCNT;
+  #endif
+  #if   defined FCM_ALL_ISA     /* (cpuinfo does not report AVX-512) */
+  if (__builtin_cpu_supports("avx512f")) {
+    isa |= FCM_ISA_AVX512;
+    if (__builtin_cpu_supports("avx512bw"))        isa |= FCM_ISA_AVX512BW;
+    if (__builtin_cpu_supports("avx512vpopcntdq")) isa |= FCM_ISA_VPOPCNT;
+    if (__builtin_cpu_supports("avx512bf16"))    isa |= FCM_ISA_AVX512BF16;
+  }                             /* (neither does it report F16C) */
+  if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+    isa |= FCM_ISA_F16C;
+  #else                         /* if compiled only for one target */
+  #ifdef __AVX512F__
+  isa |= FCM_ISA_AVX512;
+  #endif
+  #if defined __AVX512F__ && defined __AVX512BW__
+  isa |= FCM_ISA_AVX512BW;
+  #endif
+  #if defined __AVX512F__ && defined __AVX512VPOPCNTDQ__
+  isa |= FCM_ISA_VPOPCNT;
+  #endif
+  #if defined __AVX512F__ && defined __AVX512BF16__
+  isa |= FCM_ISA_AVX512BF16;
+  #endif
+  #if defined __AVX__ && defined __F16C__
+  isa |= FCM_ISA_F16C;
+  #endif
+  #endif
+  s = getenv("FCM_ISA");        /* restrict the instruction sets */
+  if (s) isa &= (int)strtol(s, NULL, 0);   /* (e.g. for testing) */
+  return isa;                   /* return the instruction sets */
+}  /* fcm_isa() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_winprep) (SFXNAME(FCMAT) *fcm, REAL *data)
+{                               /* --- prepare data for windows */
+  DIM    V = fcm->V;            /* number of voxels */
+  DIM    T = fcm->T;            /* number of scans */
+  DIM    w = fcm->win;          /* window length */
+  DIM    s = fcm->step;         /* window step */
+  DIM    W = fcm->nwin;         /* number of windows */
+  DIM    i, k, t, a;            /* loop variables, window start */
+  const REAL *d;                /* series of a voxel */
+  double *x, *m, *g;            /* standardized series, window stats. */
+  double p, q, v;               /* sums of values and squares */
+
+  fcm->mem = malloc(fcm->use.data);
+  if (!fcm->mem) return -1;     /* allocate memory for the series */
+  fcm->data = fcm->mem;         /* and the window statistics */
+  for (i = 0; i < V; i++) {     /* traverse the voxels */
+    d = data +(size_t)i *(size_t)T;
+    x = (double*)fcm->data +(size_t)i *(size_t)T;
+    m = (double*)fcm->data +(size_t)V *(size_t)T +(size_t)i *(size_t)W;
+    g = m +(size_t)V *(size_t)W;
+    for (p = 0, t = 0; t < T; t++) p += (double)d[t];
+    p /= (double)T;             /* standardize the whole series */
+    for (q = 0, t = 0; t < T; t++) q += ((double)d[t]-p)*((double)d[t]-p);
+    q = (q > 0) ? 1/sqrt(q /(double)T) : 0;
+    for (t = 0; t < T; t++)     /* (so that the sliding sums */
+      x[t] = ((double)d[t]-p) *q; /* suffer little cancellation) */
+    for (p = q = 0, t = 0; t < w; t++) { p += x[t]; q += x[t]*x[t]; }
+    for (k = 0; k < W; k++) {   /* traverse the windows */
+      if (k > 0) {              /* if not the first window */
+        a = k*s;                /* get the start of the window */
+        if (s >= w) {           /* if the windows do not overlap, */
+          for (p = q = 0, t = a; t < a+w; t++) {   /* sum anew */
+            p += x[t]; q += x[t]*x[t]; } }
+        else {                  /* if the windows overlap, */
+          for (t = a-s; t < a; t++)   /* slide the sums */
+            { p -= x[t]; q -= x[t]*x[t]; }
+          for (t = a-s+w; t < a+w; t++)
+            { p += x[t]; q += x[t]*x[t]; }
+        }                       /* (the sums of a voxel are updated */
+      }                         /* with T additions in total) */
+      m[k] = p /(double)w;      /* compute the mean and the inverse */
+      v    = q -p*m[k];         /* root of the sum of squared */
+      g[k] = (v > WIN_EPS *(double)w) ? 1/sqrt(v) : 0;
+    }                           /* deviations of the window */
+  }                             /* (constant windows: no corr.) */
+  return 0;                     /* return 'ok' */
+}  /* fcm_winprep() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_blksz) (SFXNAME(FCMAT) *fcm)
+{                               /* --- get data block size */
+  int T = (int)fcm->T;          /* number of scans */
+  int k;                        /* block size (bytes/bits) */
+
+  fcm->isa = SFXNAME(fcm_isa)();/* get the usable instruction sets */
+  if (fcm->mode & FCM_WINDOW) { /* sliding windows: series of doubles */
+    fcm->X = fcm->T;            /* without padding, followed by the */
+    return (int)sizeof(double); /* window means and inverse roots */
+  }                             /* of the sums of squared deviations */
+  if ((fcm->mode & FCM_CORR) == FCM_PCC) {
+    k = 16;                     /* default: 16 byte blocks (SSE2) */
+    #if defined FCM_ALL_ISA || defined __AVX__
+    if (fcm->isa & FCM_ISA_AVX)    /* use AVX if possible */
+      k = 32;                   /* with 32 byte blocks */
+    #endif
+    fcm->X = (T +k/(int)sizeof(REAL)-1) & ~(k/(int)sizeof(REAL)-1);
+    return k;                   /* get the padded series length */
+  }                             /* and return the block size */
+  k = 32;                       /* default: lut16 with 32 bit blocks */
+  #if defined FCM_ALL_ISA || (defined __POPCNT__ && defined __SSE4_1__)
+  if (fcm->isa & FCM_ISA_POPCNT) k = 128;
+  #endif                        /* use 128 bit and popcnt if possible */
+  fcm->X = (k/32) *((T +k-1)/k);/* get the block size of binar. data */
+  return k;                     /* and return the block size */
+}  /* fcm_blksz() */
+
+/*--------------------------------------------------------------------------*/
+
+inline size_t SFXNAME(fcm_datasz) (SFXNAME(FCMAT) *fcm)
+{                               /* --- get size of prepared data */
+  if (fcm->mode & FCM_WINDOW)   /* sliding windows */
+    return (size_t)fcm->V *((size_t)fcm->T +2*(size_t)fcm->nwin)
+         * sizeof(double);
+  if ((fcm->mode & FCM_CORR) == FCM_PCC)
+    return (size_t)fcm->V *(size_t)fcm->X *sizeof(REAL) +31;
+  return (size_t)fcm->V *(size_t)fcm->X *sizeof(uint32_t);
+}  /* fcm_datasz() */           /* (fcm_blksz() must have been called) */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_prep) (SFXNAME(FCMAT) *fcm, REAL *data)
+{                               /* --- prepare data for the kernels */
+  int V = (int)fcm->V;          /* number of voxels */
+  int T = (int)fcm->T;          /* number of scans */
+  int k;                        /* block size (bytes/bits) */
+
+  k = SFXNAME(fcm_blksz)(fcm);  /* get the block size */
+  fcm->use.data = SFXNAME(fcm_datasz)(fcm);
+  if (fcm->mode & FCM_WINDOW)   /* sliding windows: standardize */
+    return SFXNAME(fcm_winprep)(fcm, data);   /* the series */
+  if ((fcm->mode & FCM_CORR) == FCM_PCC) {
+    fcm->mem = malloc(fcm->use.data);
+    if (!fcm->mem) return -1;   /* allocate memory for norm.ed data */
+    fcm->data = (REAL*)(((uintptr_t)fcm->mem +31) & ~(uintptr_t)31);
+    #if defined FCM_ALL_ISA || defined __AVX__
+    if (fcm->isa & FCM_ISA_AVX) {
+      SFXNAME(init_avx) (data, V, T, (REAL*)fcm->data, (int)fcm->X);
+      fcm->pair = SFXNAME(pair_avx);
+      return 0;                 /* (the pair kernel of the corr lib. */
+    }                           /* matches pccx() bit for bit) */
+    #endif
+    #if defined FCM_ALL_ISA || defined __SSE2__
+    if (fcm->isa & FCM_ISA_SSE2) {
+      SFXNAME(init_sse2)(data, V, T, (REAL*)fcm->data, (int)fcm->X);
+      fcm->pair = SFXNAME(pair_sse2); return 0; }
+    #endif                      /* normalize the data and */
+    SFXNAME(init_naive)(data, V, T, (REAL*)fcm->data, (int)fcm->X);
+    fcm->pair = SFXNAME(pair_naive);  /* get the pair kernel */
+    return 0;                   /* (fall back to naive computations) */
+  }
+  fcm->pcand = pcand_lut16;     /* default: lut16 with 32 bit blocks */
+  #if defined FCM_ALL_ISA || (defined __POPCNT__ && defined __SSE4_1__)
+  if (k == 128) fcm->pcand = pcand_m128i;
+  #endif                        /* get the pair kernel */
+  fcm->mem  =                   /* allocate memory for binarized data */
+  fcm->data = SFXNAME(binarize)(data, V, T, BIN_MEDIAN, k);
+  if (!fcm->data) return -1;
+  fcm->cmap = SFXNAME(make_cmap)(T);  /* create cosine map */
+  if (!fcm->cmap) return -1;    /* and fold the transform into it */
+  SFXNAME(fcm_xform)(fcm, fcm->cmap, (size_t)T+1);
+  fcm->use.cmap = (size_t)(T+1) *sizeof(REAL);
+  init_popcnt();                /* initialize bit count table */
+  return 0;                     /* return 'ok' */
+}  /* fcm_prep() */
+
+/*--------------------------------------------------------------------------*/
+
+inline size_t SFXNAME(fcm_memusage) (SFXNAME(FCMAT) *fcm, FCMMEM *mem)
+{                               /* --- get the memory usage */
+  assert(fcm);                  /* check the function argument */
+  fcm->use.total = fcm->use.base +fcm->use.data +fcm->use.cmap
+                 + fcm->use.cache +fcm->use.thread;
+  if (fcm->use.peak < fcm->use.total)
+    fcm->use.peak = fcm->use.total;
+  if (mem) *mem = fcm->use;     /* sum the components and */
+  return fcm->use.total;        /* return the total usage */
+}  /* fcm_memusage() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_memthd) (SFXNAME(FCMAT) *fcm, size_t size,
+                                int nthd)
+{                               /* --- threads that fit memory limit */
+  double z;                     /* remaining memory */
+
+  assert(fcm && (nthd >= 0));   /* check the function arguments */
+  if ((fcm->maxmem < 0) || (size == 0))
+    return nthd;                /* if there is no limit, keep threads */
+  z = fcm->maxmem -(double)SFXNAME(fcm_memusage)(fcm, NULL);
+  if (z < (double)nthd *(double)size) {
+    nthd = (z > 0) ? (int)(z /(double)size) : 0;
+    WARNING("number of threads reduced to %d to enforce the specified "
+            "memory limit.\n", nthd);
+  }                             /* reduce the number of threads */
+  return nthd;                  /* return the number of threads */
+}  /* fcm_memthd() */
+
+/*----------------------------------------------------------------------------
+  Post-correlation Transform
+----------------------------------------------------------------------------*/
+/* The transform stage maps correlation coefficients to the values    */
+/* that are stored and returned: absolute value (FCM_ABS), clamping   */
+/* to [-c,+c] (FCM_CLAMP), Fisher's r-to-z transform (FCM_R2Z) and    */
+/* binarization at a threshold (FCM_BIN), in this order. It is run    */
+/* over whole rows of a tile (or strips of a half-stored triangle);   */
+/* the r-to-z transform uses a vectorized atanh(), single elements a  */
+/* scalar copy of it, so that they match the cached values. For       */
+/* tetrachoric correlation the transform is folded into the cosine    */
+/* map (see fcm_prep()).                                              */
+
+#define XF_BLK      1024        /* elements per block of the stage */
+
+#undef  XF_VEC                  /* vector operations for atanh() */
+#undef  XF_LEN                  /* (depend on the type of REAL, */
+#undef  XF_SET1                 /* so they are redefined in each */
+#undef  XF_BITS                 /* pass of the recursion) */
+#undef  XF_LOADU
+#undef  XF_STOREU
+#undef  XF_ADD
+#undef  XF_SUB
+#undef  XF_MUL
+#undef  XF_DIV
+#undef  XF_AND
+#undef  XF_OR
+#undef  XF_XOR
+#undef  XF_CMP
+#undef  XF_BLEND
+#undef  XF_SRLI
+#undef  XF_SHIFT
+#undef  XF_SIGN
+#undef  XF_MANT
+#undef  XF_ONE
+#undef  XF_MAGIC
+#undef  XF_BIAS
+#undef  XF_TERMS
+#undef  XF_UINT
+
+#if REAL_IS_DOUBLE              /* if double precision data */
+#define XF_VEC      __m256d     /* 4 doubles per AVX vector */
+#define XF_LEN      4
+#define XF_SET1     _mm256_set1_pd
+#define XF_BITS(b)  _mm256_castsi256_pd(_mm256_set1_epi64x((long long)(b)))
+#define XF_LOADU    _mm256_loadu_pd
+#define XF_STOREU   _mm256_storeu_pd
+#define XF_ADD      _mm256_add_pd
+#define XF_SUB      _mm256_sub_pd
+#define XF_MUL      _mm256_mul_pd
+#define XF_DIV      _mm256_div_pd
+#define XF_AND      _mm256_and_pd
+#define XF_OR       _mm256_or_pd
+#define XF_XOR      _mm256_xor_pd
+#define XF_CMP      _mm256_cmp_pd
+#define XF_BLEND    _mm256_blendv_pd
+#define XF_SRLI(x)  _mm256_castsi256_pd(_mm256_srli_epi64( \
+                      _mm256_castpd_si256(x), XF_SHIFT))
+#define XF_SHIFT    52          /* number of mantissa bits */
+#define XF_SIGN     0x8000000000000000ULL
+#define XF_MANT     0x000fffffffffffffULL
+#define XF_ONE      0x3ff0000000000000ULL
+#define XF_MAGIC    0x4330000000000000ULL
+#define XF_BIAS     4503599627371519.0  /* 2^52 +1023 */
+#define XF_TERMS    12          /* terms of the atanh() series */
+#define XF_UINT     uint64_t    /* integer type of the same size */
+#else                           /* if single precision data */
+#define XF_VEC      __m256      /* 8 floats per AVX vector */
+#define XF_LEN      8
+#define XF_SET1     _mm256_set1_ps
+#define XF_BITS(b)  _mm256_castsi256_ps(_mm256_set1_epi32((int)(b)))
+#define XF_LOADU    _mm256_loadu_ps
+#define XF_STOREU   _mm256_storeu_ps
+#define XF_ADD      _mm256_add_ps
+#define XF_SUB      _mm256_sub_ps
+#define XF_MUL      _mm256_mul_ps
+#define XF_DIV      _mm256_div_ps
+#define XF_AND      _mm256_and_ps
+#define XF_OR       _mm256_or_ps
+#define XF_XOR      _mm256_xor_ps
+#define XF_CMP      _mm256_cmp_ps
+#define XF_BLEND    _mm256_blendv_ps
+#define XF_SRLI(x)  _mm256_castsi256_ps(_mm256_srli_epi32( \
+                      _mm256_castps_si256(x), XF_SHIFT))
+#define XF_SHIFT    23          /* number of mantissa bits */
+#define XF_SIGN     0x80000000U
+#define XF_MANT     0x007fffffU
+#define XF_ONE      0x3f800000U
+#define XF_MAGIC    0x4b000000U
+#define XF_BIAS     8388735.0   /* 2^23 +127 */
+#define XF_TERMS    5           /* terms of the atanh() series */
+#define XF_UINT     uint32_t    /* integer type of the same size */
+#endif
+
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __AVX2__
+
+FCM_TARGET("avx2")
+static inline void SFXNAME(r2z_avx2) (REAL *v, size_t n)
+{                               /* --- Fisher's r-to-z (AVX2) */
+  XF_VEC x, a, r, u, q, e, m, s, z, p, c;   /* intermediates */
+  XF_VEC one  = XF_SET1((REAL)1);
+  XF_VEC two  = XF_SET1((REAL)2);
+  XF_VEC half = XF_SET1((REAL)0.5);
+  XF_VEC hi   = XF_SET1((REAL)(1-R2Z_EPS));
+  XF_VEC zmax = XF_SET1((REAL)R2Z_MAX);
+  XF_VEC sqr2 = XF_SET1((REAL)1.41421356237309504880);
+  XF_VEC ln2h = XF_SET1((REAL)0.34657359027997265471);
+  XF_VEC bias = XF_SET1((REAL)XF_BIAS);
+  XF_VEC sign = XF_BITS(XF_SIGN);
+  XF_VEC mant = XF_BITS(XF_MANT);
+  XF_VEC ebit = XF_BITS(XF_ONE);
+  XF_VEC mgc  = XF_BITS(XF_MAGIC);
+  size_t i; int k;              /* loop variables */
+
+  for (i = 0; i < n; i += XF_LEN) {
+    x = XF_LOADU(v+i);          /* atanh(-a) = -atanh(a), */
+    a = XF_XOR(x, XF_AND(x, sign)); /* atanh(a) = 1/2 log1p(2a/(1-a)) */
+    u = XF_DIV(XF_MUL(two, a), XF_SUB(one, a));
+    q = XF_ADD(one, u);         /* q = 1+u loses the low bits of u, */
+    c = XF_DIV(XF_SUB(u, XF_SUB(q, one)), q);  /* log1p(u) = log q +c */
+    e = XF_SUB(XF_OR(XF_SRLI(q), mgc), bias);
+    m = XF_OR(XF_AND(q, mant), ebit);
+    z = XF_CMP(m, sqr2, _CMP_GT_OQ);
+    m = XF_BLEND(m, XF_MUL(m, half), z);
+    e = XF_ADD(e, XF_AND(z, one));  /* q = m 2^e, m in [0.707,1.414) */
+    s = XF_DIV(XF_SUB(m, one), XF_ADD(m, one));
+    z = XF_MUL(s, s);           /* log m = 2 atanh(s), s = (m-1)/(m+1) */
+    p = XF_SET1((REAL)1/(REAL)(2*XF_TERMS-1));
+    for (k = XF_TERMS-2; k >= 0; k--)  /* atanh(s)/s = 1 +s^2/3 ... */
+      p = XF_ADD(XF_MUL(p, z), XF_SET1((REAL)1/(REAL)(2*k+1)));
+    r = XF_ADD(XF_MUL(e, ln2h), XF_ADD(XF_MUL(s, p), XF_MUL(half, c)));
+    r = XF_BLEND(r, zmax, XF_CMP(a, hi, _CMP_GT_OQ));
+    XF_STOREU(v+i, XF_OR(r, XF_AND(x, sign)));
+  }                             /* combine exponent and mantissa, */
+}  /* r2z_avx2() */             /* saturate and restore the sign */
+
+/*--------------------------------------------------------------------------*/
+
+static inline REAL SFXNAME(r2z_one) (REAL x)
+{                               /* --- Fisher's r-to-z (one value) */
+  REAL    a, r, u, q, e, m, s, z, p, c; /* intermediates */
+  XF_UINT b;                    /* bits of a floating point number */
+  int     k;                    /* loop variable */
+
+  a = (x < 0) ? -x : x;         /* same operations as r2z_avx2() */
+  u = ((REAL)2*a) /((REAL)1-a); /* in the same order, so that the */
+  q = (REAL)1 +u;               /* results are identical */
+  c = (u -(q -(REAL)1)) /q;     /* (contraction to fma is off */
+  memcpy(&b, &q, sizeof(b));    /* with -std=c99) */
+  e = (REAL)(b >> XF_SHIFT) -(REAL)(XF_ONE >> XF_SHIFT);
+  b = (b & XF_MANT) | XF_ONE;   /* q = m 2^e, m in [0.707,1.414) */
+  memcpy(&m, &b, sizeof(m));
+  if (m > (REAL)1.41421356237309504880) {
+    m *= (REAL)0.5; e += (REAL)1; }
+  s = (m -(REAL)1) /(m +(REAL)1);
+  z = s*s;                      /* log m = 2 atanh(s) */
+  p = (REAL)1/(REAL)(2*XF_TERMS-1);
+  for (k = XF_TERMS-2; k >= 0; k--)
+    p = p*z +(REAL)1/(REAL)(2*k+1);
+  r = e*(REAL)0.34657359027997265471 +(s*p +(REAL)0.5*c);
+  if (a > (REAL)(1-R2Z_EPS)) r = (REAL)R2Z_MAX;
+  return (x < 0) ? -r : r;      /* saturate and restore the sign */
+}  /* r2z_one() */
+
 #endif
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_xfvec) (const SFXNAME(FCMXF) *xf, REAL *v,
+                                size_t n)
+{                               /* --- apply a transform stage */
+  REAL   c = xf->clamp;         /* bound for clamping */
+  REAL   t = xf->thresh;        /* threshold for binarization */
+  size_t i, k, b;               /* loop variables, block size */
+  #if defined FCM_ALL_ISA || defined __AVX2__
+  REAL   x[XF_LEN];             /* buffer for the last elements */
+  #endif
+
+  assert(xf && (v || (n <= 0)));  /* check the function arguments */
+  for (k = 0; k < n; k += b) {  /* traverse the blocks */
+    b = (n-k < XF_BLK) ? n-k : XF_BLK;
+    if (xf->mode & FCM_ABS)     /* absolute value */
+      for (i = k; i < k+b; i++) v[i] = (v[i] < 0) ? -v[i] : v[i];
+    if (xf->mode & FCM_CLAMP)   /* clamp to [-c,+c] */
+      for (i = k; i < k+b; i++)
+        v[i] = (v[i] > c) ? c : (v[i] < -c) ? -c : v[i];
+    if (xf->mode & FCM_R2Z) {   /* Fisher's r-to-z transform */
+      #if defined FCM_ALL_ISA || defined __AVX2__
+      if (xf->isa & FCM_ISA_AVX2) {
+        i = b & ~(size_t)(XF_LEN-1);
+        SFXNAME(r2z_avx2)(v+k, i);
+        if (i < b) {            /* transform full vectors directly */
+          memset(x, 0, sizeof(x));  /* and the remaining elements */
+          memcpy(x, v+k+i, (b-i) *sizeof(REAL));  /* in a buffer */
+          SFXNAME(r2z_avx2)(x, XF_LEN);
+          memcpy(v+k+i, x, (b-i) *sizeof(REAL));
+        } }
+      else
+      #endif
+      for (i = k; i < k+b; i++) v[i] = fisher_r2z(v[i]);
+    }
+    if (xf->mode & FCM_BIN)     /* binarize at the threshold */
+      for (i = k; i < k+b; i++) v[i] = (v[i] >= t) ? (REAL)1 : (REAL)0;
+  }
+}  /* fcm_xfvec() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_xform) (SFXNAME(FCMAT) *fcm, REAL *v, size_t n)
+{                               /* --- apply the transform stage */
+  SFXNAME(FCMXF) xf;            /* parameters of the transform stage */
+
+  assert(fcm);                  /* check the function argument */
+  xf.mode   = fcm->mode;        /* collect the parameters */
+  xf.clamp  = fcm->clamp;       /* of the matrix */
+  xf.thresh = fcm->thresh;
+  xf.isa    = fcm->isa;
+  SFXNAME(fcm_xfvec)(&xf, v, n);/* and transform the vector */
+}  /* fcm_xform() */
+
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_xval) (SFXNAME(FCMAT) *fcm, REAL r)
+{                               /* --- transform a single value */
+  assert(fcm);                  /* check the function argument */
+  if (fcm->mode & FCM_ABS)      /* absolute value */
+    r = (r < 0) ? -r : r;       /* (same steps as fcm_xform(), */
+  if (fcm->mode & FCM_CLAMP)    /* but without a padded vector) */
+    r = (r >  fcm->clamp) ?  fcm->clamp
+      : (r < -fcm->clamp) ? -fcm->clamp : r;
+  if (fcm->mode & FCM_R2Z) {    /* Fisher's r-to-z transform */
+    #if defined FCM_ALL_ISA || defined __AVX2__
+    if (fcm->isa & FCM_ISA_AVX2) r = SFXNAME(r2z_one)(r);
+    else
+    #endif
+    r = fisher_r2z(r);
+  }
+  if (fcm->mode & FCM_BIN)      /* binarize at the threshold */
+    r = (r >= fcm->thresh) ? (REAL)1 : (REAL)0;
+  return r;                     /* return the transformed value */
+}  /* fcm_xval() */
+
+/*----------------------------------------------------------------------------
+  Sliding-window Functions
+----------------------------------------------------------------------------*/
+/* With FCM_WINDOW an element is the mean (FCM_WVAR: the variance) of    */
+/* the Pearson correlation coefficients of a pair in the windows of w    */
+/* scans that start at 0, s, 2s, ... The sum of products of a pair is    */
+/* slid from window to window (s products leave, s enter), so all        */
+/* windows of a pair cost O(T) instead of O(w) each, and the means and   */
+/* deviations of the windows are computed only once per voxel (see       */
+/* fcm_winprep()). The transform stage is applied to the coefficients    */
+/* of the windows before they are summarized (e.g. the mean of z).       */
+
+inline void SFXNAME(fcm_wincc) (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                DIM k, DIM n, double *sum, REAL *r)
+{                               /* --- corr. coeffs. of windows */
+  DIM    V = fcm->V;            /* number of voxels */
+  DIM    T = fcm->T;            /* number of scans */
+  DIM    W = fcm->nwin;         /* number of windows */
+  DIM    w = fcm->win;          /* window length */
+  DIM    s = fcm->step;         /* window step */
+  const double *x, *y;          /* standardized series of the pair */
+  const double *m, *g;          /* window means and inverse roots */
+  double z = *sum;              /* sum of products of the window */
+  double c;                     /* correlation coefficient */
+  DIM    t, a, e;               /* loop variable, window start */
+
+  x = (const double*)fcm->data +(size_t)row *(size_t)T;
+  y = (const double*)fcm->data +(size_t)col *(size_t)T;
+  m = (const double*)fcm->data +(size_t)V *(size_t)T;
+  g = m +(size_t)V *(size_t)W;  /* get the series and statistics */
+  for (e = k+n; k < e; k++) {   /* traverse the windows */
+    a = k*s;                    /* get the start of the window */
+    if ((k <= 0) || (s >= w)) { /* if first window or no overlap, */
+      for (z = 0, t = a; t < a+w; t++)  /* sum the products anew */
+        z += x[t]*y[t]; }
+    else {                      /* if the window overlaps */
+      for (t = a-s;   t < a;   t++) z -= x[t]*y[t];
+      for (t = a-s+w; t < a+w; t++) z += x[t]*y[t];
+    }                           /* slide the sum of products */
+    c = (z -(double)w *m[(size_t)row*(size_t)W +(size_t)k]
+                      *m[(size_t)col*(size_t)W +(size_t)k])
+      * g[(size_t)row*(size_t)W +(size_t)k]
+      * g[(size_t)col*(size_t)W +(size_t)k];
+    *r++ = (REAL)((c > 1) ? 1 : (c < -1) ? -1 : c);
+  }                             /* compute the corr. coefficient */
+  *sum = z;                     /* note the sum of products */
+}  /* fcm_wincc() */            /* for the next call */
+
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_pccwin) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- summarize windowed corr.c. */
+  REAL   r[WIN_BUF];            /* coefficients of some windows */
+  double z = 0;                 /* sum of products of a window */
+  double a = 0, b = 0;          /* sums of coefficients and squares */
+  DIM    k, n, i;               /* loop variables */
+
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  if (row > col) {              /* ensure col >= row (upper triangle) */
+    DIM t = row; row = col; col = t; }
+  for (k = 0; k < fcm->nwin; k += n) {
+    n = (fcm->nwin -k < WIN_BUF) ? fcm->nwin -k : WIN_BUF;
+    SFXNAME(fcm_wincc)(fcm, row, col, k, n, &z, r);
+    if (fcm->mode & FCM_XFORM)  /* compute the coefficients */
+      SFXNAME(fcm_xform)(fcm, r, (size_t)n);  /* and transform them */
+    for (i = 0; i < n; i++) { a += (double)r[i]; b += (double)r[i]*r[i]; }
+  }                             /* sum the (transformed) coefficients */
+  a /= (double)fcm->nwin;       /* compute the mean */
+  if (!(fcm->mode & FCM_WVAR)) return (REAL)a;
+  b = b /(double)fcm->nwin -a*a;/* compute the variance */
+  return (REAL)((b > 0) ? b : 0);
+}  /* fcm_pccwin() */
+
+/*--------------------------------------------------------------------------*/
+
+inline DIM SFXNAME(fcm_winget) (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                REAL *r)
+{                               /* --- get coefficients of windows */
+  double z = 0;                 /* sum of products of a window */
+  DIM    k;                     /* loop variable */
+
+  assert(fcm && r               /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (!(fcm->mode & FCM_WINDOW) || !fcm->data) {
+    fprintf(stderr, "fcm_winget: matrix has no sliding windows\n");
+    return -1;                  /* (the series are needed, so no */
+  }                             /* saved or online matrix) */
+  if (row == col) {             /* if diagonal element */
+    r[0] = SFXNAME(fcm_xval)(fcm, (REAL)1);
+    for (k = 1; k < fcm->nwin; k++) r[k] = r[0];
+    return fcm->nwin;           /* all windows have the */
+  }                             /* transformed +1.0 */
+  if (row > col) {              /* ensure col >= row (upper triangle) */
+    DIM t = row; row = col; col = t; }
+  SFXNAME(fcm_wincc)(fcm, row, col, 0, fcm->nwin, &z, r);
+  if (fcm->mode & FCM_XFORM)    /* compute the coefficients */
+    SFXNAME(fcm_xform)(fcm, r, (size_t)fcm->nwin);
+  return fcm->nwin;             /* transform them and return */
+}  /* fcm_winget() */            /* the number of windows */
 
 /*----------------------------------------------------------------------------
   Inline Retrieval Functions
@@ -113,26 +696,26 @@ inline REAL SFXNAME(fcm_pccotf) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
     return (REAL)+1;            /* always return +1.0 */
   if (row >  col) {             /* ensure col >= row (upper triangle) */
     DIM t = row; row = col; col = t; }
-  return PAIR_PCC((REAL*)fcm->data +(size_t)row*(size_t)fcm->X,
-                  (REAL*)fcm->data +(size_t)col*(size_t)fcm->X,
-                  (int)fcm->T); /* compute Pearson correlation coeff. */
+  return fcm->pair((REAL*)fcm->data +(size_t)row*(size_t)fcm->X,
+                   (REAL*)fcm->data +(size_t)col*(size_t)fcm->X,
+                   (int)fcm->T); /* compute Pearson correlation coeff. */
 }  /* fcm_pccotf() */
 
 /*--------------------------------------------------------------------------*/
 
-inline REAL SFXNAME(fcm_pccr2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+inline REAL SFXNAME(fcm_pccxf) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
 {                               /* --- get Pearson cc. on the fly */
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
   if (row == col)               /* if diagonal element, */
-    return (REAL)+R2Z_MAX;      /* return atanh(1-epsilon) */
+    return fcm->diag;           /* return the transformed +1.0 */
   if (row > col) {              /* ensure col >= row (upper triangle) */
     DIM t = row; row = col; col = t; }
-  REAL r = PAIR_PCC((REAL*)fcm->data +(size_t)row*(size_t)fcm->X,
-                    (REAL*)fcm->data +(size_t)col*(size_t)fcm->X,
-                    (int)fcm->T);/* compute Pearson correlation coeff. */
-  return fisher_r2z(r);         /* apply Fisher's r to z transform */
-}  /* fcm_pccr2z() */
+  REAL r = fcm->pair((REAL*)fcm->data +(size_t)row*(size_t)fcm->X,
+                     (REAL*)fcm->data +(size_t)col*(size_t)fcm->X,
+                     (int)fcm->T);/* compute Pearson correlation coeff. */
+  return SFXNAME(fcm_xval)(fcm, r);   /* and transform it */
+}  /* fcm_pccxf() */
 
 /*--------------------------------------------------------------------------*/
 
@@ -141,30 +724,15 @@ inline REAL SFXNAME(fcm_tccotf) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
   if (row == col)               /* if diagonal element, */
-    return (REAL)+1.0;          /* always return +1.0 */
+    return fcm->diag;           /* return the (transformed) +1.0 */
   if (row > col) {              /* ensure col >= row (upper triangle) */
     DIM t = row; row = col; col = t; }
-  int n = PCAND_TCC((uint32_t*)fcm->data +(size_t)row*(size_t)fcm->X,
-                    (uint32_t*)fcm->data +(size_t)col*(size_t)fcm->X,
-                    (int)fcm->X);/* count number of 11 configs. and */
-  return fcm->cmap[n];          /* compute tetrachoric corr. coeff. */
+  int n = fcm->pcand((uint32_t*)fcm->data +(size_t)row*(size_t)fcm->X,
+                     (uint32_t*)fcm->data +(size_t)col*(size_t)fcm->X,
+                     (int)fcm->X);/* count number of 11 configs. and */
+  return fcm->cmap[n];          /* map them to the tetrachoric cc. */
 }  /* fcm_tccotf() */
 
-/*--------------------------------------------------------------------------*/
-
-inline REAL SFXNAME(fcm_tccr2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
-{                               /* --- get tetrachoric cc. on the fly */
-  assert(fcm                    /* check the function arguments */
-  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
-  if (row == col)               /* if diagonal element, */
-    return (REAL)+R2Z_MAX;      /* return atanh(1-epsilon) */
-  if (row > col) {              /* ensure col >= row (upper triangle) */
-    DIM t = row; row = col; col = t; }
-  int n = PCAND_TCC((uint32_t*)fcm->data +(size_t)row*(size_t)fcm->X,
-                    (uint32_t*)fcm->data +(size_t)col*(size_t)fcm->X,
-                    (int)fcm->X);/* compute tetrachoric corr. coeff. */
-  return fisher_r2z(fcm->cmap[n]);
-}  /* fcm_tccr2z() */           /* apply Fisher's r to z transform */
 
 /*----------------------------------------------------------------------------
   Inline Iteration Functions
@@ -175,6 +743,7 @@ inline int SFXNAME(fcm_first) (SFXNAME(FCMAT) *fcm)
   assert(fcm);                  /* check the function argument */
   fcm->err = 0;                 /* clear the error status */
   fcm->row = 0; fcm->col = 1;   /* start with first off-diag. element */
+  fcm->stats.hits++;            /* count the retrieved element */
   fcm->value = fcm->cget(fcm, 0, 1);
   return (fcm->err) ? -1 : 0;   /* store the value and return status */
 }  /* fcm_first() */
@@ -199,10 +768,39 @@ inline int SFXNAME(fcm_next) (SFXNAME(FCMAT) *fcm)
         return 1;
     }                           /* if whole matrix is traversed, */
   }                             /* abort the function with failure */
+  fcm->stats.hits++;            /* count the retrieved element */
   fcm->value = fcm->cget(fcm, fcm->row, fcm->col);
   return (fcm->err) ? -1 : 0;   /* store the value and return status */
 }  /* fcm_next() */
 
+/*----------------------------------------------------------------------------
+  Statistics Functions
+----------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_stats) (SFXNAME(FCMAT) *fcm, FCMSTATS *stats,
+                                int thd)
+{                               /* --- get runtime statistics */
+  DIM i;                        /* loop variable for threads */
+
+  assert(fcm && stats);         /* check the function arguments */
+  if (thd >= 0) {               /* if statistics of a thread */
+    memset(stats, 0, sizeof(FCMSTATS));
+    if (fcm->tst && (thd < fcm->nthd)) *stats = fcm->tst[thd];
+    return;                     /* (only comp, bytes, busy and idle */
+  }                             /* are counted per thread) */
+  *stats = fcm->stats;          /* copy the matrix statistics */
+  if (!fcm->cache && !fcm->half && !fcm->cnts) {
+    stats->comp += stats->hits; /* without a cache or a stored */
+    stats->hits  = 0;           /* triangle traversed elements */
+  }                             /* are computed on the fly */
+  for (i = 0; fcm->tst && (i < fcm->nthd); i++) {
+    stats->comp  += fcm->tst[i].comp;
+    stats->bytes += fcm->tst[i].bytes;
+    stats->busy  += fcm->tst[i].busy;
+    stats->idle  += fcm->tst[i].idle;
+  }                             /* sum the statistics of the threads */
+}  /* fcm_stats() */
+
 /*----------------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------------*/
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <stdarg.h>
 #include <time.h>
 #include <assert.h>
@@ -23,6 +24,7 @@
 
 #include "cpuinfo.h"
 #include "fcmat2.h"
+#include "fcmat3.h"
 
 /*----------------------------------------------------------------------------
   Data Type Definition / Recursion Handling
@@ -73,23 +75,78 @@
   Function Prototypes (on-demand functions defined in fcmat1.h)
 ----------------------------------------------------------------------------*/
 extern REAL SFXNAME(fcm_pccotf) (FCMAT *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_pccr2z) (FCMAT *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_pccxf)  (FCMAT *fcm, DIM row, DIM col);
 extern REAL SFXNAME(fcm_tccotf) (FCMAT *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_tccr2z) (FCMAT *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_isa)    (void);
+extern int  SFXNAME(fcm_blksz)  (SFXNAME(FCMAT) *fcm);
+extern size_t SFXNAME(fcm_datasz) (SFXNAME(FCMAT) *fcm);
+extern int  SFXNAME(fcm_prep)   (SFXNAME(FCMAT) *fcm, REAL *data);
+extern REAL SFXNAME(fcm_xval)   (SFXNAME(FCMAT) *fcm, REAL r);
+extern int  SFXNAME(fcm_winprep) (SFXNAME(FCMAT) *fcm, REAL *data);
+extern void SFXNAME(fcm_wincc)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                 DIM k, DIM n, double *sum, REAL *r);
+extern REAL SFXNAME(fcm_pccwin) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 
 /*----------------------------------------------------------------------------
   Function Prototypes (cache-based functions defined in fcmat2.h)
 ----------------------------------------------------------------------------*/
 extern REAL SFXNAME(pcc_pure)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(pcc_r2z)   (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(pcc_xf)    (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 extern REAL SFXNAME(tcc_pure)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(tcc_r2z)   (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(pcc_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+extern void SFXNAME(tcc_run)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb, int raw);
+extern void SFXNAME(tcc_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+extern void SFXNAME(win_blk)   (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern void SFXNAME(rec_rct)   (SFXNAME(WORK) *w,
                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern void SFXNAME(rec_trg)   (SFXNAME(WORK) *w, DIM a, DIM b);
+extern void SFXNAME(rec_dyn)   (SFXNAME(WORK) *w);
+extern DIM  SFXNAME(fcm_subs)  (SFXNAME(FCMAT) *fcm, int shape,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
 extern WORKERDEF(fill, p);
+#ifndef _WIN32
+extern WORKERDEF(spin, p);
+extern int  SFXNAME(fcm_start) (SFXNAME(FCMAT) *fcm);
+extern void SFXNAME(fcm_stop)  (SFXNAME(FCMAT) *fcm);
+#endif
+extern int  SFXNAME(fcm_post)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_wait)  (SFXNAME(FCMAT) *fcm);
 extern int  SFXNAME(fcm_fill)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
 extern REAL SFXNAME(fcm_cache) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_pipe)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern int  SFXNAME(fcm_slots) (SFXNAME(FCMAT) *fcm, int k);
+extern int  SFXNAME(fcm_slot)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                SFXNAME(FCMFILLFN) *fillfn);
+
+/*----------------------------------------------------------------------------
+  Function Prototypes (file functions defined in fcmat3.h)
+----------------------------------------------------------------------------*/
+extern REAL SFXNAME(fcm_full)     (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_xf)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_f16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#if defined FCM_ALL_ISA || defined __F16C__
+extern REAL SFXNAME(fcm_full_f16c)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#endif
+extern REAL SFXNAME(fcm_full_bf16)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n8)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n32) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(fcm_enc16)    (SFXNAME(FCMAT) *fcm, uint16_t *dst,
+                                   const REAL *src, size_t n);
+extern int  SFXNAME(fcm_save)     (SFXNAME(FCMAT) *fcm, const char *fname);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_open)     (const char *fname);
+extern void SFXNAME(fcm_unmap)    (SFXNAME(FCMAT) *fcm);
+extern REAL SFXNAME(fcm_onl)      (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void*SFXNAME(fcm_onlrows)  (void *p);
+extern void SFXNAME(fcm_onlupd)   (SFXNAME(FCMAT) *fcm, double w);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_online)   (REAL *data, DIM V, DIM T, int mode, ...);
+extern int  SFXNAME(fcm_append)   (SFXNAME(FCMAT) *fcm, const REAL *vol);
 
 /*----------------------------------------------------------------------------
   Functions
@@ -100,8 +157,8 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   SFXNAME(FCMAT)    *fcm;       /* func. con. matrix to be created */
   SFXNAME(FCMGETFN) *get;       /* element computation function */
   SFXNAME(WORK)     *w;         /* to initialize the worker data */
-  WORKER  *worker;              /* worker for parallel execution */
-  int     i, n;                 /* loop variable for threads */
+  int     i;                    /* loop variable for threads */
+  int     k = 1;                /* number of tile slots */
   va_list args;                 /* list of variable arguments */
   size_t  z;                    /* cache size */
   #ifdef RECTGRID               /* if to split rectangle into grid */
@@ -120,21 +177,40 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   fcm->mem     = NULL;          /* clear memory block, */
   fcm->cmap    = NULL;          /* cosine map and cache */
   fcm->cache   = NULL;          /* for easier cleanup */
-  fcm->diag    = (REAL)((mode & FCM_R2Z) ? R2Z_MAX : 1.0);
+  fcm->slots   = NULL;          /* (a single tile slot) */
+  fcm->slot.cnt = 1;
+  fcm->slot.key = NULL;
+  fcm->dst     = NULL;          /* no tile is filled ahead */
+  fcm->ahead   = NULL;
+  fcm->pend    = 0;
+  fcm->half    = NULL;          /* (no packed triangles in this */
+  fcm->cnts    = NULL;          /* variant, cleared for fcm_save()) */
+  fcm->avg     = NULL;          /* (no online moments, */
+  fcm->mom     = NULL;          /* see fcm_online()) */
+  fcm->map     = NULL;          /* (not opened from a file) */
+  fcm->toff    = NULL;
+  fcm->diag    = 1;             /* (transformed below) */
+  fcm->clamp   = 1;             /* default: no clamping and */
+  fcm->thresh  = 0;             /* binarization at zero */
+  fcm->win     = fcm->step = 0; /* default: no sliding windows */
+  fcm->nwin    = 0;
   fcm->value   = fcm->diag;     /* set the value and coordinates */
   fcm->row     = fcm->col = 0;  /* of the current element */
   fcm->ra      = 0; fcm->rb = V;
   fcm->ca      = 0; fcm->cb = V;/* init. the coordinate ranges */
   fcm->err     = 0;             /* clear the error status */
+  fcm->maxmem  = -1;            /* no memory limit */
+  memset(&fcm->use, 0, sizeof(FCMMEM));
+  fcm->use.base = sizeof(SFXNAME(FCMAT));
   fcm->threads = NULL;          /* clear thread handles and */
   fcm->work    = NULL;          /* worker data for easier cleanup */
   #ifndef _WIN32                /* not yet available for Windows */
   fcm->join    = 1;             /* set the thread join flag */
-  #endif                        /* (default, to be changed later) */
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
-  fcm->sum     = fcm->beg = fcm->end = 0;
-  fcm->cnt     = 0;             /* initialize benchmark variables */
-  #endif                        /* (for time loss computation) */
+  fcm->bar.n   = 0;             /* (default, to be changed later) */
+  #endif                        /* and note no dedicated workers */
+  memset(&fcm->stats, 0, sizeof(FCMSTATS));
+  fcm->tst     = NULL;          /* clear the runtime statistics */
+  fcm->post[0] = fcm->post[1] = 0;
 
   va_start(args, mode);         /* start variable arguments */
   if (mode & FCM_THREAD)        /* get the number of threads, if indicated */
@@ -142,90 +218,87 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   if (mode & FCM_CACHE)         /* get the tile/cache size, if indicated */
     fcm->tile = va_arg(args, DIM);
   assert((fcm->tile == 0) || (fcm->tile <= V));
+  if (mode & FCM_MAXMEM)        /* skip the memory limit and */
+    va_arg(args, double);       /* the store directory (not used */
+  if (mode & FCM_DISK)          /* by this variant) */
+    va_arg(args, const char*);
+  if (mode & FCM_SLOTS)         /* get the number of tile slots */
+    k = va_arg(args, int);      /* (no memory limit to derive it from, */
+                                /* so k <= 0 means a single slot) */
+  if (mode & FCM_CLAMP)         /* get the bound for clamping */
+    fcm->clamp  = (REAL)va_arg(args, double);
+  if (mode & FCM_BIN)           /* get the threshold */
+    fcm->thresh = (REAL)va_arg(args, double);
+  if (mode & FCM_WINDOW) {      /* get the window length and step */
+    fcm->win  = va_arg(args, int);
+    fcm->step = va_arg(args, int);
+  }
   va_end(args);                 /* end variable arguments */
   if (fcm->nthd < 1) fcm->nthd = 1;
 
   mode &= FCM_CORR;             /* get the correlation type */
-  if      (mode == FCM_PCC) {   /* if Pearson's correlation coeff. */
-    #ifdef __AVX__              /* use AVX if possible */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+7) & ~7); /* process blocks with 8 numbers */
-    #endif
-    #else                       /* otherwise fall back to SSE2 */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+1) & ~1); /* process blocks with 2 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #endif                      /* get the data block size */
-    #endif                      /* allocate memory for norm.ed data */
-    fcm->mem = malloc((size_t)V*(size_t)fcm->X *sizeof(REAL) +31);
-    if (!fcm->mem) { SFXNAME(fcm_delete)(fcm); return NULL; }
-    fcm->data = (REAL*)(((uintptr_t)fcm->mem +31) & ~(uintptr_t)31);
-    INIT_PCC(data, (int)V, (int)T, fcm->data, (int)fcm->X); }
-  else if (mode == FCM_TCC) {   /* if tetrachoric correlation coeff. */
-    #if defined __POPCNT__ \
-    &&  defined __SSE4_1__      /* use 128 bit and popcnt if possible */
-    fcm->X = 4 *(((int)T+127) >> 7);
-    #else                       /* otherwise fall back to LUT16 */
-    fcm->X = ((int)T+31) >> 5;  /* get block size of binarized data */
-    #endif
-    fcm->mem  =                 /* allocate memory for binarized data */
-    fcm->data = SFXNAME(binarize)(data, (int)V, (int)T, BIN_MEDIAN, BPI);
-    if (!fcm->data) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    fcm->cmap = SFXNAME(make_cmap)((int)T); /* create cosine map */
-    if (!fcm->cmap) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    init_popcnt(); }            /* initialize bit count table */
-  else {                        /* if unknown correlation variant */
+  if ((mode != FCM_PCC) && (mode != FCM_TCC)) {
     fprintf(stderr, "fcm_create: unknown correlation variant\n");
     free(fcm); return NULL;     /* print an error message */
   }                             /* and abort the function */
+  if (fcm->mode & FCM_WINDOW) { /* if to summarize windowed corr.c. */
+    if ((mode != FCM_PCC)       /* (Pearson correlation only, */
+    ||  (fcm->win < 2) || (fcm->win > T) || (fcm->step < 1)) {
+      fprintf(stderr, "fcm_create: invalid sliding windows\n");
+      free(fcm); return NULL;   /* at least two scans per window) */
+    }                           /* get the number of windows */
+    fcm->nwin = (T -fcm->win) /fcm->step +1;
+  }
+  if (SFXNAME(fcm_prep)(fcm, data) != 0) {
+    SFXNAME(fcm_delete)(fcm); return NULL; }
+                                /* select kernels and prepare data */
+  fcm->diag  = (fcm->mode & FCM_WVAR) ? 0   /* (the variance of */
+             : SFXNAME(fcm_xval)(fcm, (REAL)1); /* windows is zero) */
+  fcm->value = fcm->diag;       /* transform the diagonal value */
   
-  if (!(fcm->mode & FCM_R2Z))   /* if pure correlation coefficients */
-    fcm->get = (mode == FCM_PCC)
-    ? SFXNAME(fcm_pccotf) : SFXNAME(fcm_tccotf);
-  else {                        /* if to apply Fisher's r to z trans. */
-    fcm->get = (mode == FCM_PCC)
-    ? SFXNAME(fcm_pccr2z) : SFXNAME(fcm_tccr2z);
-  }                             /* get the element retrieval function */
+  if (mode == FCM_TCC)          /* tetrachoric: transform is folded */
+    fcm->get = SFXNAME(fcm_tccotf);     /* into the cosine map */
+  else if (fcm->mode & FCM_WINDOW)    /* sliding windows */
+    fcm->get = SFXNAME(fcm_pccwin);
+  else                          /* Pearson: apply transform stage */
+    fcm->get = (fcm->mode & FCM_XFORM)
+    ? SFXNAME(fcm_pccxf) : SFXNAME(fcm_pccotf);
+                                /* get the element retrieval function */
   
-  if      (fcm->tile <= 0 || fcm->tile == V)
+  if      (fcm->tile <= 0 || fcm->tile >= V)
     fcm->cget = fcm->get;       /* get the element retrieval function */
   else if (fcm->tile < V) {
     z = (size_t)fcm->tile *(size_t)fcm->tile;
     fcm->cache    = (REAL*)  malloc(z *sizeof(REAL));
     fcm->threads  = (THREAD*)malloc((size_t)fcm->nthd *sizeof(THREAD));
     fcm->work = w = malloc((size_t)fcm->nthd *sizeof(SFXNAME(WORK)));
-    if (!fcm->cache || !fcm->threads || !fcm->work)  {
+    fcm->tst      = (FCMSTATS*)calloc((size_t)fcm->nthd, sizeof(FCMSTATS));
+    if (!fcm->cache || !fcm->threads || !fcm->work || !fcm->tst)  {
       SFXNAME(fcm_delete)(fcm); return NULL; }
-    if (!(fcm->mode & FCM_R2Z)) /* if to compute pure corr. coeffs. */
+    fcm->use.cache  = z *sizeof(REAL);
+    fcm->use.thread = (size_t)fcm->nthd
+                    * (sizeof(THREAD) +sizeof(SFXNAME(WORK))
+                                      +sizeof(FCMSTATS));
+    if      (fcm->mode & FCM_WINDOW)
+      get = SFXNAME(fcm_pccwin);/* if to summarize sliding windows */
+    else if ((mode == FCM_PCC) && (fcm->mode & FCM_XFORM))
+      get = SFXNAME(pcc_xf);    /* if to apply the transform stage */
+    else                        /* (tetrachoric: folded into cmap) */
       get = (mode == FCM_PCC) ? SFXNAME(pcc_pure) : SFXNAME(tcc_pure);
-    else                        /* if to apply Fisher's r to z trans. */
-      get = (mode == FCM_PCC) ? SFXNAME(pcc_r2z)  : SFXNAME(tcc_r2z);
     for (i = 0; i < fcm->nthd; i++) {
       w[i].work = 0;            /* clear assigned work flag */
       w[i].fcm  = fcm;          /* store func. con. matrix object */
-      w[i].get  = get;          /* and the function that */
-    }                           /* computes a matrix element */
+      w[i].get  = get;          /* and the functions that */
+      w[i].blk  = (fcm->mode & FCM_WINDOW) ? SFXNAME(win_blk)
+                : (mode == FCM_PCC) ? SFXNAME(pcc_blk) : SFXNAME(tcc_blk);
+      w[i].beg  = w[i].end  = 0;/* compute a matrix element/block */
+      w[i].comp = w[i].rows = 0;/* and clear the time stamps */
+    }                           /* and the counters */
     #ifndef _WIN32              /* not yet available for Windows */
     fcm->join = ((fcm->nthd <= 1) || (fcm->mode & FCM_JOIN));
-    if (!fcm->join) {           /* if to block and signal threads */
-      pthread_mutex_init(&fcm->mutex,     NULL);
-      pthread_cond_init (&fcm->cond_idle, NULL);
-      pthread_cond_init (&fcm->cond_work, NULL);
-      fcm->idle = 0;            /* init. thread synchronization */
-      worker = SFXNAME(fill);   /* get the worker function */
-      for (n = 0; n < fcm->nthd; n++)
-        if (pthread_create(fcm->threads+n, NULL, worker, w+n) != 0) {
-          fcm->err = -1; break;}/* start the worker threads */
-      pthread_mutex_lock(&fcm->mutex);
-      while (fcm->idle < n)     /* wait for all threads to start */
-        pthread_cond_wait(&fcm->cond_idle, &fcm->mutex);
-      pthread_mutex_unlock(&fcm->mutex);
-      if (fcm->err) {           /* if starting the threads failed */
-        fcm->nthd = n; SFXNAME(fcm_delete)(fcm); return NULL; }
-    }                           /* delete the matrix and abort */
+    if (!fcm->join && (fcm->mode & FCM_SPIN)    /* (default: use */
+    &&  (SFXNAME(fcm_start)(fcm) != 0)) {       /* the shared pool) */
+      SFXNAME(fcm_delete)(fcm); return NULL; }
     #endif
     #ifdef RECTGRID             /* if to split rectangle into grid */
     for (g = (DIM)floor(sqrt((REAL)fcm->nthd)); g > 1; g--)
@@ -233,10 +306,18 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
         break;                  /* compute factors as close as */
     fcm->gc = g;                /* possible to the square root */
     fcm->gr = fcm->nthd/g;      /* for the rectangle grid */
+    #else                       /* if to split rectangle into strips */
+    fcm->gc = 1;                /* (a grid with one column) */
+    fcm->gr = fcm->nthd;
     #endif
     fcm->cget = SFXNAME(fcm_cache);
     fcm->ra = fcm->rb = -1;     /* get element retrieval function and */
     fcm->ca = fcm->cb = -1;     /* invalidate row and column range */
+    if (SFXNAME(fcm_slots)(fcm, k) != 0) {
+      SFXNAME(fcm_delete)(fcm); return NULL; }
+    fcm->tget = fcm->get;       /* (threads compute on the fly) */
+    if (fcm->slot.cnt > 1)      /* with several tile slots, */
+      fcm->get = fcm->cget;     /* also fcm_get() uses the cache */
   }
 
   return fcm;                   /* return created FC matrix */
@@ -246,44 +327,38 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 
 void SFXNAME(fcm_delete) (SFXNAME(FCMAT) *fcm)
 {                               /* --- delete a func. connect. matrix */
+  #ifdef FCM_BENCH              /* if to do some benchmarking */
+  FCMSTATS st;                  /* runtime statistics */
+  #endif
+
   assert(fcm);                  /* check the function argument */
   #ifdef FCM_BENCH              /* if to do some benchmarking */
-  double loss = fcm->beg +fcm->end;
-  if (fcm->cnt <= 0) fcm->cnt = 1;
+  SFXNAME(fcm_stats)(fcm, &st, -1);
+  if (st.fills <= 0) st.fills = 1;
   fprintf(stderr, "fcm_delete()\n");
-  fprintf(stderr, "%d tiles\n", fcm->cnt);
+  fprintf(stderr, "%zu tiles\n", st.fills);
   fprintf(stderr, "time: %10.6f (%10.6f)\n",
-          fcm->sum, fcm->sum/(double)fcm->cnt);
-  fprintf(stderr, "loss: %10.6f (%10.6f/%10.6f)\n",
-          loss,     loss    /(double)fcm->nthd,
-          loss    /(double)fcm->cnt);
-  fprintf(stderr, "beg : %10.6f (%10.6f/%10.6f)\n",
-          fcm->beg, fcm->beg/(double)fcm->nthd,
-          fcm->beg/(double)fcm->cnt);
-  fprintf(stderr, "end : %10.6f (%10.6f/%10.6f)\n",
-          fcm->end, fcm->end/(double)fcm->nthd,
-          fcm->end/(double)fcm->cnt);
+          st.time, st.time/(double)st.fills);
+  fprintf(stderr, "idle: %10.6f (%10.6f/%10.6f)\n",
+          st.idle, st.idle/(double)fcm->nthd,
+          st.idle/(double)st.fills);
+  fprintf(stderr, "sync: %10.6f (%10.6f)\n",
+          st.sync, st.sync/(double)st.fills);
   #endif                        /* print benchmarking information */
   #ifndef _WIN32                /* not yet available for Windows */
-  if (!fcm->join) {             /* if to block and signal threads */
-    int i;                      /* loop variable for threads */
-    SFXNAME(WORK) *w = fcm->work;     /* get the worker data */
-    pthread_mutex_lock(&fcm->mutex);
-    for (i = 0; i < fcm->nthd; i++)
-      w[i].work = -1;           /* set the thread stop indicators */
-    fcm->idle = 0;              /* signal that work was assigned */
-    pthread_cond_broadcast(&fcm->cond_work);
-    pthread_mutex_unlock(&fcm->mutex);
-    for (i = 0; i < fcm->nthd; i++) /* wait for all threads to finish */
-      pthread_join(fcm->threads[i], NULL);
-    pthread_cond_destroy (&fcm->cond_work);
-    pthread_cond_destroy (&fcm->cond_idle);
-    pthread_mutex_destroy(&fcm->mutex);
-  }                             /* clean up thread synchronization */
+  if (fcm->work)                /* wait for a pending tile fill */
+    SFXNAME(fcm_wait)(fcm);     /* (no pool task may refer to it) */
+  if (fcm->bar.n > 0)           /* stop the dedicated workers */
+    SFXNAME(fcm_stop)(fcm);
   #endif
+  if (fcm->map) SFXNAME(fcm_unmap)(fcm); /* unmap a saved matrix */
+  if (fcm->toff)    free(fcm->toff);
   if (fcm->work)    free(fcm->work);
+  if (fcm->tst)     free(fcm->tst);
   if (fcm->threads) free(fcm->threads);
+  if (fcm->slots)   fcm->cache = fcm->slots;
   if (fcm->cache)   free(fcm->cache);
+  if (fcm->slot.key) free(fcm->slot.key);
   if (fcm->cmap)    free(fcm->cmap);
   if (fcm->mem)     free(fcm->mem);/* delete cache, cosine map, */
   free(fcm);                    /* data, and the base structure */
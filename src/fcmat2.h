@@ -34,16 +34,108 @@
 #define SFXNAME_2(n,s)  n##s    /* the two step recursion is needed */
 #endif                          /* to ensure proper expansion */
 
+/*--------------------------------------------------------------------------*/
+#define float  1                /* to check the definition of REAL */
+#define double 2
+
+#if   REAL == float             /* if single precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  0       /* clear indicator for double */
+#elif REAL == double            /* if double precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  1       /* set   indicator for double */
+#else
+#error "REAL must be either 'float' or 'double'"
+#endif
+
+#undef float                    /* delete definitions */
+#undef double                   /* used for type checking */
+
 /*----------------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------------*/
 #define TILE_MIN    16          /* minimum tile size for comp. */
 #define RECTANGLE   1           /* shape id for rectangular area */
 #define TRIANGLE    2           /* shape id for triangular  area */
+#define DYNAMIC     4           /* flag for pulling sub-blocks */
+#define SUB_CNT     8           /* sub-blocks per thread (rectangle) */
 // #define PAIRSPLIT
 // #define RECTGRID
 // #define SAFETHREAD
 
+#define BLK_ROWS    4           /* rows    of a register block */
+#define BLK_COLS    2           /* columns of a register block */
+#define BLK_KB      (512/(int)sizeof(REAL))
+                                /* data block size along the scans */
+#define BLK_MAX     (64/(int)sizeof(REAL))
+                                /* max. numbers per vector register */
+
+/*--------------------------------------------------------------------------*/
+#undef  AVX512_VEC
+#undef  AVX512_LEN
+#undef  AVX512_LOAD
+#undef  AVX512_MLOAD
+#undef  AVX512_MASK
+#undef  AVX512_HALF
+#undef  AVX512_STORE
+#undef  AVX512_FMA
+#undef  AVX_VEC                 /* vector operations for the blocked */
+#undef  AVX_LEN                 /* Pearson correlation kernels */
+#undef  AVX_LOAD                /* (depend on the type of REAL, */
+#undef  AVX_STORE               /* so they are redefined in each */
+#undef  AVX_ADD                 /* pass of the recursion) */
+#undef  AVX_MUL
+#undef  SSE2_VEC
+#undef  SSE2_LEN
+#undef  SSE2_LOAD
+#undef  SSE2_STORE
+#undef  SSE2_ADD
+#undef  SSE2_MUL
+
+#if REAL_IS_DOUBLE              /* if double precision data */
+#define AVX512_VEC  __m512d     /* 8 doubles per AVX-512 vector */
+#define AVX512_LEN  8
+#define AVX512_LOAD _mm512_load_pd
+#define AVX512_MLOAD _mm512_maskz_loadu_pd
+#define AVX512_MASK __mmask8
+#define AVX512_HALF 0x0f        /* mask for the lower 32 bytes */
+#define AVX512_STORE _mm512_store_pd
+#define AVX512_FMA  _mm512_fmadd_pd
+#define AVX_VEC     __m256d     /* 4 doubles per AVX vector */
+#define AVX_LEN     4
+#define AVX_LOAD    _mm256_load_pd
+#define AVX_STORE   _mm256_store_pd
+#define AVX_ADD     _mm256_add_pd
+#define AVX_MUL     _mm256_mul_pd
+#define SSE2_VEC    __m128d     /* 2 doubles per SSE2 vector */
+#define SSE2_LEN    2
+#define SSE2_LOAD   _mm_load_pd
+#define SSE2_STORE  _mm_store_pd
+#define SSE2_ADD    _mm_add_pd
+#define SSE2_MUL    _mm_mul_pd
+#else                           /* if single precision data */
+#define AVX512_VEC  __m512      /* 16 floats per AVX-512 vector */
+#define AVX512_LEN  16
+#define AVX512_LOAD _mm512_load_ps
+#define AVX512_MLOAD _mm512_maskz_loadu_ps
+#define AVX512_MASK __mmask16
+#define AVX512_HALF 0x00ff      /* mask for the lower 32 bytes */
+#define AVX512_STORE _mm512_store_ps
+#define AVX512_FMA  _mm512_fmadd_ps
+#define AVX_VEC     __m256      /* 8 floats per AVX vector */
+#define AVX_LEN     8
+#define AVX_LOAD    _mm256_load_ps
+#define AVX_STORE   _mm256_store_ps
+#define AVX_ADD     _mm256_add_ps
+#define AVX_MUL     _mm256_mul_ps
+#define SSE2_VEC    __m128      /* 4 floats per SSE2 vector */
+#define SSE2_LEN    4
+#define SSE2_LOAD   _mm_load_ps
+#define SSE2_STORE  _mm_store_ps
+#define SSE2_ADD    _mm_add_ps
+#define SSE2_MUL    _mm_mul_ps
+#endif
+
 /*--------------------------------------------------------------------------*/
 #ifndef THREAD_OK               /* if not yet defined */
 #ifdef _WIN32                   /* if Microsoft Windows system */
@@ -55,9 +147,23 @@
 #endif                          /* definition of a worker function */
 #endif
 
+#ifndef FETCH_ADD               /* if not yet defined */
+#ifdef _MSC_VER                 /* if Microsoft C compiler */
+#define FETCH_ADD(p,n)  InterlockedExchangeAdd((volatile LONG*)(p), (n))
+#else                           /* if GNU C compatible compiler */
+#define FETCH_ADD(p,n)  __atomic_fetch_add((p), (n), __ATOMIC_RELAXED)
+#endif                          /* atomically add to a counter */
+#endif                          /* and return its old value */
+
 /*----------------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------------*/
+typedef void SFXNAME(FCMBLKFN) (SFXNAME(FCMAT) *fcm,
+                                DIM ra, DIM rb, DIM ca, DIM cb);
+                                /* --- block computation function */
+typedef int  SFXNAME(FCMFILLFN) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+                                /* --- tile fill function */
+
 typedef struct {                /* --- thread worker data --- */
   int    work;                  /* flag for assigned work */
   DIM    ra, rb;                /* row    index range */
@@ -65,11 +171,13 @@ typedef struct {                /* --- thread worker data --- */
   DIM    cm;                    /* reference column for mirroring */
   SFXNAME(FCMAT)    *fcm;       /* underlying f.c. matrix object */
   SFXNAME(FCMGETFN) *get;       /* element computation function */
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
+  SFXNAME(FCMBLKFN) *blk;       /* block   computation function */
   double beg;                   /* start time of thread */
   double end;                   /* end   time of thread */
-  #endif                        /* (for time loss computation) */
-} SFXNAME(WORK);                /* (thread worker data) */
+  size_t comp;                  /* number of computed elements */
+  size_t rows;                  /* number of data rows processed */
+  char   pad[64];               /* keep the data of the workers */
+} SFXNAME(WORK);                /* in different cache lines */
 
 #ifndef WORKERTYPE              /* if not yet defined */
 #define WORKERTYPE              /* define worker function type */
@@ -83,13 +191,16 @@ typedef void*        WORKER (void*);
 /*----------------------------------------------------------------------------
   Timer Function
 ----------------------------------------------------------------------------*/
-#if (defined FCM_BENCH || defined FCMAT_MAIN) && !defined TIMER
+#ifndef TIMER                   /* if not yet defined */
 #define TIMER
 
 static double timer (void)
 {                               /* --- get current time */
   #ifdef _WIN32                 /* if Microsoft Windows system */
-  return 0.001 *(double)timeGetTime();
+  LARGE_INTEGER c, f;           /* performance counter and frequency */
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (double)c.QuadPart /(double)f.QuadPart;
   #else                         /* if Linux/Unix system */
   struct timespec tp;           /* POSIX time specification */
   clock_gettime(CLOCK_MONOTONIC, &tp);
@@ -107,24 +218,24 @@ inline REAL SFXNAME(pcc_pure) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
 {                               /* --- compute Pearson corr. coeff. */
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col > row) && (col < fcm->V));
-  return PAIR_PCC((REAL*)fcm->data +(size_t)row *(size_t)fcm->X,
-                  (REAL*)fcm->data +(size_t)col *(size_t)fcm->X,
-                  (int)fcm->T); /* compute Pearson correlation coeff. */
+  return fcm->pair((REAL*)fcm->data +(size_t)row *(size_t)fcm->X,
+                   (REAL*)fcm->data +(size_t)col *(size_t)fcm->X,
+                   (int)fcm->T);/* compute Pearson correlation coeff. */
 }  /* pcc_pure() */
 
 /*--------------------------------------------------------------------------*/
 
-inline REAL SFXNAME(pcc_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+inline REAL SFXNAME(pcc_xf) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
 {                               /* --- get Pearson corr. coeff. */
   REAL r;                       /* correlation coefficient */
 
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col > row) && (col < fcm->V));
-  r = PAIR_PCC((REAL*)fcm->data +(size_t)row *(size_t)fcm->X,
-               (REAL*)fcm->data +(size_t)col *(size_t)fcm->X,
-               (int)fcm->T);    /* compute Pearson correlation coeff. */
-  return fisher_r2z(r);         /* apply Fisher's r to z transform */
-}  /* pcc_r2z() */
+  r = fcm->pair((REAL*)fcm->data +(size_t)row *(size_t)fcm->X,
+                (REAL*)fcm->data +(size_t)col *(size_t)fcm->X,
+                (int)fcm->T);   /* compute Pearson correlation coeff. */
+  return SFXNAME(fcm_xval)(fcm, r);   /* and transform it */
+}  /* pcc_xf() */
 
 /*--------------------------------------------------------------------------*/
 
@@ -134,25 +245,480 @@ inline REAL SFXNAME(tcc_pure) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
 
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col > row) && (col < fcm->V));
-  n = PCAND_TCC((uint32_t*)fcm->data +(size_t)row *(size_t)fcm->X,
-                (uint32_t*)fcm->data +(size_t)col *(size_t)fcm->X,
-                (int)fcm->X);   /* count 11 configurations and */
-  return fcm->cmap[n];          /* compute tetrachoric corr. coeff. */
-}  /* tcc_pure() */
+  n = fcm->pcand((uint32_t*)fcm->data +(size_t)row *(size_t)fcm->X,
+                 (uint32_t*)fcm->data +(size_t)col *(size_t)fcm->X,
+                 (int)fcm->X);  /* count 11 configurations and */
+  return fcm->cmap[n];          /* map them to the tetrachoric cc. */
+}  /* tcc_pure() */              /* (transform is folded into cmap) */
 
+
+/*----------------------------------------------------------------------------
+  Blocked Pearson Correlation Kernels
+----------------------------------------------------------------------------*/
+/* Each kernel computes BLK_ROWS x BLK_COLS dot products at once, so  */
+/* that every loaded row vector is used BLK_COLS times and every      */
+/* loaded column vector BLK_ROWS times. The products for the scans    */
+/* [a,b) are added to vector accumulators in acc (one vector per      */
+/* pair), which allows the caller to process the data in K-blocks.    */
+/* The series are padded to multiples of 32 bytes (as for AVX), so    */
+/* the AVX-512 kernel loads the last half vector with a mask.         */
+
+#if defined FCM_ALL_ISA || defined __AVX512F__
+
+FCM_TARGET("avx512f")
+static inline void SFXNAME(blk_avx512) (REAL **r, REAL **c, int a, int b,
+                                        REAL *acc)
+{                               /* --- block of dot products (AVX-512) */
+  AVX512_VEC s[BLK_ROWS][BLK_COLS];  /* accumulators for the pairs */
+  AVX512_VEC x[BLK_ROWS], y;    /* row vectors and column vector */
+  AVX512_MASK m;                /* mask for the last (half) vector */
+  int        i, j;              /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* load the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      s[i][j] = AVX512_LOAD(acc +(i*BLK_COLS+j)*AVX512_LEN);
+  for ( ; a < b; a += AVX512_LEN) {  /* traverse the scans */
+    m = (b-a < AVX512_LEN) ? (AVX512_MASK)AVX512_HALF
+                           : (AVX512_MASK)~0;
+    for (i = 0; i < BLK_ROWS; i++) /* load the row vectors */
+      x[i] = AVX512_MLOAD(m, r[i] +a);
+    for (j = 0; j < BLK_COLS; j++) {
+      y = AVX512_MLOAD(m, c[j] +a);  /* load a column vector and */
+      for (i = 0; i < BLK_ROWS; i++) /* combine it with all rows */
+        s[i][j] = AVX512_FMA(x[i], y, s[i][j]);
+    }                           /* (fused multiply-add) */
+  }
+  for (i = 0; i < BLK_ROWS; i++)   /* store the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      AVX512_STORE(acc +(i*BLK_COLS+j)*AVX512_LEN, s[i][j]);
+}  /* blk_avx512() */
+
+#endif
 /*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __AVX__
 
-inline REAL SFXNAME(tcc_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
-{                               /* --- compute tetrachoric corr. cf. */
-  int n;                        /* number of 11 configurations */
+FCM_TARGET("avx")
+static inline void SFXNAME(blk_avx) (REAL **r, REAL **c, int a, int b,
+                                     REAL *acc)
+{                               /* --- block of dot products (AVX) */
+  AVX_VEC s[BLK_ROWS][BLK_COLS];/* accumulators for the pairs */
+  AVX_VEC x[BLK_ROWS], y;       /* row vectors and column vector */
+  int     i, j;                 /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* load the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      s[i][j] = AVX_LOAD(acc +(i*BLK_COLS+j)*AVX_LEN);
+  for ( ; a < b; a += AVX_LEN) {   /* traverse the scans */
+    for (i = 0; i < BLK_ROWS; i++) /* load the row vectors */
+      x[i] = AVX_LOAD(r[i] +a);
+    for (j = 0; j < BLK_COLS; j++) {
+      y = AVX_LOAD(c[j] +a);       /* load a column vector and */
+      for (i = 0; i < BLK_ROWS; i++) /* combine it with all rows */
+        s[i][j] = AVX_ADD(s[i][j], AVX_MUL(x[i], y));
+    }                           /* (each loaded vector is reused */
+  }                             /* for a whole row/column of pairs) */
+  for (i = 0; i < BLK_ROWS; i++)   /* store the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      AVX_STORE(acc +(i*BLK_COLS+j)*AVX_LEN, s[i][j]);
+}  /* blk_avx() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __SSE2__
+
+FCM_TARGET("sse2")
+static inline void SFXNAME(blk_sse2) (REAL **r, REAL **c, int a, int b,
+                                      REAL *acc)
+{                               /* --- block of dot products (SSE2) */
+  SSE2_VEC s[BLK_ROWS][BLK_COLS];  /* accumulators for the pairs */
+  SSE2_VEC x[BLK_ROWS], y;      /* row vectors and column vector */
+  int      i, j;                /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* load the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      s[i][j] = SSE2_LOAD(acc +(i*BLK_COLS+j)*SSE2_LEN);
+  for ( ; a < b; a += SSE2_LEN) {  /* traverse the scans */
+    for (i = 0; i < BLK_ROWS; i++) /* load the row vectors */
+      x[i] = SSE2_LOAD(r[i] +a);
+    for (j = 0; j < BLK_COLS; j++) {
+      y = SSE2_LOAD(c[j] +a);      /* load a column vector and */
+      for (i = 0; i < BLK_ROWS; i++) /* combine it with all rows */
+        s[i][j] = SSE2_ADD(s[i][j], SSE2_MUL(x[i], y));
+    }
+  }
+  for (i = 0; i < BLK_ROWS; i++)   /* store the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      SSE2_STORE(acc +(i*BLK_COLS+j)*SSE2_LEN, s[i][j]);
+}  /* blk_sse2() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+
+static inline void SFXNAME(blk_naive) (REAL **r, REAL **c, int a, int b,
+                                       REAL *acc)
+{                               /* --- block of dot products (naive) */
+  REAL s[BLK_ROWS][BLK_COLS];   /* accumulators for the pairs */
+  int  i, j;                    /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* load the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      s[i][j] = acc[i*BLK_COLS+j];
+  for ( ; a < b; a++)           /* traverse the scans */
+    for (i = 0; i < BLK_ROWS; i++)
+      for (j = 0; j < BLK_COLS; j++)
+        s[i][j] += r[i][a] *c[j][a];
+  for (i = 0; i < BLK_ROWS; i++)   /* store the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      acc[i*BLK_COLS+j] = s[i][j];
+}  /* blk_naive() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(pcc_blk) (SFXNAME(FCMAT) *fcm,
+                              DIM ra, DIM rb, DIM ca, DIM cb)
+{                               /* --- compute a block of Pearson cc. */
+  REAL mem[TILE_MIN*TILE_MIN*BLK_MAX +64/sizeof(REAL)];
+  REAL *acc, *p;                /* vector accumulators for the pairs */
+  REAL *r[BLK_ROWS];            /* rows    of a register block */
+  REAL *c[BLK_COLS];            /* columns of a register block */
+  REAL *data;                   /* normalized data */
+  DIM  ia, ib, ja, jb;          /* index ranges of a sub-block */
+  DIM  i, j, k, l;              /* loop variables */
+  int  a, b, x;                 /* scan range of a K-block */
+  int  n;                       /* numbers per vector register */
+  REAL s;                       /* sum of the accumulator vector */
+  void (*blk)(REAL**, REAL**, int, int, REAL*);   /* block kernel */
 
   assert(fcm                    /* check the function arguments */
-  &&    (row >= 0) && (row < fcm->V) && (col > row) && (col < fcm->V));
-  n = PCAND_TCC((uint32_t*)fcm->data +(size_t)row *(size_t)fcm->X,
-                (uint32_t*)fcm->data +(size_t)col *(size_t)fcm->X,
-                (int)fcm->X);   /* compute tetrachoric corr. coeff. */
-  return fisher_r2z(fcm->cmap[n]);
-}  /* tcc_r2z() */              /* apply Fisher's r to z transform */
+  &&    (ra >= 0) && (rb > ra) && (rb <= fcm->V)
+  &&    (ca >= 0) && (cb > ca) && (cb <= fcm->V));
+  acc  = (REAL*)(((uintptr_t)mem +63) & ~(uintptr_t)63);
+  data = (REAL*)fcm->data;      /* get the aligned accumulators */
+  x    = (int)fcm->X;           /* and the padded data */
+  blk  = SFXNAME(blk_naive); n = 1;
+  #if defined FCM_ALL_ISA || defined __SSE2__
+  if (fcm->isa & FCM_ISA_SSE2) { blk = SFXNAME(blk_sse2); n = SSE2_LEN; }
+  #endif                        /* select the block kernel */
+  #if defined FCM_ALL_ISA || defined __AVX__
+  if (fcm->isa & FCM_ISA_AVX)  { blk = SFXNAME(blk_avx);  n = AVX_LEN;  }
+  #endif                        /* (padding of data fits the kernel) */
+  #if defined FCM_ALL_ISA || defined __AVX512F__
+  if (fcm->isa & FCM_ISA_AVX512) { blk = SFXNAME(blk_avx512);
+                                   n = AVX512_LEN; }
+  #endif
+  for (ia = ra; ia < rb; ia = ib) {
+    ib = (ia+TILE_MIN < rb) ? ia+TILE_MIN : rb;
+    for (ja = ca; ja < cb; ja = jb) {
+      jb = (ja+TILE_MIN < cb) ? ja+TILE_MIN : cb;
+      if (jb-1 <= ia) continue; /* skip sub-blocks that lie */
+      memset(acc, 0,            /* completely in the lower triangle */
+             (size_t)TILE_MIN*TILE_MIN*(size_t)n *sizeof(REAL));
+      for (a = 0; a < x; a = b) {  /* traverse the K-blocks */
+        b = (a+BLK_KB < x) ? a+BLK_KB : x;
+        for (p = acc, i = ia; i < ib; i += BLK_ROWS) {
+          for (k = 0; k < BLK_ROWS; k++)  /* collect the rows */
+            r[k] = data +(size_t)((i+k < ib) ? i+k : ib-1) *(size_t)x;
+          for (j = ja; j < jb; j += BLK_COLS) {
+            if (j+BLK_COLS-1 > i) { /* if block has upper elements */
+              for (l = 0; l < BLK_COLS; l++) /* collect the columns */
+                c[l] = data +(size_t)((j+l < jb) ? j+l : jb-1) *(size_t)x;
+              blk(r, c, a, b, p);
+            }                   /* add the products of the scans */
+            p += BLK_ROWS*BLK_COLS*n;
+          }                     /* (rows/columns beyond the sub-block */
+        }                       /* repeat the last one; their results */
+      }                         /* are computed, but never stored) */
+      for (p = acc, i = ia; i < ib; i += BLK_ROWS) {
+        for (j = ja; j < jb; j += BLK_COLS) {
+          for (k = 0; k < BLK_ROWS; k++) {
+            for (l = 0; l < BLK_COLS; l++) {
+              if ((i+k >= ib) || (j+l >= jb) || (j+l <= i+k))
+                continue;       /* skip duplicates and lower triangle */
+              for (s = 0, a = 0; a < n; a++)
+                s += p[(k*BLK_COLS+l)*n +a];
+              if      (s > +1) s = +1;  /* sum the vector elements */
+              else if (s < -1) s = -1;  /* and clamp the result */
+              fcm->dst[(size_t)(i+k-fcm->dr) *(size_t)fcm->tile
+                      +(size_t)(j+l-fcm->dc)] = s;
+            }                   /* store the correlation */
+          }                     /* coefficient in the cache */
+          p += BLK_ROWS*BLK_COLS*n;
+        }
+      }
+      if (fcm->mode & FCM_XFORM) {  /* apply the transform stage */
+        for (i = ia; i < ib; i++) { /* to the rows of the sub-block */
+          j = (ja > i+1) ? ja : i+1;  /* (upper triangle only, */
+          if (j < jb)               /* the rows are still in L1) */
+            SFXNAME(fcm_xform)(fcm, fcm->dst +(size_t)(i-fcm->dr)
+              *(size_t)fcm->tile +(size_t)(j-fcm->dc), (size_t)(jb-j));
+        }
+      }
+    }
+  }
+}  /* pcc_blk() */
+
+/*----------------------------------------------------------------------------
+  Blocked Tetrachoric Correlation Kernels
+----------------------------------------------------------------------------*/
+/* Each kernel counts the 11 configurations (bits that are set in     */
+/* both binarized series) for BLK_ROWS x BLK_COLS pairs at once. The  */
+/* kernels do not depend on REAL and are thus defined only once.      */
+#ifndef TBLK_DEFINED
+#define TBLK_DEFINED
+
+#if defined FCM_ALL_ISA \
+|| (defined __AVX512F__ && defined __AVX512VPOPCNTDQ__)
+
+FCM_TARGET("avx512f,avx512vpopcntdq")
+static inline void tblk_vpopcnt (uint32_t **r, uint32_t **c, int n,
+                                 int *cnt)
+{                               /* --- block of n11 counts (AVX-512) */
+  __m512i   s[BLK_ROWS][BLK_COLS];  /* bit counters for the pairs */
+  __m512i   x[BLK_ROWS], y;     /* row vectors and column vector */
+  __mmask16 m;                  /* mask for the last words */
+  int       i, j, k;            /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* clear the bit counters */
+    for (j = 0; j < BLK_COLS; j++)
+      s[i][j] = _mm512_setzero_si512();
+  for (k = 0; k < n; k += 16) { /* traverse the words */
+    m = (n-k >= 16) ? (__mmask16)0xffff
+                    : (__mmask16)((1u << (n-k)) -1);
+    for (i = 0; i < BLK_ROWS; i++) /* load the row vectors */
+      x[i] = _mm512_maskz_loadu_epi32(m, r[i]+k);
+    for (j = 0; j < BLK_COLS; j++) {
+      y = _mm512_maskz_loadu_epi32(m, c[j]+k);
+      for (i = 0; i < BLK_ROWS; i++) /* count the common bits */
+        s[i][j] = _mm512_add_epi64(s[i][j],
+                  _mm512_popcnt_epi64(_mm512_and_si512(x[i], y)));
+    }                           /* (native 64 bit population count) */
+  }
+  for (i = 0; i < BLK_ROWS; i++)   /* sum the counters */
+    for (j = 0; j < BLK_COLS; j++)
+      cnt[i*BLK_COLS+j] = (int)_mm512_reduce_add_epi64(s[i][j]);
+}  /* tblk_vpopcnt() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || (defined __AVX512F__ && defined __AVX512BW__)
+
+FCM_TARGET("avx512f,avx512bw")
+static inline __m512i pcnt_avx512 (__m512i v)
+{                               /* --- count bits in 64 bit lanes */
+  const __m512i lut  = _mm512_broadcast_i32x4(
+                       _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4));
+  const __m512i mask = _mm512_set1_epi8(0x0f);
+  __m512i lo = _mm512_and_si512(v, mask);
+  __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), mask);
+  lo = _mm512_add_epi8(_mm512_shuffle_epi8(lut, lo),
+                       _mm512_shuffle_epi8(lut, hi));
+  return _mm512_sad_epu8(lo, _mm512_setzero_si512());
+}  /* pcnt_avx512() */          /* look up nibble counts and sum them */
+
+/*--------------------------------------------------------------------------*/
+
+FCM_TARGET("avx512f,avx512bw")
+static inline void tblk_avx512 (uint32_t **r, uint32_t **c, int n,
+                                int *cnt)
+{                               /* --- block of n11 counts (AVX-512BW) */
+  __m512i   o[BLK_ROWS][BLK_COLS]; /* ones (carry-save sum bits) */
+  __m512i   t[BLK_ROWS][BLK_COLS]; /* bit counts of the carries */
+  __m512i   xa[BLK_ROWS], xb[BLK_ROWS];  /* row vectors */
+  __m512i   ya, yb, a, b, h;    /* column vectors, conjunctions */
+  __mmask16 ma, mb;             /* masks for the last words */
+  int       i, j, k, e;         /* loop variables, remaining words */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* clear the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      o[i][j] = t[i][j] = _mm512_setzero_si512();
+  for (k = 0; k < n; k += 32) { /* process two vectors per step */
+    e  = n-k;                   /* get the number of remaining words */
+    ma = (e >= 16) ? (__mmask16)0xffff : (__mmask16)((1u << e) -1);
+    mb = (e >= 32) ? (__mmask16)0xffff
+       : (e <= 16) ? (__mmask16)0 : (__mmask16)((1u << (e-16)) -1);
+    for (i = 0; i < BLK_ROWS; i++) {
+      xa[i] = _mm512_maskz_loadu_epi32(ma, r[i]+k);
+      xb[i] = _mm512_maskz_loadu_epi32(mb, r[i]+k+16);
+    }                           /* load the row vectors */
+    for (j = 0; j < BLK_COLS; j++) {
+      ya = _mm512_maskz_loadu_epi32(ma, c[j]+k);
+      yb = _mm512_maskz_loadu_epi32(mb, c[j]+k+16);
+      for (i = 0; i < BLK_ROWS; i++) {
+        a = _mm512_and_si512(xa[i], ya);
+        b = _mm512_and_si512(xb[i], yb);
+        h = _mm512_ternarylogic_epi64(o[i][j], a, b, 0xe8);
+        o[i][j] = _mm512_ternarylogic_epi64(o[i][j], a, b, 0x96);
+        t[i][j] = _mm512_add_epi64(t[i][j], pcnt_avx512(h));
+      }                         /* carry-save adder (Harley-Seal) */
+    }                           /* with ternary logic: 0xe8 is the */
+  }                             /* majority, 0x96 the parity */
+  for (i = 0; i < BLK_ROWS; i++)   /* combine carries and sum bits */
+    for (j = 0; j < BLK_COLS; j++)
+      cnt[i*BLK_COLS+j] = (int)_mm512_reduce_add_epi64(
+                          _mm512_add_epi64(_mm512_add_epi64(t[i][j], t[i][j]),
+                                           pcnt_avx512(o[i][j])));
+}  /* tblk_avx512() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __AVX2__
+
+FCM_TARGET("avx2")
+static inline __m256i pcnt_avx2 (__m256i v)
+{                               /* --- count bits in 64 bit lanes */
+  const __m256i lut  = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                        0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_and_si256(v, mask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+  lo = _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo),
+                       _mm256_shuffle_epi8(lut, hi));
+  return _mm256_sad_epu8(lo, _mm256_setzero_si256());
+}  /* pcnt_avx2() */            /* look up nibble counts and sum them */
+
+/*--------------------------------------------------------------------------*/
+
+FCM_TARGET("avx2,popcnt")
+static inline void tblk_avx2 (uint32_t **r, uint32_t **c, int n, int *cnt)
+{                               /* --- block of n11 counts (AVX2) */
+  __m256i  o[BLK_ROWS][BLK_COLS];  /* ones (carry-save sum bits) */
+  __m256i  t[BLK_ROWS][BLK_COLS];  /* bit counts of the carries */
+  __m256i  xa[BLK_ROWS], xb[BLK_ROWS];  /* row vectors */
+  __m256i  ya, yb, a, b, h;     /* column vectors, conjunctions */
+  uint64_t z[4];                /* to sum the 64 bit lanes */
+  int      i, j, k, e;          /* loop variables */
+
+  for (i = 0; i < BLK_ROWS; i++)   /* clear the accumulators */
+    for (j = 0; j < BLK_COLS; j++)
+      o[i][j] = t[i][j] = _mm256_setzero_si256();
+  for (k = 0; k+16 <= n; k += 16) {  /* process two vectors per step */
+    for (i = 0; i < BLK_ROWS; i++) {
+      xa[i] = _mm256_loadu_si256((__m256i*)(r[i]+k));
+      xb[i] = _mm256_loadu_si256((__m256i*)(r[i]+k+8));
+    }                           /* load the row vectors */
+    for (j = 0; j < BLK_COLS; j++) {
+      ya = _mm256_loadu_si256((__m256i*)(c[j]+k));
+      yb = _mm256_loadu_si256((__m256i*)(c[j]+k+8));
+      for (i = 0; i < BLK_ROWS; i++) {
+        a = _mm256_and_si256(xa[i], ya);
+        b = _mm256_and_si256(xb[i], yb);
+        h = _mm256_or_si256(_mm256_and_si256(o[i][j], a),
+            _mm256_and_si256(_mm256_xor_si256(o[i][j], a), b));
+        o[i][j] = _mm256_xor_si256(_mm256_xor_si256(o[i][j], a), b);
+        t[i][j] = _mm256_add_epi64(t[i][j], pcnt_avx2(h));
+      }                         /* carry-save adder (Harley-Seal): */
+    }                           /* only the carries are counted, */
+  }                             /* the sum bits are kept in o */
+  for (i = 0; i < BLK_ROWS; i++) {
+    for (j = 0; j < BLK_COLS; j++) {
+      a = _mm256_add_epi64(_mm256_add_epi64(t[i][j], t[i][j]),
+                           pcnt_avx2(o[i][j]));
+      e = k;                    /* combine carries and sum bits */
+      if (n-e >= 8) {           /* if there is one more full vector */
+        b = _mm256_and_si256(
+              _mm256_loadu_si256((__m256i*)(r[i]+e)),
+              _mm256_loadu_si256((__m256i*)(c[j]+e)));
+        a = _mm256_add_epi64(a, pcnt_avx2(b)); e += 8;
+      }                         /* count its bits directly */
+      _mm256_storeu_si256((__m256i*)z, a);
+      cnt[i*BLK_COLS+j] = (int)(z[0]+z[1]+z[2]+z[3]);
+      for ( ; e < n; e++)       /* sum the 64 bit lanes and */
+        cnt[i*BLK_COLS+j] += _mm_popcnt_u32(r[i][e] & c[j][e]);
+    }                           /* count the bits */
+  }                             /* of the remaining words */
+}  /* tblk_avx2() */
+
+#endif
+#endif  /* #ifndef TBLK_DEFINED */
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(tcc_run) (SFXNAME(FCMAT) *fcm,
+                              DIM ra, DIM rb, DIM ca, DIM cb, int raw)
+{                               /* --- compute a block of tetra. cc. */
+  uint32_t *r[BLK_ROWS];        /* rows    of a register block */
+  uint32_t *c[BLK_COLS];        /* columns of a register block */
+  uint32_t *data;               /* binarized data */
+  int      cnt[BLK_ROWS*BLK_COLS];  /* numbers of 11 configurations */
+  DIM      i, j, k, l;          /* loop variables */
+  int      x;                   /* number of words per series */
+  REAL     s;                   /* tetrachoric correlation coeff. */
+  void     (*blk)(uint32_t**, uint32_t**, int, int*);  /* kernel */
+
+  assert(fcm                    /* check the function arguments */
+  &&    (ra >= 0) && (rb > ra) && (rb <= fcm->V)
+  &&    (ca >= 0) && (cb > ca) && (cb <= fcm->V));
+  data = (uint32_t*)fcm->data;  /* get the binarized data */
+  x    = (int)fcm->X;           /* and the words per series */
+  blk  = NULL;                  /* default: count pair by pair */
+  #if defined FCM_ALL_ISA || defined __AVX2__
+  if (fcm->isa & FCM_ISA_AVX2)    blk = tblk_avx2;
+  #endif                        /* select the block kernel */
+  #if defined FCM_ALL_ISA || (defined __AVX512F__ && defined __AVX512BW__)
+  if (fcm->isa & FCM_ISA_AVX512BW) blk = tblk_avx512;
+  #endif
+  #if defined FCM_ALL_ISA \
+  || (defined __AVX512F__ && defined __AVX512VPOPCNTDQ__)
+  if (fcm->isa & FCM_ISA_VPOPCNT) blk = tblk_vpopcnt;
+  #endif
+  for (i = ra; i < rb; i += BLK_ROWS) {
+    for (k = 0; k < BLK_ROWS; k++)    /* collect the rows */
+      r[k] = data +(size_t)((i+k < rb) ? i+k : rb-1) *(size_t)x;
+    for (j = ca; j < cb; j += BLK_COLS) {
+      if (j+BLK_COLS-1 <= i)    /* skip blocks that lie completely */
+        continue;               /* in the lower triangle */
+      for (l = 0; l < BLK_COLS; l++)  /* collect the columns */
+        c[l] = data +(size_t)((j+l < cb) ? j+l : cb-1) *(size_t)x;
+      if (blk) blk(r, c, x, cnt);  /* count the 11 configurations */
+      else {                    /* with a block kernel or */
+        for (k = 0; k < BLK_ROWS; k++)  /* with the pair kernel */
+          for (l = 0; l < BLK_COLS; l++)
+            cnt[k*BLK_COLS+l] = fcm->pcand(r[k], c[l], x);
+      }
+      for (k = 0; k < BLK_ROWS; k++) {
+        for (l = 0; l < BLK_COLS; l++) {
+          if ((i+k >= rb) || (j+l >= cb) || (j+l <= i+k))
+            continue;           /* skip duplicates and lower triangle */
+          s = (raw)             /* store the raw counts or map them */
+            ? (REAL)cnt[k*BLK_COLS+l] : fcm->cmap[cnt[k*BLK_COLS+l]];
+          fcm->dst[(size_t)(i+k-fcm->dr) *(size_t)fcm->tile
+                  +(size_t)(j+l-fcm->dc)] = s;
+        }                       /* map the counts to correlation */
+      }                         /* coefficients and store them */
+    }                           /* in the cache (the transform is */
+  }                             /* folded into the cosine map) */
+}  /* tcc_run() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(tcc_blk) (SFXNAME(FCMAT) *fcm,
+                              DIM ra, DIM rb, DIM ca, DIM cb)
+{                               /* --- compute a block of tetra. cc. */
+  SFXNAME(tcc_run)(fcm, ra, rb, ca, cb, 0);
+}  /* tcc_blk() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(tcc_cnt) (SFXNAME(FCMAT) *fcm,
+                              DIM ra, DIM rb, DIM ca, DIM cb)
+{                               /* --- count 11 configs. of a block */
+  SFXNAME(tcc_run)(fcm, ra, rb, ca, cb, 1);
+}  /* tcc_cnt() */              /* (for a half-stored tetra. cc.) */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(win_blk) (SFXNAME(FCMAT) *fcm,
+                              DIM ra, DIM rb, DIM ca, DIM cb)
+{                               /* --- summarize windows of a block */
+  DIM i, j;                     /* loop variables */
+
+  assert(fcm                    /* check the function arguments */
+  &&    (ra >= 0) && (rb > ra) && (rb <= fcm->V)
+  &&    (ca >= 0) && (cb > ca) && (cb <= fcm->V));
+  for (i = ra; i < rb; i++)     /* traverse the upper triangle */
+    for (j = (ca > i+1) ? ca : i+1; j < cb; j++)
+      fcm->dst[(size_t)(i-fcm->dr) *(size_t)fcm->tile
+              +(size_t)(j-fcm->dc)] = SFXNAME(fcm_pccwin)(fcm, i, j);
+}  /* win_blk() */              /* (all windows of a pair at once) */
 
 /*--------------------------------------------------------------------------*/
 #ifdef PAIRSPLIT                /* --- split rectangle into 2 parts */
@@ -180,15 +746,21 @@ inline void SFXNAME(rec_rct) (SFXNAME(WORK) *w,
       SFXNAME(rec_rct)(w, ra, rb, j, cb);
     } }                         /* process the parts recursively */
   else {                        /* if no larger than minimum size */
-    REAL *cache = w->fcm->cache;/* get the cache array */
-    DIM  r = w->fcm->ra;        /* and the coordinates */
-    DIM  c = w->fcm->ca;        /* of the reference element */
-    for (i = ra; i < rb; i++) { /* traverse the rows */
-      for (j = ca; j < cb; j++) /* traverse the columns */
-        cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
-          = w->get(w->fcm, i, j);
-    }                           /* compute correlation coefficient */
-  }                             /* and store it in the cache */
+    w->comp += (size_t)(rb-ra) *(size_t)(cb-ca);
+    w->rows += (size_t)(rb-ra) +(size_t)(cb-ca); /* count elements */
+    if (w->blk)                 /* if there is a block function, */
+      w->blk(w->fcm, ra, rb, ca, cb);   /* compute the whole block */
+    else {                      /* if to compute single elements */
+      REAL *cache = w->fcm->dst;  /* get the cache array */
+      DIM  r = w->fcm->dr;      /* and the coordinates */
+      DIM  c = w->fcm->dc;      /* of the reference element */
+      for (i = ra; i < rb; i++) { /* traverse the rows */
+        for (j = ca; j < cb; j++) /* traverse the columns */
+          cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
+            = w->get(w->fcm, i, j);
+      }                         /* compute correlation coefficient */
+    }                           /* and store them in the cache */
+  }
 }  /* rec_rct() */
 
 /*--------------------------------------------------------------------------*/
@@ -202,7 +774,8 @@ inline void SFXNAME(rec_rct) (SFXNAME(WORK) *w,
   &&    (rb > ra) && (rb <= w->fcm->V)
   &&    (ca >= 0) && (ca <  w->fcm->V)
   &&    (cb > ca) && (cb <= w->fcm->V));
-  if (cb-ca > TILE_MIN) {       /* if larger than minimum size */
+  if ((cb-ca > TILE_MIN)        /* if larger than minimum size */
+  &&  (rb-ra > 1)) {            /* and not a single row */
     DIM i = (ra+rb)/2;          /* halven the tile size and */
     DIM j = (ca+cb)/2;          /* process parts recursively */
     SFXNAME(rec_rct)(w, ra, i, ca, j);
@@ -210,15 +783,21 @@ inline void SFXNAME(rec_rct) (SFXNAME(WORK) *w,
     SFXNAME(rec_rct)(w, i, rb, j, cb);
     SFXNAME(rec_rct)(w, i, rb, ca, j); }
   else {                        /* if no larger than minimum size */
-    REAL *cache = w->fcm->cache;/* get the cache array */
-    DIM  i, r = w->fcm->ra;     /* and the coordinates */
-    DIM  j, c = w->fcm->ca;     /* of the reference element */
-    for (i = ra; i < rb; i++) { /* traverse the rows */
-      for (j = ca; j < cb; j++) /* traverse the columns */
-        cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
-          = w->get(w->fcm, i, j);
-    }                           /* compute correlation coefficient */
-  }                             /* and store it in the cache */
+    w->comp += (size_t)(rb-ra) *(size_t)(cb-ca);
+    w->rows += (size_t)(rb-ra) +(size_t)(cb-ca); /* count elements */
+    if (w->blk)                 /* if there is a block function, */
+      w->blk(w->fcm, ra, rb, ca, cb);   /* compute the whole block */
+    else {                      /* if to compute single elements */
+      REAL *cache = w->fcm->dst;  /* get the cache array */
+      DIM  i, r = w->fcm->dr;   /* and the coordinates */
+      DIM  j, c = w->fcm->dc;   /* of the reference element */
+      for (i = ra; i < rb; i++) { /* traverse the rows */
+        for (j = ca; j < cb; j++) /* traverse the columns */
+          cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
+            = w->get(w->fcm, i, j);
+      }                         /* compute correlation coefficient */
+    }                           /* and store them in the cache */
+  }
 }  /* rec_rct() */
 
 #endif
@@ -235,17 +814,49 @@ inline void SFXNAME(rec_trg) (SFXNAME(WORK) *w, DIM a, DIM b)
     SFXNAME(rec_rct)(w, a, i, i, b);
     SFXNAME(rec_trg)(w, i, b); }
   else {                        /* if no larger than min. tile size */
-    REAL *cache = w->fcm->cache;/* get the cache array */
-    DIM  i, r = w->fcm->ra;     /* and the coordinates */
-    DIM  j, c = w->fcm->ca;     /* of the reference element */
-    for (i = a; i < b; i++) {   /* traverse the rows */
-      for (j = i+1; j < b; j++) /* traverse the columns */
-        cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
-          = w->get(w->fcm, i, j);
-    }                           /* compute the correlation coeff. */
-  }                             /* and store it in the cache */
+    w->comp += (size_t)(b-a) *(size_t)(b-a-1) /2;
+    w->rows += (size_t)(b-a);   /* count elements and data rows */
+    if (w->blk)                 /* if there is a block function, */
+      w->blk(w->fcm, a, b, a, b); /* compute the whole triangle */
+    else {                      /* if to compute single elements */
+      REAL *cache = w->fcm->dst;  /* get the cache array */
+      DIM  i, r = w->fcm->dr;   /* and the coordinates */
+      DIM  j, c = w->fcm->dc;   /* of the reference element */
+      for (i = a; i < b; i++) { /* traverse the rows */
+        for (j = i+1; j < b; j++) /* traverse the columns */
+          cache[(size_t)(i-r) *(size_t)w->fcm->tile +(size_t)(j-c)]
+            = w->get(w->fcm, i, j);
+      }                         /* compute the correlation coeff. */
+    }                           /* and store them in the cache */
+  }
 }  /* rec_trg() */
 
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(rec_dyn) (SFXNAME(WORK) *w)
+{                               /* --- process pulled sub-blocks */
+  SFXNAME(FCMAT) *fcm = w->fcm; /* underlying f.c. matrix object */
+  DIM s = fcm->sub;             /* size of the sub-blocks */
+  DIM m = (w->cb -w->ca +s-1)/s;/* number of sub-block columns */
+  DIM i, j, k;                  /* sub-block row/column and index */
+  DIM ra, rb, ca, cb;           /* row and column range */
+
+  assert(w && (s > 0));         /* check the function argument */
+  while ((k = (DIM)FETCH_ADD(&fcm->subi, 1)) < fcm->subn) {
+    if (w->work & TRIANGLE) {   /* if the tile is a triangle, */
+      for (i = 0; k >= m-i; i++)/* enumerate the sub-blocks */
+        k -= m-i;               /* on and above the diagonal */
+      j = i+k; }                /* row by row */
+    else {                      /* if the tile is a rectangle, */
+      i = k / m; j = k % m; }   /* enumerate all sub-blocks */
+    ra = w->ra +i*s; rb = (ra+s < w->rb) ? ra+s : w->rb;
+    ca = w->ca +j*s; cb = (ca+s < w->cb) ? ca+s : w->cb;
+    if ((w->work & TRIANGLE) && (i == j))
+      SFXNAME(rec_trg)(w, ca, cb);    /* process a diagonal block */
+    else SFXNAME(rec_rct)(w, ra, rb, ca, cb);
+  }                             /* or an off-diagonal/rect. block */
+}  /* rec_dyn() */               /* until all sub-blocks are taken */
+
 /*--------------------------------------------------------------------------*/
 #ifdef PAIRSPLIT                /* --- split rectangle into 2 parts */
 
@@ -255,43 +866,24 @@ inline WORKERDEF(fill, p)
   DIM a;                        /* start index for second strip */
 
   assert(p);                    /* check the function argument */
-  #ifndef _WIN32                /* not yet available for Windows */
-  while (1) {                   /* work loop for blocked threads */
-    if (!w->fcm->join) {        /* if to block and signal threads */
-      pthread_mutex_lock(&w->fcm->mutex);
-      w->fcm->idle++;           /* signal that thread is idle */
-      pthread_cond_signal(&w->fcm->cond_idle);
-      while (!w->work)          /* wait until work is assigned */
-        pthread_cond_wait(&w->fcm->cond_work, &w->fcm->mutex);
-      pthread_mutex_unlock(&w->fcm->mutex);
-      if (w->work < 0) break;   /* if processing was stopped, */
-    }                           /* terminate the thread */
-  #endif
-    #ifdef FCM_BENCH            /* if to do some benchmarking */
-    w->beg = timer();           /* note the start time of the thread */
-    #endif
-    if (w->work == RECTANGLE)   /* if to process a rectangle */
-      SFXNAME(rec_rct)(w, w->ra, w->rb, w->ca, w->cb);
-    else {                      /* if to process a triangle */
-      while (1) {               /* process two strip parts */
-        if (w->ca > w->ra)      /* process rectangle part of strip */
-          SFXNAME(rec_rct)(w, w->ra, w->ca, w->ca, w->cb);
-        SFXNAME(rec_trg)(w, w->ca, w->cb); /* process triangle part */
-        if (w->ca > w->cm/2) break;  /* if second strip done, abort */
-        a     = w->cm -w->cb;   /* get start of opposite strip */
-        if (w->cb > a)       break;  /* if no opposite strip, abort */
-        w->cb = w->cm -w->ca;   /* get start and end index */
-        w->ca = a;              /* of the opposite strip */
-      }
+  w->beg = timer();             /* note the start time of the thread */
+  if (w->work & DYNAMIC)        /* if to pull sub-blocks */
+    SFXNAME(rec_dyn)(w);        /* from a shared counter */
+  else if (w->work == RECTANGLE)/* if to process a rectangle */
+    SFXNAME(rec_rct)(w, w->ra, w->rb, w->ca, w->cb);
+  else {                        /* if to process a triangle */
+    while (1) {                 /* process two strip parts */
+      if (w->ca > w->ra)        /* process rectangle part of strip */
+        SFXNAME(rec_rct)(w, w->ra, w->ca, w->ca, w->cb);
+      SFXNAME(rec_trg)(w, w->ca, w->cb);   /* process triangle part */
+      if (w->ca > w->cm/2) break;    /* if second strip done, abort */
+      a     = w->cm -w->cb;     /* get start of opposite strip */
+      if (w->cb > a)       break;    /* if no opposite strip, abort */
+      w->cb = w->cm -w->ca;     /* get start and end index */
+      w->ca = a;                /* of the opposite strip */
     }
-    #ifdef FCM_BENCH            /* if to do some benchmarking */
-    w->end = timer();           /* note the end time of the thread */
-    #endif
-  #ifndef _WIN32                /* not yet available for Windows */
-    if (w->fcm->join) break;    /* if to join the threads */
-    w->work = 0;                /* after the work is done, abort, */
-  }                             /* otherwise mark work as done */
-  #endif
+  }
+  w->end = timer();             /* note the end time of the thread */
   return THREAD_OK;             /* return a dummy result */
 }  /* fill() */
 
@@ -304,65 +896,124 @@ inline WORKERDEF(fill, p)
   DIM a, b, k;                  /* loop variables */
 
   assert(p);                    /* check the function argument */
-  #ifndef _WIN32                /* not yet available for Windows */
-  while (1) {                   /* work loop for blocked threads */
-    if (!w->fcm->join) {        /* if to block and signal threads */
-      pthread_mutex_lock(&w->fcm->mutex);
-      w->fcm->idle++;           /* signal that thread is idle */
-      pthread_cond_signal(&w->fcm->cond_idle);
-      while (!w->work)          /* wait until work is assigned */
-        pthread_cond_wait(&w->fcm->cond_work, &w->fcm->mutex);
-      pthread_mutex_unlock(&w->fcm->mutex);
-      if (w->work < 0) break;   /* if processing was stopped, */
-    }                           /* terminate the thread */
-  #endif
-    #ifdef FCM_BENCH            /* if to do some benchmarking */
-    w->beg = timer();           /* note the start time of the thread */
-    #endif
-    if (w->work == RECTANGLE) { /* if to process a rectangle */
-      k = w->rb -w->ra;         /* get the size of the rectangles */
-      for (a = w->ca; a < w->cb; a += k) {
-        b = (a+k < w->cb) ? a+k : w->cb;
-        SFXNAME(rec_rct)(w, w->ra, w->rb, a, b);
-      } }                       /* split the strip into squares */
-    else {                      /* if to process a triangle */
-      while (1) {               /* process two strip parts */
-        SFXNAME(rec_trg)(w, w->ca, w->cb);
-        k = w->cb -w->ca;       /* compute leading triangle */
-        for (a = w->ra; a < w->ca; a += k) {
-          b = (a+k < w->ca) ? a+k : w->ca;
-          SFXNAME(rec_rct)(w, a, b, w->ca, w->cb);
-        }                       /* split the strip into squares */
-        if (w->ca > w->cm/2) break; /* if second strip done, abort */
-        a     = w->cm -w->cb;   /* get start of opposite strip */
-        if (w->cb > a)       break; /* if no opposite strip, abort */
-        w->cb = w->cm -w->ca;   /* get start and end index */
-        w->ca = a;              /* of the opposite strip */
-      }
+  w->beg = timer();             /* note the start time of the thread */
+  if (w->work & DYNAMIC)        /* if to pull sub-blocks */
+    SFXNAME(rec_dyn)(w);        /* from a shared counter */
+  else if (w->work == RECTANGLE) {    /* if to process a rectangle */
+    k = w->rb -w->ra;           /* get the size of the rectangles */
+    for (a = w->ca; a < w->cb; a += k) {
+      b = (a+k < w->cb) ? a+k : w->cb;
+      SFXNAME(rec_rct)(w, w->ra, w->rb, a, b);
+    } }                         /* split the strip into squares */
+  else {                        /* if to process a triangle */
+    while (1) {                 /* process two strip parts */
+      SFXNAME(rec_trg)(w, w->ca, w->cb);
+      k = w->cb -w->ca;         /* compute leading triangle */
+      for (a = w->ra; a < w->ca; a += k) {
+        b = (a+k < w->ca) ? a+k : w->ca;
+        SFXNAME(rec_rct)(w, a, b, w->ca, w->cb);
+      }                         /* split the strip into squares */
+      if (w->ca > w->cm/2) break;   /* if second strip done, abort */
+      a     = w->cm -w->cb;     /* get start of opposite strip */
+      if (w->cb > a)       break;   /* if no opposite strip, abort */
+      w->cb = w->cm -w->ca;     /* get start and end index */
+      w->ca = a;                /* of the opposite strip */
     }
-    #ifdef FCM_BENCH            /* if to do benchmarking */
-    w->end = timer();           /* note the end time of the thread */
-    #endif
-  #ifndef _WIN32                /* not yet available for Windows */
-    if (w->fcm->join) break;    /* if to join the threads */
-    w->work = 0;                /* after the work is done, abort, */
-  }                             /* otherwise mark work as done */
-  #endif
+  }
+  w->end = timer();             /* note the end time of the thread */
   return THREAD_OK;             /* return a dummy result */
 }  /* fill() */
 
 #endif
 /*--------------------------------------------------------------------------*/
+#ifndef _WIN32                  /* not yet available for Windows */
 
-inline int SFXNAME(fcm_fill) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
-{                               /* --- fill the cache */
-  #ifdef RECTGRID               /* if to split rectangle into grid */
+inline WORKERDEF(spin, p)
+{                               /* --- dedicated worker (FCM_SPIN) */
+  SFXNAME(WORK) *w = p;         /* type the argument pointer */
+
+  assert(p);                    /* check the function argument */
+  while (1) {                   /* work loop of the worker */
+    fcm_barwait(&w->fcm->bar);  /* wait for a posted tile fill */
+    if (w->work < 0) break;     /* check for the stop indicator */
+    if (w->work > 0) SFXNAME(fill)(w);
+    fcm_barwait(&w->fcm->bar);  /* fill the assigned part (if any) */
+  }                             /* and signal that it is finished */
+  return THREAD_OK;             /* return a dummy result */
+}  /* spin() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_start) (SFXNAME(FCMAT) *fcm)
+{                               /* --- start dedicated workers */
+  SFXNAME(WORK) *w = fcm->work; /* data for the worker threads */
+  DIM    i, k, n;               /* loop variables for threads */
+
+  assert(fcm && fcm->work && fcm->threads);
+  k = (fcm->ahead) ? 0 : 1;     /* the caller fills the first part */
+  fcm_barinit(&fcm->bar, (int)(fcm->nthd-k)+1);
+  for (n = k; n < fcm->nthd; n++) {  /* unless a tile is filled ahead */
+    w[n].work = 0;              /* clear the assigned work */
+    if (pthread_create(fcm->threads+n, NULL, SFXNAME(spin), w+n) != 0)
+      break;                    /* start the worker threads */
+  }                             /* (they wait at the barrier) */
+  if (n >= fcm->nthd) return 0; /* if all workers started, return */
+  for (i = n; i < fcm->nthd; i++)
+    fcm_bardrop(&fcm->bar);     /* remove the missing workers */
+  fcm->nthd = n;                /* from the barrier, so that */
+  return -1;                    /* fcm_stop() can stop the others */
+}  /* fcm_start() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_stop) (SFXNAME(FCMAT) *fcm)
+{                               /* --- stop dedicated workers */
+  SFXNAME(WORK) *w = fcm->work; /* data for the worker threads */
+  DIM    i;                     /* loop variable for threads */
+
+  assert(fcm && (fcm->bar.n > 0));
+  for (i = 0; i < fcm->nthd; i++)
+    w[i].work = -1;             /* set the thread stop indicators */
+  fcm_barwait(&fcm->bar);       /* and release the workers */
+  for (i = (fcm->ahead) ? 0 : 1; i < fcm->nthd; i++)
+    pthread_join(fcm->threads[i], NULL);
+  fcm->bar.n = 0;               /* wait for all threads to finish */
+}  /* fcm_stop() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+
+inline DIM SFXNAME(fcm_subs) (SFXNAME(FCMAT) *fcm, int shape,
+                              DIM ra, DIM rb, DIM ca, DIM cb)
+{                               /* --- split a tile into sub-blocks */
+  SFXNAME(WORK) *w = fcm->work; /* data for the worker threads */
+  DIM    m, s, r, c;            /* number and size of sub-blocks */
+  DIM    n;                     /* loop variable for threads */
+
+  for (m = 1; m*m < SUB_CNT*fcm->nthd; m++);
+  s = (((rb-ra > cb-ca) ? rb-ra : cb-ca) +m-1) /m;
+  s = ((s +TILE_MIN-1) /TILE_MIN) *TILE_MIN;
+  r = (rb-ra +s-1) /s;          /* size of the sub-blocks: a multiple */
+  c = (cb-ca +s-1) /s;          /* of TILE_MIN, about m x m of them */
+  fcm->sub  = s;                /* note the size and the number */
+  fcm->subn = (int)((shape & TRIANGLE) ? c*(c+1)/2 : r*c);
+  fcm->subi = 0;                /* of sub-blocks and start with */
+  for (n = 0; n < fcm->nthd; n++) {   /* the first sub-block */
+    if (n >= fcm->subn) break;  /* (more threads are not needed) */
+    w[n].ra = ra; w[n].rb = rb; /* all threads get the whole tile */
+    w[n].ca = ca; w[n].cb = cb; /* and pull its sub-blocks */
+  }                             /* from the shared counter */
+  return n;                     /* return the number of threads */
+}  /* fcm_subs() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_post) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- start filling a tile */
+  DIM    ra, rb, ca, cb;        /* row and column range of the tile */
   DIM    i, j, n;               /* loop variables for threads */
   DIM    x, y;                  /* number of grid rows/columns */
   DIM    dx, dy;                /* number of voxels per grid row/col. */
-  #else                         /* if to split rectangle into strips */
-  DIM    i, n;                  /* loop variables for threads */
-  #endif
   int    shape;                 /* shape of area to cache */
   DIM    k;                     /* number of rows/columns */
   DIM    m;                     /* reference column for mirroring */
@@ -376,77 +1027,65 @@ inline int SFXNAME(fcm_fill) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
   &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
   if (row > col) {              /* ensure col >= row (upper triangle) */
     DIM t = row; row = col; col = t; }
-  fcm->ra = row -(row % fcm->tile);
-  fcm->rb = fcm->ra +fcm->tile; /* compute the new row    range */
-  if (fcm->rb > fcm->V) fcm->rb = fcm->V;
-  fcm->ca = col -(col % fcm->tile);
-  fcm->cb = fcm->ca +fcm->tile; /* compute the new column range */
-  if (fcm->cb > fcm->V) fcm->cb = fcm->V;
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
-  fcm->cnt += 1;                /* count the number of times */
-  #endif                        /* that the cache was filled */
+  fcm->dr = ra = row -(row % fcm->tile);
+  rb = ra +fcm->tile;           /* compute the new row    range */
+  if (rb > fcm->V) rb = fcm->V;
+  fcm->dc = ca = col -(col % fcm->tile);
+  cb = ca +fcm->tile;           /* compute the new column range */
+  if (cb > fcm->V) cb = fcm->V; /* (the tile is written to fcm->dst) */
+  fcm->post[0] = timer();       /* note the start time and count */
+  fcm->stats.fills++;           /* the times the cache was filled */
   w = fcm->work;                /* get the data for the workers */
-  if (fcm->ra >= fcm->ca) {     /* if to process a triangle */
+  if ((fcm->mode & FCM_DYNAMIC) && (fcm->nthd > 1)) {
+    shape = ((ra >= ca) ? TRIANGLE : RECTANGLE) | DYNAMIC;
+    n = SFXNAME(fcm_subs)(fcm, shape, ra, rb, ca, cb); }
+  else if (ra >= ca) {          /* if to process a triangle */
     shape = TRIANGLE;           /* note shape of area to cache */
-    m =   fcm->cb +fcm->ca;     /* reference index for mirroring */
-    k = ((fcm->cb -fcm->ca)/2 +(DIM)fcm->nthd-1) /(DIM)fcm->nthd;
+    m =   cb +ca;               /* reference index for mirroring */
+    k = ((cb -ca)/2 +(DIM)fcm->nthd-1) /(DIM)fcm->nthd;
     if (k <= 0) k = 1;          /* compute the number of voxels */
     for (n = 0; n < fcm->nthd; n++) {
-      w[n].ra = fcm->ra;        /* traverse the threads */
-      w[n].rb = fcm->rb;        /* note the row range and */
-      w[n].ca = fcm->ca +n*k;   /* compute the column start index */
+      w[n].ra = ra;             /* traverse the threads */
+      w[n].rb = rb;             /* note the row range and */
+      w[n].ca = ca +n*k;        /* compute the column start index */
       if (w[n].ca >= m/2)       /* if beyond half of the columns, */
         break;                  /* all columns are provided for */
       w[n].cb = w[n].ca +k;     /* compute and store end index */
-      if (w[n].cb >= m/2) w[n].cb = fcm->cb -n*k;
+      if (w[n].cb >= m/2) w[n].cb = cb -n*k;
       w[n].cm = m;              /* ensure no duplicate computations */
     } }                         /* and note reference for mirroring */
-  #ifdef RECTGRID               /* if to split rectangle into grid */
   else {                        /* if to process a rectangle */
     shape = RECTANGLE;          /* note shape of area to cache */
     x = fcm->gc;                /* get the number of grid  columns */
-    k = fcm->cb -fcm->ca;       /* and the number of voxel columns */
+    k = cb -ca;                 /* and the number of voxel columns */
     if (x > k) { x = k; dx = 1;}/* limit grid to voxel columns */
     else dx = (k +x-1) /x;      /* compute columns per grid column */
     y = fcm->gr;                /* get the number of grid  rows */
-    k = fcm->rb -fcm->ra;       /* and the number of voxel rows */
+    k = rb -ra;                 /* and the number of voxel rows */
     if (y > k) { y = k; dy = 1;}/* limit grid to voxel rows */
     else dy = (k +y-1) /y;      /* compute rows    per grid row */
     n  = 0;                     /* initialize the thread index */
-    for (i = 0; i < x; i++) {   /* traverse the grid rows */
-      for (j = 0; j < y; j++) { /* traverse the grid columns */
-        w[n].ra = fcm->ra +j*dy;/* compute the row range */
+    for (i = 0; i < x; i++) {   /* traverse the grid columns */
+      for (j = 0; j < y; j++) { /* traverse the grid rows */
+        w[n].ra = ra +j*dy;     /* compute the row range */
         w[n].rb = w[n].ra +dy;  /* for the next grid cell */
-        if (w[n].rb > fcm->rb) w[n].rb = fcm->rb;
-        w[n].ca = fcm->ca +i*dx;/* compute the column range */
+        if (w[n].rb > rb) w[n].rb = rb;
+        w[n].ca = ca +i*dx;     /* compute the column range */
         w[n].cb = w[n].ca +dx;  /* for the next grid cell */
-        if (w[n].cb > fcm->cb) w[n].cb = fcm->cb;
-        n++;                    /* advance the thread index */
-      }
-    }                           /* initialize the grid cells */
-  }                             /* to be processed by the threads */
-  #else                         /* if to split rectangle into strips */
-  else {                        /* if to process a rectangle */
-    shape = RECTANGLE;          /* note shape of area to cache */
-    k = ((fcm->rb-fcm->ra) +fcm->nthd-1) /fcm->nthd;
-    if (k <= 0) k = 1;          /* compute the number of voxels */
-    for (n = 0; n < fcm->nthd; n++) {
-      w[n].ca = fcm->ca;        /* traverse the threads */
-      w[n].cb = fcm->cb;        /* note the column range and */
-      w[n].ra = fcm->ra +n*k;   /* compute the row start index */
-      if (w[n].ra >= fcm->rb)   /* if beyond the last row, */
-        break;                  /* all rows are provided for */
-      w[n].rb = w[n].ra +k;     /* compute and store end index */
-      if (w[n].rb >  fcm->rb) w[n].rb = fcm->rb;
-    }                           /* initialize the row/column ranges */
+        if (w[n].cb > cb) w[n].cb = cb;
+        if ((w[n].ra < w[n].rb) && (w[n].ca < w[n].cb))
+          n++;                  /* skip empty grid cells and */
+      }                         /* advance the thread index */
+    }                           /* (strips: gr = nthd, gc = 1) */
   }                             /* to be processed by the threads */
-  #endif
   fcm->err = 0;                 /* clear the error status */
   worker   = SFXNAME(fill);     /* get the worker function */
-  if (n <= 1) {                 /* if there is only one thread, */
+  if ((n <= 1) && !fcm->ahead) {/* if there is only one thread, */
     w[0].work = shape;          /* note shape of area to cache and */
-    worker(w); return 0;        /* execute the worker directly */
-  }
+    worker(w); fcm->pend = 1;   /* execute the worker directly */
+    fcm->post[1] = timer();     /* note the end time of posting */
+    return fcm->err;            /* (fcm_wait() returns immediately) */
+  }                             /* (a tile filled ahead is posted) */
   #ifdef _WIN32                 /* if Microsoft Windows system */
   for (i = 0; i < n; i++) {     /* traverse the threads */
     w[i].work = shape;          /* set the area shape identifier */
@@ -466,34 +1105,227 @@ inline int SFXNAME(fcm_fill) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
     for (i = 0; i < n; i++) {   /* wait for threads to finish */
       pthread_join(fcm->threads[i], NULL);
     } }                         /* (join threads with this one) */
-  else {                        /* if to block and signal threads */
-    pthread_mutex_lock(&fcm->mutex);
-    for (i = 0; i < n; i++)     /* traverse the treads and */
-      w[i].work = shape;        /* assign work to each thread */
-    fcm->idle = 0;              /* signal that work was assigned */
-    pthread_cond_broadcast(&fcm->cond_work);
-    while (fcm->idle < n)       /* wait for threads to finish */
-      pthread_cond_wait(&fcm->cond_idle, &fcm->mutex);
-    pthread_mutex_unlock(&fcm->mutex);
-  }                             /* now all threads are blocked */
+  else if (fcm->bar.n > 0) {    /* if to use dedicated workers */
+    for (i = 0; i < fcm->nthd; i++)
+      w[i].work = (i < n) ? shape : 0;
+    fcm_barwait(&fcm->bar);     /* assign the parts of the tile */
+  }                             /* and release the workers */
+  else {                        /* if to use the shared pool */
+    for (i = 0; i < n; i++)     /* traverse the parts and */
+      w[i].work = shape;        /* set the area shape identifiers */
+    fcm_poolpost(&fcm->job, worker, w, sizeof(SFXNAME(WORK)),
+                 (int)n, (fcm->ahead) ? (int)n : (int)n-1);
+  }                             /* (the workers are waited for */
+  #endif                        /* in fcm_wait(), which executes the */
+  fcm->pend    = n;             /* remaining pool tasks, so that the */
+  fcm->post[1] = timer();       /* caller may work meanwhile) */
+  return fcm->err;              /* return the error status */
+}  /* fcm_post() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_wait) (SFXNAME(FCMAT) *fcm)
+{                               /* --- wait for a tile fill */
+  SFXNAME(WORK) *w = fcm->work; /* data for worker thread */
+  FCMSTATS *s;                  /* statistics of a thread */
+  DIM    i;                     /* loop variable for threads */
+  DIM    n = fcm->pend;         /* number of workers */
+  double t[4];                  /* start/end times of post and wait */
+  double min, max;              /* time span of the threads */
+  double o;                     /* overlap with the time span */
+  size_t e;                     /* size of a data element */
+
+  assert(fcm);                  /* check the function argument */
+  if (n <= 0) return fcm->err;  /* check for a posted fill */
+  t[0] = fcm->post[0]; t[1] = fcm->post[1];
+  t[2] = timer();               /* note the start time of waiting */
+  #ifndef _WIN32                /* if Linux/Unix system */
+  if (!fcm->join && ((n > 1) || fcm->ahead)) {
+    if (fcm->bar.n <= 0)        /* wait for the pool tasks */
+      fcm_poolwait(&fcm->job);  /* or for the dedicated workers */
+    else {                      /* (unless a tile is filled ahead, */
+      if (!fcm->ahead)          /* the caller fills the first part) */
+        SFXNAME(fill)(fcm->work);
+      fcm_barwait(&fcm->bar);
+    }
+  }
   #endif
-  #ifdef FCM_BENCH              /* if to do some benchmarking */
-  double min = +INFINITY;       /* initialize minimal start time */
-  double max = -INFINITY;       /* and maximal end time of a thread */
+  t[3] = timer();               /* note the end time of waiting */
+  fcm->pend = 0;                /* the fill is complete */
+  min = +INFINITY;              /* initialize minimal start time */
+  max = -INFINITY;              /* and maximal end time of a thread */
   for (i = 0; i < n; i++) {     /* traverse the threads */
     if (w[i].beg < min) min = w[i].beg;
     if (w[i].end > max) max = w[i].end;
   }                             /* find min. start/max. end time */
-  fcm->sum += max -min;         /* find time span for threads */
-  for (i = 0; i < n; i++) {     /* traverse the threads again */
-    fcm->beg += w[i].beg -min;  /* compute loss at start */
-    fcm->end += max -w[i].end;  /* compute loss at end */
-  }                             /* of each thread */
-  #endif
+  fcm->stats.time += max -min;  /* sum the time spans of the fills */
+  for (i = 0; i < 4; i += 2) {  /* traverse posting and waiting */
+    o = ((t[i+1] < max) ? t[i+1] : max) -((t[i] > min) ? t[i] : min);
+    fcm->stats.sync += t[i+1] -t[i] -((o > 0) ? o : 0);
+  }                             /* sum the time outside the fill */
+  e = ((fcm->mode & FCM_CORR) == FCM_TCC)
+    ? sizeof(uint32_t) : sizeof(REAL);
+  for (i = 0; fcm->tst && (i < n); i++) {
+    s = fcm->tst +i;            /* traverse the threads */
+    s->comp  += w[i].comp;      /* transfer the counters */
+    s->bytes += (double)w[i].rows *(double)fcm->X *(double)e;
+    s->busy  += w[i].end -w[i].beg;
+    s->idle  += (max -min) -(w[i].end -w[i].beg);
+    w[i].comp = w[i].rows = 0;  /* sum the busy and idle times */
+  }                             /* and reset the thread counters */
+  return fcm->err;              /* return the error status */
+}  /* fcm_wait() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_fill) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- fill the cache */
+  SFXNAME(fcm_wait)(fcm);       /* wait for a tile filled ahead */
+  fcm->dst = fcm->cache;        /* and fill the current tile */
+  SFXNAME(fcm_post)(fcm, row, col);
+  SFXNAME(fcm_wait)(fcm);
+  fcm->ra = fcm->dr;            /* set the new row range */
+  fcm->rb = fcm->ra +fcm->tile; /* and the new column range */
+  if (fcm->rb > fcm->V) fcm->rb = fcm->V;
+  fcm->ca = fcm->dc;
+  fcm->cb = fcm->ca +fcm->tile;
+  if (fcm->cb > fcm->V) fcm->cb = fcm->V;
   return fcm->err;              /* return the error status */
 }  /* fcm_fill() */
 
 
+/*----------------------------------------------------------------------------
+  Tile Slot Functions
+----------------------------------------------------------------------------*/
+/* With FCM_SLOTS the cache holds up to K tiles. fcm->cache, ra, rb, */
+/* ca and cb always describe the current tile, so the fast path of   */
+/* the retrieval functions is unchanged. On a miss, fcm_slot() looks */
+/* the tile up in a hash table (open addressing, linear probing) and */
+/* only fills a tile that is not cached, replacing a slot with the   */
+/* CLOCK algorithm (an approximation of least recently used).       */
+
+#ifndef SLOT_DEFINED            /* (independent of the type of REAL) */
+#define SLOT_DEFINED
+
+static inline int slot_bits (int k)
+{                               /* --- hash table size for k slots */
+  int b = 1;                    /* (a power of 2, at least 2k, so */
+  while ((1 << b) < 2*k) b++;   /* that probe sequences are short) */
+  return b;
+}  /* slot_bits() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline size_t slot_memsz (int k)
+{                               /* --- memory for slot management */
+  return (size_t)k *(2*sizeof(DIM) +sizeof(uint8_t))
+       + ((size_t)1 << slot_bits(k)) *sizeof(int);
+}  /* slot_memsz() */           /* (tile memory is not included) */
+
+/*--------------------------------------------------------------------------*/
+
+#define SLOT_HASH(f,r,c) \
+  ((int)((((uint64_t)((r)/(f)->tile) \
+         *(uint64_t)(((f)->V +(f)->tile-1)/(f)->tile) \
+         +(uint64_t)((c)/(f)->tile)) *0x9e3779b97f4a7c15ULL) \
+        >> (64-(f)->slot.bits)))  /* Fibonacci hashing of tile index */
+
+#endif
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_slots) (SFXNAME(FCMAT) *fcm, int k)
+{                               /* --- set up tile slots */
+  size_t z, n;                  /* size of a tile, number of tiles */
+  REAL   *p;                    /* memory for the tile slots */
+  char   *m;                    /* memory for slot management */
+  int    i;                     /* loop variable */
+
+  assert(fcm && (fcm->tile > 0) && (fcm->tile < fcm->V) && fcm->cache);
+  n = ((size_t)fcm->V +(size_t)fcm->tile-1) /(size_t)fcm->tile;
+  n = n *(n+1)/2;               /* number of tiles of the triangle */
+  if ((size_t)k > n) k = (int)n;/* (more slots are never used) */
+  fcm->slot.cnt = 1;            /* default: a single slot, */
+  if (k <= 1) return 0;         /* which needs no management */
+  z = (size_t)fcm->tile *(size_t)fcm->tile;
+  p = (REAL*)realloc(fcm->cache, (size_t)k *z *sizeof(REAL));
+  if (!p) return -1;            /* enlarge the tile cache */
+  fcm->cache = fcm->slots = p;  /* to hold k tiles */
+  m = (char*)malloc(slot_memsz(k));
+  if (!m) return -1;            /* allocate slot management */
+  fcm->slot.cnt  = k;           /* note the number of slots */
+  fcm->slot.hand = 0;           /* and the table size */
+  fcm->slot.bits = slot_bits(k);
+  fcm->slot.key  = (DIM*)m;     m += (size_t)k *2*sizeof(DIM);
+  fcm->slot.hash = (int*)m;     m += ((size_t)1 << fcm->slot.bits)
+                                   * sizeof(int);
+  fcm->slot.ref  = (uint8_t*)m; /* organize the memory block */
+  for (i = 0; i < 2*k; i++) fcm->slot.key[i] = -1;
+  for (i = 0; i < (1 << fcm->slot.bits); i++) fcm->slot.hash[i] = -1;
+  memset(fcm->slot.ref, 0, (size_t)k);
+  fcm->use.cache += (size_t)(k-1) *z *sizeof(REAL) +slot_memsz(k);
+  fcm->ra = fcm->rb = -1;       /* all slots are empty */
+  fcm->ca = fcm->cb = -1;       /* (no current tile) */
+  return 0;                     /* return 'ok' */
+}  /* fcm_slots() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_slot) (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                              SFXNAME(FCMFILLFN) *fillfn)
+{                               /* --- make a tile the current one */
+  FCMSLOT *S = &fcm->slot;      /* tile slot management */
+  int     m  = (1 << S->bits)-1;/* mask for hash table indices */
+  int     i, j, k, s;           /* hash table indices, slot */
+  DIM     ra, ca;               /* first row and column of the tile */
+
+  assert(fcm && fillfn && (S->cnt > 1)   /* check the arguments */
+  &&    (row >= 0) && (row <= col) && (col < fcm->V));
+  ra = row -(row % fcm->tile);  /* get the first row and column */
+  ca = col -(col % fcm->tile);  /* of the requested tile */
+  for (i = SLOT_HASH(fcm, ra, ca); (s = S->hash[i]) >= 0; i = (i+1) & m) {
+    if ((S->key[2*s] != ra) || (S->key[2*s+1] != ca))
+      continue;                 /* look up the tile */
+    S->ref[s]  = 1;             /* if the tile is cached, */
+    fcm->cache = fcm->slots +(size_t)s *(size_t)fcm->tile
+                                       *(size_t)fcm->tile;
+    fcm->ra = ra; fcm->rb = ra +fcm->tile;
+    if (fcm->rb > fcm->V) fcm->rb = fcm->V;
+    fcm->ca = ca; fcm->cb = ca +fcm->tile;
+    if (fcm->cb > fcm->V) fcm->cb = fcm->V;
+    return 0;                   /* make it the current tile */
+  }
+  while (S->ref[S->hand]) {     /* find a slot to replace: */
+    S->ref[S->hand] = 0;        /* clear the reference bits */
+    S->hand = (S->hand+1) % S->cnt;    /* of recently used slots */
+  }                             /* until an unused one is found */
+  s = S->hand; S->hand = (S->hand+1) % S->cnt;
+  if (S->key[2*s] >= 0) {       /* if the slot holds a tile */
+    for (i = SLOT_HASH(fcm, S->key[2*s], S->key[2*s+1]);
+         S->hash[i] != s; i = (i+1) & m);
+    for (j = i; 1; ) {          /* find and remove its hash entry */
+      j = (j+1) & m;            /* (backward shift deletion: */
+      if ((k = S->hash[j]) < 0) break;  /* move entries that */
+      k = SLOT_HASH(fcm, S->key[2*k], S->key[2*k+1]);
+      if ((j > i) ? ((k <= i) || (k > j)) : ((k <= i) && (k > j))) {
+        S->hash[i] = S->hash[j]; i = j; }
+    }                           /* would not be found anymore */
+    S->hash[i] = -1;            /* into the gap) */
+  }
+  S->key[2*s] = S->key[2*s+1] = -1;
+  fcm->cache = fcm->slots +(size_t)s *(size_t)fcm->tile
+                                     *(size_t)fcm->tile;
+  if (fillfn(fcm, row, col) != 0) {   /* fill the slot */
+    fcm->ra = fcm->rb = fcm->ca = fcm->cb = -1;
+    return -1;                  /* on failure leave the slot empty */
+  }                             /* and invalidate the current tile */
+  for (i = SLOT_HASH(fcm, ra, ca); S->hash[i] >= 0; i = (i+1) & m);
+  S->hash[i]    = s;            /* insert the tile into the table */
+  S->key[2*s]   = ra;
+  S->key[2*s+1] = ca;
+  S->ref[s]     = 1;
+  return 0;                     /* return 'ok' */
+}  /* fcm_slot() */
+
 /*----------------------------------------------------------------------------
   Retrieval Functions
 ----------------------------------------------------------------------------*/
@@ -509,24 +1341,69 @@ inline REAL SFXNAME(fcm_cache) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
   #ifdef SAFETHREAD             /* if to guarantee fill success */
   if (((row < fcm->ra) || (row >= fcm->rb)
   ||   (col < fcm->ca) || (col >= fcm->cb))
-  &&  (SFXNAME(fcm_fill)(fcm, row, col) != 0)) {
+  &&  (((fcm->slot.cnt > 1)
+  ?     SFXNAME(fcm_slot)(fcm, row, col, SFXNAME(fcm_fill))
+  :     SFXNAME(fcm_fill)(fcm, row, col)) != 0)) {
     DIM n = fcm->nthd;          /* if outside cache, fill cache; */
     fcm->nthd = 1;              /* on failure retry with one thread */
     fprintf(stderr, "safethread\n");
-    SFXNAME(fcm_fill)(fcm, row, col);
+    if (fcm->slot.cnt > 1)      /* (the slot is still free) */
+      SFXNAME(fcm_slot)(fcm, row, col, SFXNAME(fcm_fill));
+    else SFXNAME(fcm_fill)(fcm, row, col);
     fcm->nthd = n;              /* (a single thread cannot fail) */
   }                             /* and restore the number of threads */
   #else                         /* if to allow a thread failure */
   if (((row < fcm->ra) || (row >= fcm->rb)
   ||   (col < fcm->ca) || (col >= fcm->cb))
-  &&  (SFXNAME(fcm_fill)(fcm, row, col) != 0))
-    return -INFINITY;           /* if outside cache, fill cache */
+  &&  (((fcm->slot.cnt > 1)     /* if outside the current tile, */
+  ?     SFXNAME(fcm_slot)(fcm, row, col, SFXNAME(fcm_fill))
+  :     SFXNAME(fcm_fill)(fcm, row, col)) != 0))
+    return -INFINITY;           /* switch slots or fill the cache */
   #endif
   row -= fcm->ra;               /* compute row and column in cache */
   col -= fcm->ca;               /* and retrieve correlation coeff. */
   return fcm->cache[(size_t)row *(size_t)fcm->tile +(size_t)col];
 }  /* fcm_cache() */
 
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_pipe) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get cached corr. coeff. and */
+  REAL *t;                      /* fill the next tile meanwhile */
+  DIM  r, c;                    /* first row and column of a tile */
+
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  if (row > col) {              /* ensure col >= row (upper triangle) */
+    DIM x = row; row = col; col = x; }
+  if ((row < fcm->ra) || (row >= fcm->rb)
+  ||  (col < fcm->ca) || (col >= fcm->cb)) {
+    r = row -(row % fcm->tile); /* if outside the current tile */
+    c = col -(col % fcm->tile); /* and it is the one filled ahead, */
+    if ((fcm->dst == fcm->ahead) && (r == fcm->dr) && (c == fcm->dc)
+    &&  (SFXNAME(fcm_wait)(fcm) == 0)) {
+      t = fcm->cache; fcm->cache = fcm->ahead; fcm->ahead = t;
+      fcm->ra = r; fcm->rb = r +fcm->tile;   /* wait for it and */
+      if (fcm->rb > fcm->V) fcm->rb = fcm->V; /* swap the buffers */
+      fcm->ca = c; fcm->cb = c +fcm->tile;
+      if (fcm->cb > fcm->V) fcm->cb = fcm->V; }
+    else if (SFXNAME(fcm_fill)(fcm, row, col) != 0)
+      return -INFINITY;         /* otherwise fill the cache */
+    r = fcm->ra +fcm->tile;     /* get the next tile in the order */
+    c = fcm->ca;                /* of fcm_next() (column strips) */
+    if (r > c) { r = 0; c += fcm->tile; }
+    if (c < fcm->V) {           /* if there is another tile, */
+      fcm->dst = fcm->ahead;    /* start filling it ahead */
+      SFXNAME(fcm_post)(fcm, r, c);
+    }                           /* (a failure is noticed by */
+  }                             /* fcm_wait() and the tile refilled) */
+  row -= fcm->ra;               /* compute row and column in cache */
+  col -= fcm->ca;               /* and retrieve correlation coeff. */
+  return fcm->cache[(size_t)row *(size_t)fcm->tile +(size_t)col];
+}  /* fcm_pipe() */
+
 /*----------------------------------------------------------------------------
   Recursion Handling
 ----------------------------------------------------------------------------*/
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <stdarg.h>
 #include <time.h>
 #include <assert.h>
@@ -69,11 +70,44 @@
 #define SFXNAME_2(n,s)  n##s    /* the two step recursion is needed */
 #endif                          /* to ensure proper expansion */
 
+/*----------------------------------------------------------------------------
+  Function Prototypes (kernel selection functions defined in fcmat1.h)
+----------------------------------------------------------------------------*/
+extern int  SFXNAME(fcm_isa)      (void);
+extern int  SFXNAME(fcm_blksz)    (SFXNAME(FCMAT) *fcm);
+extern size_t SFXNAME(fcm_datasz) (SFXNAME(FCMAT) *fcm);
+extern int  SFXNAME(fcm_prep)     (SFXNAME(FCMAT) *fcm, REAL *data);
+extern void SFXNAME(fcm_xform)    (SFXNAME(FCMAT) *fcm, REAL *v, size_t n);
+extern REAL SFXNAME(fcm_xval)     (SFXNAME(FCMAT) *fcm, REAL r);
+extern int  SFXNAME(fcm_winprep)  (SFXNAME(FCMAT) *fcm, REAL *data);
+extern void SFXNAME(fcm_wincc)    (SFXNAME(FCMAT) *fcm, DIM row, DIM col,
+                                   DIM k, DIM n, double *sum, REAL *r);
+
 /*----------------------------------------------------------------------------
   Function Prototypes (half-stored functions defined in fcmat3.h)
 ----------------------------------------------------------------------------*/
 extern REAL SFXNAME(fcm_full)     (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
-extern REAL SFXNAME(fcm_full_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_xf)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_f16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#if defined FCM_ALL_ISA || defined __F16C__
+extern REAL SFXNAME(fcm_full_f16c)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+#endif
+extern REAL SFXNAME(fcm_full_bf16)(SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n8)  (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern REAL SFXNAME(fcm_full_n32) (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void SFXNAME(fcm_enc16)    (SFXNAME(FCMAT) *fcm, uint16_t *dst,
+                                   const REAL *src, size_t n);
+extern int  SFXNAME(fcm_save)     (SFXNAME(FCMAT) *fcm, const char *fname);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_open)     (const char *fname);
+extern void SFXNAME(fcm_unmap)    (SFXNAME(FCMAT) *fcm);
+extern REAL SFXNAME(fcm_onl)      (SFXNAME(FCMAT) *fcm, DIM row, DIM col);
+extern void*SFXNAME(fcm_onlrows)  (void *p);
+extern void SFXNAME(fcm_onlupd)   (SFXNAME(FCMAT) *fcm, double w);
+extern SFXNAME(FCMAT)*
+            SFXNAME(fcm_online)   (REAL *data, DIM V, DIM T, int mode, ...);
+extern int  SFXNAME(fcm_append)   (SFXNAME(FCMAT) *fcm, const REAL *vol);
 
 /*----------------------------------------------------------------------------
   Functions
@@ -83,7 +117,9 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 {                               /* --- create a func. connect. matrix */
   SFXNAME(FCMAT) *fcm;          /* func. con. matrix to be created */
   va_list args;                 /* list of variable arguments */
-  size_t  k, z;                 /* loop variable, cache size */
+  size_t  k, n, z;              /* loop variables, cache size */
+  uint16_t buf[4096];           /* buffer for 16 bit conversion */
+  size_t  y;                    /* number of elements (tiled) */
 
   assert(data && (V > 1) && (T > 1)); /* check the function arguments */
   fcm = (SFXNAME(FCMAT)*)malloc(sizeof(SFXNAME(FCMAT)));
@@ -96,60 +132,77 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   fcm->mem     = NULL;          /* clear memory block, */
   fcm->cmap    = NULL;          /* cosine map and cache */
   fcm->cache   = NULL;          /* for easier cleanup */
-  fcm->diag    = (REAL)((mode & FCM_R2Z) ? R2Z_MAX : 1.0);
+  fcm->slots   = NULL;          /* (a single tile slot) */
+  fcm->slot.cnt = 1;
+  fcm->slot.key = NULL;
+  fcm->dst     = fcm->ahead = NULL;
+  fcm->pend    = 0;
+  fcm->half    = NULL;
+  fcm->cnts    = NULL;          /* (not used by this variant) */
+  fcm->avg     = NULL;          /* (no online moments, */
+  fcm->mom     = NULL;          /* see fcm_online()) */
+  fcm->map     = NULL;          /* (not opened from a file) */
+  fcm->toff    = NULL;          /* (default: row-major triangle) */
+  fcm->diag    = 1;             /* (transformed below) */
+  fcm->clamp   = 1;             /* default: no clamping and */
+  fcm->thresh  = 0;             /* binarization at zero */
+  fcm->win     = fcm->step = 0; /* (no sliding windows */
+  fcm->nwin    = 0;             /* in this variant) */
   fcm->value   = fcm->diag;     /* set the value and coordinates */
   fcm->row     = fcm->col = 0;  /* of the current element */
   fcm->ra      = 0; fcm->rb = V;
   fcm->ca      = 0; fcm->cb = V;/* init. the coordinate ranges */
   fcm->err     = 0;             /* clear the error status */
+  fcm->maxmem  = -1;            /* no memory limit */
+  memset(&fcm->use, 0, sizeof(FCMMEM));
+  fcm->use.base = sizeof(SFXNAME(FCMAT));
+  memset(&fcm->stats, 0, sizeof(FCMSTATS));
+  fcm->tst     = NULL;          /* clear the runtime statistics */
+  fcm->post[0] = fcm->post[1] = 0;
 
   va_start(args, mode);         /* start variable arguments */
   if (mode & FCM_THREAD)        /* if to use a threaded version */
     fcm->nthd = va_arg(args, int); /* get the number of threads */
+  if (mode & FCM_CACHE)         /* skip the arguments that are */
+    va_arg(args, DIM);          /* not used by this variant */
+  if (mode & FCM_MAXMEM)        /* (the whole triangle is stored) */
+    va_arg(args, double);
+  if (mode & FCM_DISK)
+    va_arg(args, const char*);
+  if (mode & FCM_SLOTS)
+    va_arg(args, int);
+  if (mode & FCM_CLAMP)         /* get the bound for clamping */
+    fcm->clamp  = (REAL)va_arg(args, double);
+  if (mode & FCM_BIN)           /* get the threshold */
+    fcm->thresh = (REAL)va_arg(args, double);
   va_end(args);                 /* end variable arguments */
   if (fcm->nthd < 1) fcm->nthd = 1;
 
   mode &= FCM_CORR;             /* get the correlation type */
-  if      (mode == FCM_PCC) {   /* if Pearson's correlation coeff. */
-    #ifdef __AVX__              /* use AVX if possible */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+7) & ~7); /* process blocks with 8 numbers */
-    #endif
-    #else                       /* otherwise fall back to SSE2 */
-    #if REAL_IS_DOUBLE          /* if to use double precision values */
-    fcm->X = (((int)T+1) & ~1); /* process blocks with 2 numbers */
-    #else                       /* if to use single precision values */
-    fcm->X = (((int)T+3) & ~3); /* process blocks with 4 numbers */
-    #endif                      /* get the data block size */
-    #endif                      /* allocate memory for norm.ed data */
-    fcm->mem = malloc((size_t)V*(size_t)fcm->X *sizeof(REAL) +31);
-    if (!fcm->mem) { SFXNAME(fcm_delete)(fcm); return NULL; }
-    fcm->data = (REAL*)(((uintptr_t)fcm->mem +31) & ~(uintptr_t)31);
-    INIT_PCC(data, (int)V, (int)T, fcm->data, (int)fcm->X);
-  }
-  else if (mode == FCM_TCC) {   /* if tetrachoric correlation coeff. */
-    #if defined __POPCNT__ \
-    &&  defined __SSE4_1__      /* use 128 bit and popcnt if possible */
-    fcm->X = 4 *(((int)T+127) >> 7);
-    #else                       /* otherwise fall back to LUT16 */
-    fcm->X = ((int)T+31) >> 5;  /* get block size of binarized data */
-    #endif
-    fcm->mem  =                 /* allocate memory for binarized data */
-    fcm->data = SFXNAME(binarize)(data, (int)V, (int)T, BIN_MEDIAN, BPI);
-    if (!fcm->data) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    fcm->cmap = SFXNAME(make_cmap)((int)T); /* create cosine map */
-    if (!fcm->cmap) { SFXNAME(fcm_delete)(fcm); return NULL; };
-    init_popcnt(); }            /* initialize bit count table */
-  else {                        /* if unknown correlation variant */
+  if ((mode != FCM_PCC) && (mode != FCM_TCC)) {
     fprintf(stderr, "fcm_create: unknown correlation variant\n");
     free(fcm); return NULL;     /* print an error message */
   }                             /* and abort the function */
-
-  z = (size_t)V *(size_t)(V-1)/2; /* cache for upper triangle */
-  fcm->cache = (REAL*)malloc(z *sizeof(REAL));
+  if (fcm->mode & FCM_WINDOW) { /* pccx() computes whole series only */
+    fprintf(stderr, "fcm_create: sliding windows are not supported "
+                    "by this variant\n");
+    free(fcm); return NULL;     /* print an error message */
+  }                             /* and abort the function */
+  SFXNAME(fcm_blksz)(fcm);      /* (data are prepared by pccx() and */
+                                /* tetraccx() and released again) */
+  fcm->diag  = SFXNAME(fcm_xval)(fcm, (REAL)1);
+  fcm->value = fcm->diag;       /* transform the diagonal value */
+  z = y = (size_t)V *(size_t)(V-1)/2; /* cache for upper triangle */
+  if (fcm->mode & FCM_TILED) {  /* if to store it as tiles, */
+    fcm->toff = tri_toff(V);    /* create the tile offset table */
+    if (!fcm->toff) { SFXNAME(fcm_delete)(fcm); return NULL; }
+    y = tri_size(V);            /* (the tiles need at least as many */
+  }                             /* elements as the row-major triangle) */
+  fcm->cache = (REAL*)malloc(y *sizeof(REAL));
   if (!fcm->cache) { SFXNAME(fcm_delete)(fcm); return NULL; }
+  fcm->use.cache = y *sizeof(REAL);
+  fcm->use.peak  = fcm->use.base +fcm->use.cache
+                 + SFXNAME(fcm_datasz)(fcm);
   if (mode == FCM_PCC)          /* if Pearson correlation coefficient */
     SFXNAME(pccx)    (data, fcm->cache, (int)V, (int)T,
                   // PCC_AVX|PCC_COBL|PCC_THREAD, 0, fcm->nthd);
@@ -157,14 +210,45 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
   else                          /* if tetrachoric correlation coeff. */
     SFXNAME(tetraccx)(data, fcm->cache, (int)V, (int)T,
                       TCC_AUTO|TCC_THREAD, fcm->nthd);
+  fcm->stats.comp = z;          /* note the computed elements */
 
   fcm->cget = SFXNAME(fcm_full);/* retrieval function for fcm_next() */
   fcm->get = SFXNAME(fcm_full); /* retrieval function for fcm_get() */
 
-  if (fcm->mode & FCM_R2Z)      /* if Fisher's r-to-z transform, */
-    for (k = 0; k < z; k++)     /* transform the matrix elements */
-      fcm->cache[k] = SFXNAME(fisher_r2z)(fcm->cache[k]);
+  if (fcm->mode & FCM_XFORM)    /* if to transform the elements, */
+    SFXNAME(fcm_xform)(fcm, fcm->cache, z);   /* do it in place */
                                 /* set the element retrieval function */
+  if (fcm->mode & FCM_HALF) {   /* if to store with 16 bits per elem. */
+    for (k = 0; k < z; k += n) {/* convert the triangle in place */
+      n = (z-k < 4096) ? z-k : 4096;
+      SFXNAME(fcm_enc16)(fcm, buf, fcm->cache +k, n);
+      memcpy((uint16_t*)fcm->cache +k, buf, n *sizeof(uint16_t));
+    }                           /* (target lies before the source) */
+  }
+  if (fcm->toff) {              /* if to store the triangle as tiles, */
+    k = (fcm->mode & FCM_HALF) ? sizeof(uint16_t) : sizeof(REAL);
+    if (tri_tile(fcm->cache, V, k, fcm->toff) != 0) {
+      SFXNAME(fcm_delete)(fcm); return NULL; }
+    z = y;                      /* rearrange it in place */
+    fcm->use.cache += ((size_t)V +TRI_MASK) /TRI_BLK *sizeof(size_t);
+  }                             /* (see fcmat3.h) */
+  if (fcm->mode & FCM_HALF) {   /* if stored with 16 bits per elem. */
+    fcm->half  = (uint16_t*)realloc(fcm->cache, z *sizeof(uint16_t));
+    if (!fcm->half) fcm->half = (uint16_t*)fcm->cache;
+    fcm->cache = NULL;          /* shrink the memory block */
+    fcm->use.cache = z *sizeof(uint16_t)
+                   + ((fcm->toff) ? ((size_t)V +TRI_MASK) /TRI_BLK
+                                    *sizeof(size_t) : 0);
+    if      (fcm->mode & FCM_BF16)
+      fcm->get = SFXNAME(fcm_full_bf16);
+    #if defined FCM_ALL_ISA || defined __F16C__
+    else if (fcm->isa & FCM_ISA_F16C)
+      fcm->get = SFXNAME(fcm_full_f16c);
+    #endif
+    else fcm->get = SFXNAME(fcm_full_f16);
+    fcm->cget = fcm->get;       /* set the element retrieval function */
+  }                             /* (peak memory is not reduced here, */
+                                /* see fcmat.c for a tile-wise fill) */
 
   return fcm;                   /* return created FC matrix */
 }  /* fcm_create() */
@@ -174,7 +258,10 @@ SFXNAME(FCMAT)* SFXNAME(fcm_create) (REAL *data, DIM V, DIM T, int mode, ...)
 void SFXNAME(fcm_delete) (SFXNAME(FCMAT) *fcm)
 {                               /* --- delete a func. connect. matrix */
   assert(fcm);                  /* check the function argument */
+  if (fcm->map)    SFXNAME(fcm_unmap)(fcm);
   if (fcm->cache)  free(fcm->cache);
+  if (fcm->half)   free(fcm->half);
+  if (fcm->toff)   free(fcm->toff);
   if (fcm->cmap)   free(fcm->cmap);
   if (fcm->mem)    free(fcm->mem);/* delete cache, cosine map, */
   free(fcm);                    /* data, and the base structure */
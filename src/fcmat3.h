@@ -5,6 +5,17 @@
 ----------------------------------------------------------------------------*/
 #ifndef FCMAT3_H
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#ifndef _WIN32                  /* if Linux/Unix system */
+#include <fcntl.h>              /* (needed for memory-mapping */
+#include <unistd.h>             /* matrix files in fcm_open()) */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "fcmat1.h"
 
 /*----------------------------------------------------------------------------
@@ -34,12 +45,335 @@
 #define SFXNAME_2(n,s)  n##s    /* the two step recursion is needed */
 #endif                          /* to ensure proper expansion */
 
+/*--------------------------------------------------------------------------*/
+#define float  1                /* to check the definition of REAL */
+#define double 2
+
+#if   REAL == float             /* if single precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  0       /* clear indicator for double */
+#elif REAL == double            /* if double precision data */
+#undef  REAL_IS_DOUBLE
+#define REAL_IS_DOUBLE  1       /* set   indicator for double */
+#else
+#error "REAL must be either 'float' or 'double'"
+#endif
+
+#undef float                    /* delete definitions */
+#undef double                   /* used for type checking */
+
 /*----------------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------------*/
 #define INDEX(i,j,N)    ((size_t)(i)*((size_t)(N)+(size_t)(N) \
                          -(size_t)(i)-3)/2-1+(size_t)(j))
 
+#ifndef TRI_BITS                /* --- tiled layout (FCM_TILED) */
+#define TRI_BITS    6           /* tiles of 64x64 elements */
+#define TRI_BLK     (1 << TRI_BITS)
+#define TRI_MASK    (TRI_BLK-1)
+#define TRI_SQR     ((size_t)TRI_BLK*TRI_BLK)       /* square tile */
+#define TRI_LOW     ((size_t)TRI_BLK*(TRI_BLK-1)/2) /* diagonal tile */
+#define TRI_DIAG    (TRI_SQR-TRI_LOW)
+#endif
+
+#define TINDEX(t,i,j)   ((t)[(i) >> TRI_BITS] \
+                        +((size_t)((j) >> TRI_BITS) << (2*TRI_BITS)) \
+                        +((((i) >> TRI_BITS) == ((j) >> TRI_BITS)) \
+                        ? TRI_DIAG +INDEX((i) & TRI_MASK, (j) & TRI_MASK, \
+                                          TRI_BLK) \
+                        : ((size_t)((i) & TRI_MASK) << TRI_BITS) \
+                          +(size_t)((j) & TRI_MASK)))
+#define TRIIDX(f,i,j)   (((f)->toff) ? TINDEX((f)->toff, i, j) \
+                                     : INDEX(i, j, (f)->V))
+
+#ifndef ONL_MIN                 /* --- online matrix (fcm_online()) */
+#define ONL_MIN     65536       /* min. co-moments per update thread */
+#endif
+
+/*----------------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------------*/
+#ifndef FCM_FILE_DEFINED        /* --- matrix file (fcm_save()) */
+#define FCM_FILE_DEFINED
+#define FCM_MAGIC   "FCMAT01\n" /* identification of a matrix file */
+#define FCM_PAGE    4096        /* offset of the triangle in the file */
+
+#define FCMF_REAL   0           /* elements are REALs */
+#define FCMF_F16    1           /* elements are IEEE fp16 numbers */
+#define FCMF_BF16   2           /* elements are bfloat16 numbers */
+#define FCMF_N8     3           /* elements are 8  bit n_11 counts */
+#define FCMF_N16    4           /* elements are 16 bit n_11 counts */
+#define FCMF_N32    5           /* elements are 32 bit n_11 counts */
+
+typedef struct {                /* --- header of a matrix file */
+  char     magic[8];            /* file identification (FCM_MAGIC) */
+  int32_t  real;                /* size of REAL (4 or 8 bytes) */
+  int32_t  fmt;                 /* element format (FCMF_*) */
+  int32_t  mode;                /* correlation type, transform, 16 bit */
+  int32_t  zval;                /* whether transform is already applied */
+  int64_t  V, T;                /* numbers of voxels and scans */
+  uint64_t tri, trisz;          /* offset and size of the triangle */
+  uint64_t cmap;                /* offset of the cosine map (or 0) */
+  uint64_t size;                /* total size of the file */
+  double   clamp, thresh;       /* parameters of the transform */
+} FCMHDR;                       /* (byte order of the host) */
+#endif
+
+typedef struct {                /* --- online update task */
+  SFXNAME(FCMAT) *fcm;          /* online matrix to update */
+  DIM    ra, rb;                /* row range of the co-moments */
+  double w;                     /* weight of the rank-1 update */
+} SFXNAME(ONLTASK);             /* (see fcm_onlupd()) */
+
+/*----------------------------------------------------------------------------
+  Tiled Layout Functions
+----------------------------------------------------------------------------*/
+/* With FCM_TILED the upper triangle is stored as tiles of TRI_BLK    */
+/* rows and columns instead of row by row: the tiles of a tile row    */
+/* follow each other, starting with the triangle on the diagonal, and */
+/* each tile is stored row by row (the last tile row and column are   */
+/* padded to full tiles). Fixed rows and fixed columns then both stay */
+/* within a few pages per tile. toff[b] holds the offset of tile row  */
+/* b minus the offset of its tile column b, so that TINDEX() finds    */
+/* an element with one table lookup (modular arithmetic of size_t).   */
+
+#ifndef TILED_DEFINED           /* (independent of the type of REAL) */
+#define TILED_DEFINED
+
+static inline size_t tri_size (DIM V)
+{                               /* --- number of elements of a tiled */
+  size_t n = ((size_t)V +TRI_MASK) >> TRI_BITS;    /* triangle */
+  return n *TRI_LOW +n *(n-1)/2 *TRI_SQR;
+}  /* tri_size() */             /* (including the padding) */
+
+/*--------------------------------------------------------------------------*/
+
+static inline size_t* tri_toff (DIM V)
+{                               /* --- create tile offset table */
+  size_t n, b, k;               /* number of tile rows, loop var. */
+  size_t *toff;                 /* tile offset table */
+
+  n    = ((size_t)V +TRI_MASK) >> TRI_BITS;
+  toff = (size_t*)malloc(n *sizeof(size_t));
+  if (!toff) return NULL;       /* allocate the offset table */
+  for (k = b = 0; b < n; b++) { /* traverse the tile rows */
+    toff[b] = k +TRI_LOW -(b+1) *TRI_SQR;
+    k += TRI_LOW +(n-1-b) *TRI_SQR;
+  }                             /* (offset of tile (b,b+1) minus */
+  return toff;                  /* the offset of tile column b+1) */
+}  /* tri_toff() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline int tri_tile (void *tri, DIM V, size_t e, const size_t *toff)
+{                               /* --- tile a row-major triangle */
+  char   *p = (char*)tri;       /* triangle (bytes) */
+  char   *buf;                  /* buffer for the rows of a tile row */
+  size_t n, b, s, k, x;         /* number of tile rows, offsets */
+  DIM    i, j, m, a, z;         /* loop variables, row range */
+
+  n   = ((size_t)V +TRI_MASK) >> TRI_BITS;
+  buf = (char*)malloc((size_t)TRI_BLK *(size_t)V *e);
+  if (!buf) return -1;          /* allocate a row buffer */
+  for (b = n; b-- > 0; ) {      /* traverse the tile rows backwards */
+    a = (DIM)(b << TRI_BITS);   /* get the row range */
+    z = (a +TRI_BLK < V) ? a +TRI_BLK : V;
+    s = (size_t)(V-a) *(size_t)(V-a-1)/2;   /* elements from row a */
+    k = (size_t)(V-z) *(size_t)(V-z-1)/2;   /* elements from row z */
+    x = (size_t)V *(size_t)(V-1)/2 -s;      /* offset of row a */
+    memcpy(buf, p +x*e, (s-k) *e);  /* copy the rows of the tile row */
+    x = toff[b] +(b+1) *TRI_SQR -TRI_LOW;   /* clear the tile row */
+    memset(p +x*e, 0, (TRI_LOW +(n-1-b) *TRI_SQR) *e);
+    for (k = 0, i = a; i < z; i++) {
+      for (j = i+1; j < V; j = m) {
+        m = (j | TRI_MASK) +1; if (m > V) m = V;
+        memcpy(p +TINDEX(toff, i, j) *e, buf +k*e, (size_t)(m-j) *e);
+        k += (size_t)(m-j);     /* scatter the row segments */
+      }                         /* into the tiles */
+    }                           /* (the tiles of a tile row start at */
+  }                             /* or after the rows they hold, so */
+  free(buf);                    /* earlier rows are not overwritten) */
+  return 0;                     /* return 'ok' */
+}  /* tri_tile() */             /* (tri must hold tri_size(V) elems.) */
+
+#endif
+/*----------------------------------------------------------------------------
+  16 Bit Conversion Functions
+----------------------------------------------------------------------------*/
+#ifndef HALF_DEFINED            /* (independent of the type of REAL) */
+#define HALF_DEFINED
+
+static inline uint16_t f16_enc (float x)
+{                               /* --- encode a float as IEEE fp16 */
+  uint32_t u, s, m, r;          /* bit pattern, sign, mantissa */
+  int      k;                   /* shift for subnormal numbers */
+
+  memcpy(&u, &x, sizeof(u));    /* get the bit pattern of the float */
+  s = (u >> 16) & 0x8000;       /* and separate the sign bit */
+  u &= 0x7fffffff;
+  if (u >= 0x47800000)          /* overflow, infinity or NaN */
+    return (uint16_t)(s | ((u > 0x7f800000) ? 0x7e00 : 0x7c00));
+  if (u >= 0x38800000)          /* normal fp16 number: rebias the */
+    return (uint16_t)(s | ((u -0x38000000 +0xfff +((u >> 13) & 1)) >> 13));
+                                /* exponent and round to nearest even */
+                                /* (may round up to infinity) */
+  if (u <  0x33000000)          /* underflow: signed zero */
+    return (uint16_t)s;
+  k = 126 -(int)(u >> 23);      /* subnormal fp16 number: */
+  m = (u & 0x7fffff) | 0x800000;/* shift the mantissa (with the */
+  u = m >> k;                   /* implicit bit) into position */
+  r = (uint32_t)1 << (k-1);     /* and round to nearest even */
+  m &= r+r-1;                   /* (r: half of the last place) */
+  if ((m > r) || ((m == r) && (u & 1))) u += 1;
+  return (uint16_t)(s | u);     /* return the encoded number */
+}  /* f16_enc() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline float f16_dec (uint16_t h)
+{                               /* --- decode an IEEE fp16 number */
+  uint32_t u, e, m;             /* bit pattern, exponent, mantissa */
+  float    x;                   /* decoded number */
+
+  e = ((uint32_t)h >> 10) & 0x1f;
+  m =  (uint32_t)h & 0x3ff;     /* get exponent and mantissa */
+  if (e == 0) {                 /* zero or subnormal number */
+    x = (float)m *(1.0f/16777216.0f);
+    return (h & 0x8000) ? -x : x; }
+  u = ((uint32_t)(h & 0x8000) << 16) | (m << 13)
+    | ((e == 31) ? 0x7f800000 : ((e +112) << 23));
+  memcpy(&x, &u, sizeof(x));    /* rebias the exponent and */
+  return x;                     /* return the decoded number */
+}  /* f16_dec() */
+
+/*--------------------------------------------------------------------------*/
+
+static inline uint16_t bf16_enc (float x)
+{                               /* --- encode a float as bfloat16 */
+  uint32_t u;                   /* bit pattern of the float */
+
+  memcpy(&u, &x, sizeof(u));    /* get the bit pattern of the float */
+  if ((u & 0x7fffffff) > 0x7f800000)
+    return (uint16_t)((u >> 16) | 0x40);  /* keep NaNs quiet */
+  if ((u & 0x7f800000) == 0)    /* flush subnormals to zero */
+    return (uint16_t)((u >> 16) & 0x8000);  /* (like AVX-512 BF16) */
+  return (uint16_t)((u +0x7fff +((u >> 16) & 1)) >> 16);
+}  /* bf16_enc() */             /* (round to nearest even) */
+
+/*--------------------------------------------------------------------------*/
+
+static inline float bf16_dec (uint16_t h)
+{                               /* --- decode a bfloat16 number */
+  uint32_t u = (uint32_t)h << 16;
+  float    x;                   /* bfloat16 is the upper half */
+  memcpy(&x, &u, sizeof(x));    /* of a float */
+  return x;                     /* return the decoded number */
+}  /* bf16_dec() */
+
+#endif
+/*--------------------------------------------------------------------------*/
+/* The encoders convert a row of the cache (a rectangle computed with  */
+/* the blocked kernels) into the 16 bit half-stored triangle. Doubles  */
+/* are rounded to float first (same result as the scalar encoders).   */
+
+#if defined FCM_ALL_ISA || defined __F16C__
+
+FCM_TARGET("avx,f16c")
+static inline size_t SFXNAME(enc_f16c) (uint16_t *dst, const REAL *src,
+                                        size_t n)
+{                               /* --- encode fp16 with F16C */
+  size_t i;                     /* loop variable */
+  #if REAL_IS_DOUBLE            /* if double precision data */
+  for (i = 0; i+4 <= n; i += 4)
+    _mm_storel_epi64((__m128i*)(dst+i), _mm_cvtps_ph(
+      _mm256_cvtpd_ps(_mm256_loadu_pd(src+i)), _MM_FROUND_TO_NEAREST_INT));
+  #else                         /* if single precision data */
+  for (i = 0; i+8 <= n; i += 8)
+    _mm_storeu_si128((__m128i*)(dst+i), _mm256_cvtps_ph(
+      _mm256_loadu_ps(src+i), _MM_FROUND_TO_NEAREST_INT));
+  #endif
+  return i;                     /* return the number of encoded */
+}  /* enc_f16c() */             /* numbers (rest: scalar) */
+
+#endif
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __AVX512F__
+
+FCM_TARGET("avx512f")
+static inline size_t SFXNAME(enc_avx512) (uint16_t *dst, const REAL *src,
+                                          size_t n)
+{                               /* --- encode fp16 with AVX-512 */
+  size_t i;                     /* loop variable */
+  __m512 v;                     /* 16 floats to convert */
+  for (i = 0; i+16 <= n; i += 16) {
+    #if REAL_IS_DOUBLE          /* if double precision data */
+    v = _mm512_castpd_ps(_mm512_insertf64x4(
+          _mm512_castps_pd(_mm512_castps256_ps512(
+            _mm512_cvtpd_ps(_mm512_loadu_pd(src+i)))),
+          _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(src+i+8))), 1));
+    #else                       /* if single precision data */
+    v = _mm512_loadu_ps(src+i); /* load 16 floats, round them */
+    #endif                      /* to nearest even and store */
+    _mm256_storeu_si256((__m256i*)(dst+i),
+                        _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }                             /* the fp16 numbers */
+  return i;                     /* return the number of encoded */
+}  /* enc_avx512() */           /* numbers (rest: scalar) */
+
+#endif
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || (defined __AVX512F__ && defined __AVX512BF16__)
+
+FCM_TARGET("avx512f,avx512bf16")
+static inline size_t SFXNAME(enc_avx512bf16) (uint16_t *dst,
+                                              const REAL *src, size_t n)
+{                               /* --- encode bf16 with AVX-512 BF16 */
+  size_t i;                     /* loop variable */
+  __m512 v;                     /* 16 floats to convert */
+  for (i = 0; i+16 <= n; i += 16) {
+    #if REAL_IS_DOUBLE          /* if double precision data */
+    v = _mm512_castpd_ps(_mm512_insertf64x4(
+          _mm512_castps_pd(_mm512_castps256_ps512(
+            _mm512_cvtpd_ps(_mm512_loadu_pd(src+i)))),
+          _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(src+i+8))), 1));
+    #else                       /* if single precision data */
+    v = _mm512_loadu_ps(src+i); /* load 16 floats, round them */
+    #endif                      /* to nearest even and store */
+    _mm256_storeu_si256((__m256i*)(dst+i), (__m256i)_mm512_cvtneps_pbh(v));
+  }                             /* the upper halves */
+  return i;                     /* return the number of encoded */
+}  /* enc_avx512bf16() */       /* numbers (rest: scalar) */
+
+#endif
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_enc16) (SFXNAME(FCMAT) *fcm, uint16_t *dst,
+                                const REAL *src, size_t n)
+{                               /* --- encode numbers with 16 bits */
+  size_t i = 0;                 /* loop variable */
+
+  assert(fcm && dst && src);    /* check the function arguments */
+  if (fcm->mode & FCM_BF16) {   /* if bfloat16 */
+    #if defined FCM_ALL_ISA || (defined __AVX512F__ && defined __AVX512BF16__)
+    if (fcm->isa & FCM_ISA_AVX512BF16)
+      i = SFXNAME(enc_avx512bf16)(dst, src, n);
+    #endif
+    for ( ; i < n; i++) dst[i] = bf16_enc((float)src[i]);
+    return;                     /* encode the (remaining) numbers */
+  }                             /* with the scalar encoder */
+  #if defined FCM_ALL_ISA || defined __AVX512F__
+  if      (fcm->isa & FCM_ISA_AVX512)
+    i = SFXNAME(enc_avx512)(dst, src, n);
+  #endif                        /* if IEEE fp16, prefer AVX-512 */
+  #if defined FCM_ALL_ISA || defined __F16C__
+  if      ((i == 0) && (fcm->isa & FCM_ISA_F16C))
+    i = SFXNAME(enc_f16c)(dst, src, n);
+  #endif                        /* otherwise use F16C */
+  for ( ; i < n; i++)           /* encode the remaining numbers */
+    dst[i] = f16_enc((float)src[i]);
+}  /* fcm_enc16() */
+
 /*----------------------------------------------------------------------------
   Inline Retrieval Functions
 ----------------------------------------------------------------------------*/
@@ -51,21 +385,531 @@ inline REAL SFXNAME(fcm_full) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
   if (row == col)               /* if diagonal element, */
     return fcm->diag;           /* return a fixed value */
   return fcm->cache[(row > col) /* retrieve the correlation coeff. */
-                    ? INDEX(col, row, fcm->V)
-                    : INDEX(row, col, fcm->V)];
+                    ? TRIIDX(fcm, col, row)
+                    : TRIIDX(fcm, row, col)];
 }  /* fcm_full() */
 
-inline REAL SFXNAME(fcm_full_r2z) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+inline REAL SFXNAME(fcm_full_xf) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
 {                               /* --- get corr.c. from full rep. */
+  REAL r;                       /* correlation coefficient */
+
   assert(fcm                    /* check the function arguments */
   &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
   if (row == col)               /* if diagonal element, */
-    return (REAL)+R2Z_MAX;      /* return a fixed value */
-  REAL r = fcm->cache[(row > col) /* retrieve the correlation coeff. */
-                    ? INDEX(col, row, fcm->V)
-                    : INDEX(row, col, fcm->V)];
-  return fisher_r2z(r);
-}  /* fcm_full_r2z() */
+    return fcm->diag;           /* return a fixed value */
+  r = fcm->cache[(row > col)    /* retrieve the correlation coeff. */
+                ? TRIIDX(fcm, col, row)
+                : TRIIDX(fcm, row, col)];
+  return SFXNAME(fcm_xval)(fcm, r);
+}  /* fcm_full_xf() */          /* apply the transform stage */
+
+/*--------------------------------------------------------------------------*/
+/* The 16 bit triangle already holds transformed values (the cache     */
+/* kernels apply the transform stage when filling the triangle), so   */
+/* there is no separate transforming version of these functions.      */
+
+inline REAL SFXNAME(fcm_full_f16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from fp16 rep. */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return (REAL)f16_dec(fcm->half[(row > col)
+                                 ? TRIIDX(fcm, col, row)
+                                 : TRIIDX(fcm, row, col)]);
+}  /* fcm_full_f16() */
+
+/*--------------------------------------------------------------------------*/
+#if defined FCM_ALL_ISA || defined __F16C__
+
+FCM_TARGET("avx,f16c")
+inline REAL SFXNAME(fcm_full_f16c) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from fp16 rep. */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return (REAL)_cvtsh_ss(fcm->half[(row > col)
+                                   ? TRIIDX(fcm, col, row)
+                                   : TRIIDX(fcm, row, col)]);
+}  /* fcm_full_f16c() */        /* (F16C conversion instruction) */
+
+#endif
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_full_bf16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from bf16 rep. */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return (REAL)bf16_dec(fcm->half[(row > col)
+                                  ? TRIIDX(fcm, col, row)
+                                  : TRIIDX(fcm, row, col)]);
+}  /* fcm_full_bf16() */
+
+/*--------------------------------------------------------------------------*/
+/* A half-stored tetrachoric matrix keeps the numbers of 11 configs.  */
+/* (8 bit if T < 256, 16 bit if T < 65536, 32 bit otherwise), which  */
+/* are mapped with cmap                                               */
+/* (Fisher's r-to-z transform is folded into cmap if requested).      */
+
+inline REAL SFXNAME(fcm_full_n8) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from 8 bit counts */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return fcm->cmap[((uint8_t*)fcm->cnts)[(row > col)
+                                         ? TRIIDX(fcm, col, row)
+                                         : TRIIDX(fcm, row, col)]];
+}  /* fcm_full_n8() */
+
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_full_n16) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from 16 bit counts */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return fcm->cmap[((uint16_t*)fcm->cnts)[(row > col)
+                                          ? TRIIDX(fcm, col, row)
+                                          : TRIIDX(fcm, row, col)]];
+}  /* fcm_full_n16() */
+
+/*--------------------------------------------------------------------------*/
+
+inline REAL SFXNAME(fcm_full_n32) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from 32 bit counts */
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  return fcm->cmap[((uint32_t*)fcm->cnts)[(row > col)
+                                          ? TRIIDX(fcm, col, row)
+                                          : TRIIDX(fcm, row, col)]];
+}  /* fcm_full_n32() */
+
+/*----------------------------------------------------------------------------
+  File Functions
+----------------------------------------------------------------------------*/
+/* A half-stored matrix is written as a header (padded to FCM_PAGE),  */
+/* the upper triangle in its storage format and, for n_11 counts, the */
+/* cosine map. fcm_open() maps the file read-only, so the retrieval   */
+/* functions read from the page cache, which concurrent processes     */
+/* that open the same file share.                                    */
+
+inline int SFXNAME(fcm_save) (SFXNAME(FCMAT) *fcm, const char *fname)
+{                               /* --- save a half-stored matrix */
+  FCMHDR hdr;                   /* header of the matrix file */
+  FILE   *fp;                   /* file to write to */
+  void   *tri;                  /* upper triangle to write */
+  size_t z, e;                  /* number and size of elements */
+  char   pad[256];              /* zero bytes for padding */
+  int    err = 0;               /* error flag */
+
+  assert(fcm && fname);         /* check the function arguments */
+  memset(&hdr, 0, sizeof(hdr)); /* clear the header */
+  z = (fcm->toff) ? tri_size(fcm->V) : (size_t)fcm->V *(size_t)(fcm->V-1)/2;
+  if      (fcm->cnts) {         /* if numbers of 11 configurations */
+    hdr.fmt = (fcm->T <   256) ? FCMF_N8
+            : (fcm->T < 65536) ? FCMF_N16 : FCMF_N32;
+    e   = (fcm->T <   256) ? sizeof(uint8_t)
+        : (fcm->T < 65536) ? sizeof(uint16_t) : sizeof(uint32_t);
+    tri = fcm->cnts; }
+  else if (fcm->half) {         /* if 16 bit floating point numbers */
+    hdr.fmt = (fcm->mode & FCM_BF16) ? FCMF_BF16 : FCMF_F16;
+    e   = sizeof(uint16_t);
+    tri = fcm->half; }
+  else if (fcm->cache           /* if a triangle of REALs */
+  &&      ((fcm->get == SFXNAME(fcm_full))
+  ||       (fcm->get == SFXNAME(fcm_full_xf)))) {
+    hdr.fmt = FCMF_REAL;
+    e   = sizeof(REAL);
+    tri = fcm->cache; }
+  else {                        /* if cache-based or on-demand */
+    fprintf(stderr, "fcm_save: matrix is not half-stored\n");
+    return -1;                  /* print an error message */
+  }                             /* and abort the function */
+  memcpy(hdr.magic, FCM_MAGIC, sizeof(hdr.magic));
+  hdr.real  = (int32_t)sizeof(REAL);
+  hdr.mode  = (int32_t)(fcm->mode & (FCM_CORR|FCM_XFORM|FCM_HALF|FCM_TILED
+                                    |FCM_WINDOW|FCM_WVAR));
+  hdr.zval  = ((fcm->mode & FCM_XFORM) && (fcm->get != SFXNAME(fcm_full_xf)));
+  hdr.clamp = (double)fcm->clamp;
+  hdr.thresh = (double)fcm->thresh;
+  hdr.V     = (int64_t)fcm->V;  /* (counts: transform folded into */
+  hdr.T     = (int64_t)fcm->T;  /* cmap, 16 bit: applied when filling, */
+  hdr.tri   = FCM_PAGE;         /* fcmat3.c: applied in place) */
+  hdr.trisz = (uint64_t)(z*e);
+  hdr.size  = hdr.tri +hdr.trisz;
+  if (fcm->cnts) {              /* if there is a cosine map, */
+    hdr.cmap = (hdr.size +7) & ~(uint64_t)7;  /* store it after */
+    hdr.size = hdr.cmap +(uint64_t)(fcm->T+1) *sizeof(REAL);
+  }                             /* the (aligned) triangle */
+  fp = fopen(fname, "wb");      /* open the matrix file */
+  if (!fp) return -1;
+  memset(pad, 0, sizeof(pad));  /* write the header and pad it */
+  err |= (fwrite(&hdr, sizeof(hdr), 1, fp) != 1);
+  for (e = sizeof(hdr); e < hdr.tri; e += z) {
+    z = (hdr.tri -e < sizeof(pad)) ? (size_t)(hdr.tri -e) : sizeof(pad);
+    err |= (fwrite(pad, 1, z, fp) != z);
+  }                             /* write the triangle */
+  err |= (fwrite(tri, 1, (size_t)hdr.trisz, fp) != (size_t)hdr.trisz);
+  if (fcm->cnts) {              /* if there is a cosine map */
+    z = (size_t)(hdr.cmap -hdr.tri -hdr.trisz);
+    err |= (fwrite(pad, 1, z, fp) != z);
+    err |= (fwrite(fcm->cmap, sizeof(REAL), (size_t)fcm->T+1, fp)
+            != (size_t)fcm->T+1);
+  }                             /* write the cosine map */
+  err |= (fclose(fp) != 0);     /* close the matrix file */
+  return (err) ? -1 : 0;        /* return the error status */
+}  /* fcm_save() */
+
+/*--------------------------------------------------------------------------*/
+
+inline SFXNAME(FCMAT)* SFXNAME(fcm_open) (const char *fname)
+{                               /* --- open a saved matrix */
+  SFXNAME(FCMAT) *fcm;          /* matrix to create */
+  FCMHDR hdr;                   /* header of the matrix file */
+  FILE   *fp;                   /* file to read from */
+  char   *map;                  /* mapped (or loaded) file */
+  #ifndef _WIN32                /* if Linux/Unix system */
+  int    fd;                    /* file descriptor for mapping */
+  struct stat st;               /* status of the file (its length) */
+  #endif
+
+  assert(fname);                /* check the function argument */
+  fp = fopen(fname, "rb");      /* open the matrix file */
+  if (!fp) return NULL;         /* and read the header */
+  if ((fread(&hdr, sizeof(hdr), 1, fp) != 1)
+  ||  (memcmp(hdr.magic, FCM_MAGIC, sizeof(hdr.magic)) != 0)
+  ||  (hdr.real != (int32_t)sizeof(REAL))
+  ||  (hdr.V < 2) || (hdr.fmt < FCMF_REAL) || (hdr.fmt > FCMF_N32)
+  ||  (hdr.T < 1) || (hdr.tri < sizeof(hdr))
+  ||  (hdr.size < hdr.tri) || (hdr.size -hdr.tri < hdr.trisz)
+  ||  ((hdr.fmt >= FCMF_N8)     /* the cosine map must follow the */
+  &&   ((hdr.cmap < hdr.tri) || (hdr.cmap -hdr.tri < hdr.trisz)
+  ||    (hdr.size < hdr.cmap)   /* triangle and lie in the file */
+  ||    ((hdr.size -hdr.cmap) /sizeof(REAL) < (uint64_t)hdr.T+1)))
+  ||  (hdr.trisz != (uint64_t)((hdr.mode & FCM_TILED)
+                   ? tri_size((DIM)hdr.V)
+                   : (size_t)hdr.V *(size_t)(hdr.V-1)/2)
+                  * (uint64_t)((hdr.fmt == FCMF_REAL) ? hdr.real
+                             : (hdr.fmt == FCMF_N8)   ? 1
+                             : (hdr.fmt == FCMF_N32)  ? 4 : 2))) {
+    fprintf(stderr, "fcm_open: %s is no matrix file for this type\n",
+            fname);             /* check the header */
+    fclose(fp); return NULL;    /* (the size of REAL must match) */
+  }
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  map = (char*)malloc((size_t)hdr.size);
+  if (map && ((fseek(fp, 0, SEEK_SET) != 0)
+  ||          (fread(map, 1, (size_t)hdr.size, fp) != (size_t)hdr.size))) {
+    free(map); map = NULL; }    /* load the whole file */
+  fclose(fp);                   /* (no memory mapping yet) */
+  if (!map) return NULL;
+  #else                         /* if Linux/Unix system */
+  fclose(fp);                   /* map the whole file read-only */
+  fd = open(fname, O_RDONLY);   /* (the pages are shared with other */
+  if (fd < 0) return NULL;      /* processes that map the same file) */
+  if ((fstat(fd, &st) != 0) || ((uint64_t)st.st_size < hdr.size)) {
+    fprintf(stderr, "fcm_open: %s is truncated\n", fname);
+    close(fd); return NULL;     /* check the length of the file */
+  }                             /* (pages beyond its end would */
+                                /* cause a bus error on access) */
+  map = (char*)mmap(NULL, (size_t)hdr.size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);                    /* (the mapping keeps the file open) */
+  if (map == (char*)MAP_FAILED) return NULL;
+  #endif
+  fcm = (SFXNAME(FCMAT)*)malloc(sizeof(SFXNAME(FCMAT)));
+  if (!fcm) {                   /* allocate the base structure */
+    #ifdef _WIN32
+    free(map);
+    #else
+    munmap(map, (size_t)hdr.size);
+    #endif
+    return NULL;
+  }
+  memset(fcm, 0, sizeof(SFXNAME(FCMAT)));
+  fcm->V       = (DIM)hdr.V;    /* note the number of voxels */
+  fcm->T       = (DIM)hdr.T;    /* and  the number of scans */
+  fcm->X       = fcm->T;        /* (a saved matrix has no data) */
+  fcm->mode    = hdr.mode;      /* note the processing mode */
+  fcm->tile    = fcm->V;        /* matrix is half-stored */
+  fcm->maxmem  = -1;            /* no memory limit */
+  fcm->nthd    = 1;             /* no threads are needed */
+  fcm->fd      = -1;            /* no out-of-core store */
+  fcm->slot.cnt = 1;            /* (and no tile slots) */
+  fcm->map     = map;           /* note the mapped file */
+  fcm->mapsz   = (size_t)hdr.size;
+  fcm->isa     = SFXNAME(fcm_isa)();
+  fcm->clamp   = (REAL)hdr.clamp;   /* (files of older versions */
+  fcm->thresh  = (REAL)hdr.thresh;  /* have zeros, but no such mode) */
+  fcm->diag    = (hdr.mode & FCM_WVAR) ? 0   /* (variances of */
+               : SFXNAME(fcm_xval)(fcm, (REAL)1); /* windows) */
+  fcm->value   = fcm->diag;     /* set the value and coordinates */
+  fcm->rb      = fcm->cb = fcm->V;
+  #ifndef _WIN32                /* not yet available for Windows */
+  fcm->join    = 1;             /* no blocked threads to signal */
+  #endif
+  fcm->use.base  = sizeof(SFXNAME(FCMAT));
+  fcm->use.cache = (size_t)hdr.size;
+  fcm->use.peak  = fcm->use.base +fcm->use.cache;
+  switch (hdr.fmt) {            /* evaluate the element format */
+    case FCMF_REAL:             /* triangle of REALs */
+      fcm->cache = (REAL*)(map +hdr.tri);
+      fcm->get   = ((hdr.mode & FCM_XFORM) && !hdr.zval)
+                 ? SFXNAME(fcm_full_xf) : SFXNAME(fcm_full); break;
+    case FCMF_F16:              /* IEEE fp16 numbers */
+      fcm->half  = (uint16_t*)(map +hdr.tri);
+      fcm->get   = SFXNAME(fcm_full_f16);
+      #if defined FCM_ALL_ISA || defined __F16C__
+      if (fcm->isa & FCM_ISA_F16C) fcm->get = SFXNAME(fcm_full_f16c);
+      #endif
+      break;
+    case FCMF_BF16:             /* bfloat16 numbers */
+      fcm->half  = (uint16_t*)(map +hdr.tri);
+      fcm->get   = SFXNAME(fcm_full_bf16); break;
+    default:                    /* numbers of 11 configurations */
+      fcm->cnts  = map +hdr.tri;
+      fcm->cmap  = (REAL*)(map +hdr.cmap);
+      fcm->get   = (hdr.fmt == FCMF_N8)  ? SFXNAME(fcm_full_n8)
+                 : (hdr.fmt == FCMF_N16) ? SFXNAME(fcm_full_n16)
+                 :                         SFXNAME(fcm_full_n32); break;
+  }                             /* set the element retrieval function */
+  fcm->cget = fcm->get;         /* (all elements are available) */
+  if (hdr.mode & FCM_TILED) {   /* if the triangle is tiled */
+    fcm->toff = tri_toff(fcm->V);
+    if (!fcm->toff) { SFXNAME(fcm_delete)(fcm); return NULL; }
+  }                             /* create the tile offset table */
+  return fcm;                   /* return the opened matrix */
+}  /* fcm_open() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_unmap) (SFXNAME(FCMAT) *fcm)
+{                               /* --- unmap a saved matrix */
+  assert(fcm && fcm->map);      /* check the function argument */
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  free(fcm->map);               /* delete the loaded file */
+  #else                         /* if Linux/Unix system */
+  munmap(fcm->map, fcm->mapsz); /* unmap the file */
+  #endif
+  fcm->map   = NULL;            /* clear all pointers */
+  fcm->cache = NULL;            /* into the mapped file */
+  fcm->half  = NULL;            /* (fcm_delete() must not */
+  fcm->cnts  = NULL;            /* free them) */
+  fcm->cmap  = NULL;
+}  /* fcm_unmap() */
+
+/*----------------------------------------------------------------------------
+  Online Functions
+----------------------------------------------------------------------------*/
+/* An online matrix keeps the running means m_i of the voxels and the     */
+/* co-moments M_ij = sum_t (x_it -m_i)(x_jt -m_j) in double precision.    */
+/* A new scan x changes them by a rank-1 update (Welford's method): with  */
+/* the deviations d = x -m from the old means and n scans afterwards,     */
+/* m += d/n and M += (n-1)/n d d^T. So appending a scan costs O(V^2) and  */
+/* the data need not be normalized again. The correlation coefficients    */
+/* r_ij = M_ij /sqrt(M_ii M_jj) are computed when they are retrieved.     */
+/* The variances M_ii precede the off-diagonal triangle (row-major).      */
+
+inline REAL SFXNAME(fcm_onl) (SFXNAME(FCMAT) *fcm, DIM row, DIM col)
+{                               /* --- get corr.c. from co-moments */
+  DIM    i;                     /* buffer for exchange */
+  double s, r;                  /* product of variances, corr. coeff. */
+
+  assert(fcm                    /* check the function arguments */
+  &&    (row >= 0) && (row < fcm->V) && (col >= 0) && (col < fcm->V));
+  if (row == col)               /* if diagonal element, */
+    return fcm->diag;           /* return a fixed value */
+  if (row > col) { i = row; row = col; col = i; }
+  s = fcm->mom[row] *fcm->mom[col];
+  r = (s > 0) ? fcm->mom[(size_t)fcm->V +INDEX(row, col, fcm->V)] /sqrt(s)
+              : 0;              /* (zero variance: no correlation) */
+  return (fcm->mode & FCM_XFORM)/* compute the correlation coeff. */
+       ? SFXNAME(fcm_xval)(fcm, (REAL)r) : (REAL)r;
+}  /* fcm_onl() */              /* and apply the transform stage */
+
+/*--------------------------------------------------------------------------*/
+
+inline void* SFXNAME(fcm_onlrows) (void *p)
+{                               /* --- update rows of co-moments */
+  SFXNAME(ONLTASK) *t = p;      /* type the argument pointer */
+  DIM    V = t->fcm->V;         /* number of voxels */
+  double *d = t->fcm->avg +V;   /* deviations of the new scan */
+  double *v = t->fcm->mom;      /* variances and co-moments */
+  double *m;                    /* row of the co-moments */
+  double a;                     /* weighted deviation of row voxel */
+  DIM    i, j;                  /* loop variables */
+
+  for (i = t->ra; i < t->rb; i++) {
+    a     = t->w *d[i];         /* traverse the rows and */
+    v[i] += a *d[i];            /* update the variance */
+    m = v +V +INDEX(i, i+1, V) -(size_t)(i+1);
+    for (j = i+1; j < V; j++)   /* update the co-moments */
+      m[j] += a *d[j];          /* (m is indexed with the column) */
+  }
+  return NULL;                  /* return a dummy result */
+}  /* fcm_onlrows() */
+
+/*--------------------------------------------------------------------------*/
+
+inline void SFXNAME(fcm_onlupd) (SFXNAME(FCMAT) *fcm, double w)
+{                               /* --- rank-1 update of co-moments */
+  SFXNAME(ONLTASK) *t = (SFXNAME(ONLTASK)*)fcm->mem;
+  DIM    k;                     /* loop variable for row parts */
+
+  for (k = 0; k < fcm->gr; k++) /* set the weight of the update */
+    t[k].w = w;                 /* (deviations are in fcm->avg +V) */
+  #ifndef _WIN32                /* not yet available for Windows */
+  if (fcm->gr > 1) {            /* if several row parts */
+    fcm_poolrun(SFXNAME(fcm_onlrows), t, sizeof(SFXNAME(ONLTASK)),
+                (int)fcm->gr, (int)fcm->gr);
+    return;                     /* update the parts of the rows */
+  }                             /* with the shared thread pool */
+  #endif
+  for (k = 0; k < fcm->gr; k++) /* update the parts of the rows */
+    SFXNAME(fcm_onlrows)(t+k);  /* in the calling thread */
+}  /* fcm_onlupd() */
+
+/*--------------------------------------------------------------------------*/
+
+inline SFXNAME(FCMAT)* SFXNAME(fcm_online) (REAL *data, DIM V, DIM T,
+                                            int mode, ...)
+{                               /* --- create an online matrix */
+  SFXNAME(FCMAT) *fcm;          /* matrix to create */
+  SFXNAME(ONLTASK) *t;          /* row parts of the update */
+  va_list args;                 /* list of variable arguments */
+  size_t z, e, c;               /* number of co-moments, part bound */
+  size_t size;                  /* size of the memory block */
+  double *d;                    /* deviations from the means */
+  DIM    i, k, n;               /* loop variables, number of parts */
+
+  assert((V > 1) && (T >= 0) && (data || (T == 0)));
+  if ((mode & FCM_CORR) != FCM_PCC) {
+    fprintf(stderr, "fcm_online: only Pearson correlation "
+                    "can be updated online\n");
+    return NULL;                /* (tetrachoric correlation needs */
+  }                             /* the median of the whole series) */
+  if (mode & FCM_WINDOW) {      /* sliding windows need all scans */
+    fprintf(stderr, "fcm_online: sliding windows "
+                    "cannot be updated online\n");
+    return NULL;                /* (the window sums are not kept) */
+  }
+  fcm = (SFXNAME(FCMAT)*)malloc(sizeof(SFXNAME(FCMAT)));
+  if (!fcm) return NULL;        /* allocate the base structure */
+  memset(fcm, 0, sizeof(SFXNAME(FCMAT)));
+  fcm->V       = V;             /* note the number of voxels */
+  fcm->mode    = mode | FCM_ONLINE;
+  fcm->tile    = V;             /* elements are always available */
+  fcm->maxmem  = -1;            /* default memory limit */
+  fcm->nthd    = proccnt();     /* default: use all processors */
+  fcm->fd      = -1;            /* no out-of-core store */
+  fcm->slot.cnt = 1;            /* (and no tile slots) */
+  fcm->isa     = SFXNAME(fcm_isa)();
+  fcm->clamp   = 1;             /* default: no clamping and */
+  fcm->thresh  = 0;             /* binarization at zero */
+  fcm->rb      = fcm->cb = V;   /* (traversal of the whole matrix) */
+  #ifndef _WIN32                /* not yet available for Windows */
+  fcm->join    = 1;             /* no blocked threads to signal */
+  #endif
+
+  va_start(args, mode);         /* start variable arguments */
+  if (mode & FCM_THREAD)        /* get the number of threads */
+    fcm->nthd = va_arg(args, int);
+  if (mode & FCM_CACHE)         /* skip the tile size */
+    va_arg(args, DIM);          /* (all elements are available) */
+  if (mode & FCM_MAXMEM)        /* get the memory limit (in GiB) */
+    fcm->maxmem = va_arg(args, double);
+  if (mode & FCM_DISK)          /* skip the store directory */
+    va_arg(args, const char*);  /* and the number of tile slots */
+  if (mode & FCM_SLOTS)
+    va_arg(args, int);
+  if (mode & FCM_CLAMP)         /* get the bound for clamping */
+    fcm->clamp  = (REAL)va_arg(args, double);
+  if (mode & FCM_BIN)           /* get the threshold */
+    fcm->thresh = (REAL)va_arg(args, double);
+  va_end(args);                 /* end variable arguments */
+  if (fcm->nthd < 1) fcm->nthd = 1;
+  if (fcm->maxmem < 0)          /* as for fcm_create(), use the */
+    fcm->maxmem = FCM_MEMDEF;   /* default limit if none is given */
+  fcm->maxmem = fcm->maxmem *1024*1024*1024;
+  fcm->diag  = SFXNAME(fcm_xval)(fcm, (REAL)1);
+  fcm->value = fcm->diag;       /* transform the diagonal value */
+
+  z = (size_t)V *(size_t)(V-1)/2;
+  n = (z /ONL_MIN < (size_t)fcm->nthd) ? (DIM)(z /ONL_MIN) : fcm->nthd;
+  if (n < 1) n = 1;             /* get the number of row parts */
+  size = (size_t)n *sizeof(SFXNAME(ONLTASK))
+       + (3*(size_t)V +z) *sizeof(double);
+  if ((double)(sizeof(SFXNAME(FCMAT)) +size) > fcm->maxmem) {
+    fprintf(stderr, "fcm_online: co-moments exceed the memory limit\n");
+    free(fcm); return NULL;     /* (there is no smaller variant */
+  }                             /* of an online matrix) */
+  fcm->mem = calloc(size, 1);   /* allocate tasks, means, deviations, */
+  if (!fcm->mem) { free(fcm); return NULL; }   /* and co-moments */
+  t = (SFXNAME(ONLTASK)*)fcm->mem;
+  fcm->avg = (double*)(t+n);    /* set the means and deviations, */
+  fcm->mom = fcm->avg +2*(size_t)V; /* variances and co-moments */
+  for (i = k = 0, c = 0; k < n; k++) {
+    e = (size_t)((double)z *(double)(k+1) /(double)n);
+    t[k].fcm = fcm;             /* split the rows into parts */
+    t[k].ra  = i;               /* with about the same number */
+    while ((i < V) && (c < e))  /* of co-moments */
+      c += (size_t)(V-1-i++);
+    t[k].rb  = (k < n-1) ? i : V;
+  }
+  fcm->gr = n; fcm->gc = 1;     /* (a grid with one column) */
+  fcm->use.base  = sizeof(SFXNAME(FCMAT));
+  fcm->use.data  = size -((size_t)V +z) *sizeof(double);
+  fcm->use.cache = ((size_t)V +z) *sizeof(double);
+  fcm->use.peak  = fcm->use.base +size;
+  fcm->get = fcm->cget = SFXNAME(fcm_onl);
+
+  if (T > 0) {                  /* if initial scans are given */
+    d = fcm->avg +V;            /* compute the means of the voxels */
+    for (i = 0; i < V; i++) {   /* (two passes over the data, */
+      for (k = 0; k < T; k++)   /* so that the co-moments need */
+        fcm->avg[i] += (double)data[(size_t)i*(size_t)T +(size_t)k];
+      fcm->avg[i] /= (double)T; /* no correction) */
+    }
+    for (k = 0; k < T; k++) {   /* add the scans with their */
+      for (i = 0; i < V; i++)   /* deviations from the means */
+        d[i] = (double)data[(size_t)i*(size_t)T +(size_t)k]
+             - fcm->avg[i];
+      SFXNAME(fcm_onlupd)(fcm, 1.0);
+    }
+  }
+  fcm->T = fcm->X = T;          /* note the number of scans */
+  return fcm;                   /* return the created matrix */
+}  /* fcm_online() */
+
+/*--------------------------------------------------------------------------*/
+
+inline int SFXNAME(fcm_append) (SFXNAME(FCMAT) *fcm, const REAL *vol)
+{                               /* --- add a scan to an online matrix */
+  double *d;                    /* deviations from the means */
+  double n;                     /* number of scans afterwards */
+  DIM    i;                     /* loop variable */
+
+  assert(fcm && vol);           /* check the function arguments */
+  if (!(fcm->mode & FCM_ONLINE)) {
+    fprintf(stderr, "fcm_append: matrix is not an online matrix\n");
+    return -1;                  /* print an error message */
+  }                             /* and abort the function */
+  d = fcm->avg +fcm->V;         /* get the deviations */
+  n = (double)(fcm->T +1);      /* from the old means */
+  for (i = 0; i < fcm->V; i++) {/* and update the means */
+    d[i] = (double)vol[i] -fcm->avg[i];
+    fcm->avg[i] += d[i] /n;
+  }
+  SFXNAME(fcm_onlupd)(fcm, (n-1) /n);
+  fcm->T += 1; fcm->X = fcm->T; /* update the co-moments */
+  return 0;                     /* and the number of scans */
+}  /* fcm_append() */
 
 /*----------------------------------------------------------------------------
   Recursion Handling
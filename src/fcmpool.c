@@ -0,0 +1,366 @@
+/*----------------------------------------------------------------------
+  File    : fcmpool.c
+  Contents: process-wide pool of worker threads (work stealing)
+            and spin-then-futex barriers
+  Author  : agent
+----------------------------------------------------------------------*/
+#ifndef _WIN32                  /* not yet available for Windows */
+#define _DEFAULT_SOURCE         /* needed for syscall() */
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include "fcmpool.h"
+
+#ifndef NDEBUG
+#line __LINE__ "fcmpool.c"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define DEQ_SIZE    16          /* initial size of a worker deque */
+#define BAR_SPIN    2048        /* polls of a barrier before sleeping */
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#define PAUSE()     __builtin_ia32_pause()
+#else                           /* hint to the processor that */
+#define PAUSE()     ((void)0)   /* the thread is polling */
+#endif
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- deque of a pool worker --- */
+  pthread_mutex_t mutex;        /* access control variable */
+  FCMJOB **jobs;                /* claims on jobs (one task each) */
+  int    head, tail;            /* steal at head, pop/push at tail */
+  int    size;                  /* size of the claim array */
+} DEQUE;                        /* (the owner works on the newest */
+                                /* claim, thieves take the oldest) */
+typedef struct {                /* --- pool of worker threads --- */
+  pthread_mutex_t mutex;        /* access control variable */
+  pthread_cond_t  cond;         /* notify of new claims/finished jobs */
+  unsigned  seq;                /* number of posts (for waking up) */
+  int       stop;               /* flag for stopping the workers */
+  int       cnt;                /* number of workers */
+  int       next;               /* deque for the next claim */
+  pthread_t thds[FCM_POOLMAX];  /* thread handles */
+  DEQUE     deqs[FCM_POOLMAX];  /* deques of the workers */
+} POOL;                         /* (mutex protects all but the deques */
+                                /* and the task counters of the jobs) */
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static POOL pool = {            /* the process-wide pool */
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .cond  = PTHREAD_COND_INITIALIZER };
+
+/*----------------------------------------------------------------------
+  Deque Functions
+----------------------------------------------------------------------*/
+
+static int deq_push (DEQUE *d, FCMJOB *job)
+{                               /* --- add a claim to a deque */
+  FCMJOB **p;                   /* reallocated claim array */
+  int    n;                     /* new size of the claim array */
+
+  pthread_mutex_lock(&d->mutex);
+  if (d->tail >= d->size) {     /* if the claim array is full */
+    if (d->head > 0) {          /* if claims have been stolen, */
+      memmove(d->jobs, d->jobs +d->head,   /* close the gap */
+              (size_t)(d->tail -d->head) *sizeof(FCMJOB*));
+      d->tail -= d->head; d->head = 0; }
+    else {                      /* if the claim array is really full */
+      n = (d->size > 0) ? d->size *2 : DEQ_SIZE;
+      p = (FCMJOB**)realloc(d->jobs, (size_t)n *sizeof(FCMJOB*));
+      if (!p) { pthread_mutex_unlock(&d->mutex); return -1; }
+      d->jobs = p; d->size = n; /* enlarge the claim array */
+    }
+  }
+  d->jobs[d->tail++] = job;     /* store the new claim */
+  pthread_mutex_unlock(&d->mutex);
+  return 0;                     /* return 'ok' */
+}  /* deq_push() */
+
+/*--------------------------------------------------------------------*/
+
+static FCMJOB* deq_pop (DEQUE *d, int steal)
+{                               /* --- remove a claim from a deque */
+  FCMJOB *job = NULL;           /* claimed job */
+
+  pthread_mutex_lock(&d->mutex);
+  if (d->tail > d->head) {      /* if the deque is not empty */
+    job = (steal) ? d->jobs[d->head++] : d->jobs[--d->tail];
+    if (d->head >= d->tail) d->head = d->tail = 0;
+  }                             /* take the oldest or newest claim */
+  pthread_mutex_unlock(&d->mutex);
+  return job;                   /* return the claimed job */
+}  /* deq_pop() */
+
+/*--------------------------------------------------------------------*/
+
+static int deq_purge (DEQUE *d, FCMJOB *job)
+{                               /* --- remove the claims of a job */
+  int    i, k;                  /* loop variables */
+
+  pthread_mutex_lock(&d->mutex);
+  for (i = k = d->head; i < d->tail; i++)
+    if (d->jobs[i] != job) d->jobs[k++] = d->jobs[i];
+  i = d->tail -k; d->tail = k;  /* keep the claims on other jobs */
+  if (d->head >= d->tail) d->head = d->tail = 0;
+  pthread_mutex_unlock(&d->mutex);
+  return i;                     /* return the number of */
+}  /* deq_purge() */            /* removed claims */
+
+/*----------------------------------------------------------------------
+  Pool Functions
+----------------------------------------------------------------------*/
+
+static void job_exec (FCMJOB *job, int claim)
+{                               /* --- execute tasks of a job */
+  int    i;                     /* index of the task */
+
+  while (job->next < job->n) {  /* while there are unstarted tasks */
+    i = job->next++;            /* take the next task */
+    pthread_mutex_unlock(&pool.mutex);
+    job->fn(job->data +(size_t)i *job->size);
+    pthread_mutex_lock(&pool.mutex);
+    job->done++;                /* execute the task and */
+  }                             /* count it as finished */
+  if (claim) job->refs--;       /* release the claim of a worker */
+  if ((job->done >= job->n) && (job->refs <= 0))
+    pthread_cond_broadcast(&pool.cond);
+}  /* job_exec() */             /* notify of the finished job */
+                                /* (called with the pool locked) */
+/*--------------------------------------------------------------------*/
+
+static void* worker (void *p)
+{                               /* --- worker thread of the pool */
+  int      id = (int)(intptr_t)p;  /* index of the worker */
+  int      i, n;                /* loop variable, number of deques */
+  unsigned seq;                 /* number of posts seen */
+  FCMJOB   *job;                /* claimed job */
+
+  pthread_mutex_lock(&pool.mutex);
+  while (!pool.stop) {          /* work loop of the worker */
+    seq = pool.seq;             /* note the number of posts */
+    n   = pool.cnt;             /* and the number of deques */
+    pthread_mutex_unlock(&pool.mutex);
+    job = deq_pop(pool.deqs +id, 0);
+    for (i = 1; !job && (i < n); i++)
+      job = deq_pop(pool.deqs +(id+i) %n, 1);
+    pthread_mutex_lock(&pool.mutex);
+    if (job)                    /* take a claim from the own deque */
+      job_exec(job, 1);         /* or steal one from another deque */
+    else {                      /* and execute the tasks of the job */
+      while ((seq == pool.seq) && !pool.stop)
+        pthread_cond_wait(&pool.cond, &pool.mutex);
+    }                           /* if there was nothing to do, */
+  }                             /* wait for a new post */
+  pthread_mutex_unlock(&pool.mutex);
+  return NULL;                  /* return a dummy result */
+}  /* worker() */
+
+/*--------------------------------------------------------------------*/
+
+int fcm_poolpost (FCMJOB *job, FCMTASK *fn, void *data,
+                  size_t size, int n, int par)
+{                               /* --- start the tasks of a job */
+  DEQUE  *d;                    /* deque of a new worker */
+  int    i, k;                  /* loop variable, number of claims */
+
+  assert(job && fn && (n >= 0));/* check the function arguments */
+  job->fn   = fn;   job->data = (char*)data;
+  job->size = size; job->n    = n;
+  job->next = job->done = job->refs = 0;
+  if (par > n)           par = n;
+  if (par > FCM_POOLMAX) par = FCM_POOLMAX;
+  if (par <= 0) return 0;       /* limit the parallelism */
+  pthread_mutex_lock(&pool.mutex);
+  while (pool.cnt < par) {      /* while the pool is too small */
+    d = pool.deqs +pool.cnt;    /* initialize a deque */
+    pthread_mutex_init(&d->mutex, NULL);
+    d->jobs = NULL; d->head = d->tail = d->size = 0;
+    if (pthread_create(pool.thds +pool.cnt, NULL, worker,
+                       (void*)(intptr_t)pool.cnt) != 0) {
+      pthread_mutex_destroy(&d->mutex); break; }
+    pool.cnt++;                 /* start a new worker */
+  }                             /* (it waits for the pool mutex) */
+  for (k = 0; k < par; k++) {   /* distribute the claims */
+    if (pool.cnt <= 0) break;   /* over the worker deques */
+    i = pool.next; pool.next = (i+1) % pool.cnt;
+    if (deq_push(pool.deqs +i, job) != 0) break;
+  }                             /* (claims that cannot be stored */
+  job->refs = k;                /* are made up for by the caller */
+  pool.seq++;                   /* of fcm_poolwait()) */
+  pthread_cond_broadcast(&pool.cond);
+  pthread_mutex_unlock(&pool.mutex);
+  return (k > 0) ? 0 : -1;      /* wake the workers and */
+}  /* fcm_poolpost() */         /* return the status */
+
+/*--------------------------------------------------------------------*/
+
+int fcm_poolwait (FCMJOB *job)
+{                               /* --- wait for the tasks of a job */
+  int    i, n, k = 0;           /* loop variable, number of deques */
+
+  assert(job);                  /* check the function argument */
+  pthread_mutex_lock(&pool.mutex);
+  job_exec(job, 0);             /* execute the unstarted tasks */
+  n = (job->refs > 0) ? pool.cnt : 0;
+  pthread_mutex_unlock(&pool.mutex);
+  for (i = 0; i < n; i++)       /* remove the claims that have not */
+    k += deq_purge(pool.deqs +i, job);   /* been taken up yet */
+  pthread_mutex_lock(&pool.mutex);
+  job->refs -= k;               /* wait for the workers to finish */
+  while ((job->done < job->n) || (job->refs > 0))
+    pthread_cond_wait(&pool.cond, &pool.mutex);
+  pthread_mutex_unlock(&pool.mutex);
+  return 0;                     /* return 'ok' */
+}  /* fcm_poolwait() */
+
+/*--------------------------------------------------------------------*/
+
+int fcm_poolrun (FCMTASK *fn, void *data, size_t size, int n, int par)
+{                               /* --- execute the tasks of a job */
+  FCMJOB job;                   /* job to execute */
+  int    i;                     /* loop variable for tasks */
+
+  assert(fn && (n >= 0));       /* check the function arguments */
+  if (par > n) par = n;         /* limit the parallelism */
+  if (par <= 1) {               /* if to execute the tasks serially */
+    for (i = 0; i < n; i++) fn((char*)data +(size_t)i *size);
+    return 0;                   /* execute the tasks directly */
+  }                             /* (no need to involve the pool) */
+  fcm_poolpost(&job, fn, data, size, n, par-1);
+  return fcm_poolwait(&job);    /* the caller is one of the threads */
+}  /* fcm_poolrun() */
+
+/*--------------------------------------------------------------------*/
+
+int fcm_poolsize (void)
+{                               /* --- get the number of workers */
+  int n;                        /* number of workers */
+
+  pthread_mutex_lock(&pool.mutex);
+  n = pool.cnt;                 /* get the number of workers */
+  pthread_mutex_unlock(&pool.mutex);
+  return n;                     /* and return it */
+}  /* fcm_poolsize() */
+
+/*--------------------------------------------------------------------*/
+
+void fcm_poolexit (void)
+{                               /* --- stop the pool workers */
+  int i, n;                     /* loop variable, number of workers */
+
+  pthread_mutex_lock(&pool.mutex);
+  pool.stop = 1;                /* set the stop indicator */
+  pthread_cond_broadcast(&pool.cond);
+  n = pool.cnt;                 /* signal the workers to stop */
+  pthread_mutex_unlock(&pool.mutex);
+  for (i = 0; i < n; i++)       /* wait for all workers to finish */
+    pthread_join(pool.thds[i], NULL);
+  pthread_mutex_lock(&pool.mutex);
+  for (i = 0; i < n; i++) {     /* traverse the deques */
+    pthread_mutex_destroy(&pool.deqs[i].mutex);
+    free(pool.deqs[i].jobs);    /* destroy the access control */
+  }                             /* and delete the claim arrays */
+  pool.cnt  = pool.next = 0;    /* reset the pool, so that it is */
+  pool.stop = 0;                /* started again on the next post */
+  pthread_mutex_unlock(&pool.mutex);
+}  /* fcm_poolexit() */
+
+/*----------------------------------------------------------------------
+  Barrier Functions
+----------------------------------------------------------------------*/
+
+static void bar_sleep (FCMBAR *bar, unsigned phase)
+{                               /* --- sleep until the phase changes */
+  #ifdef __linux__              /* (may return spuriously) */
+  syscall(SYS_futex, &bar->phase, FUTEX_WAIT_PRIVATE, phase,
+          NULL, NULL, 0);
+  #else
+  sched_yield();                /* without futexes, */
+  #endif                        /* yield the processor */
+}  /* bar_sleep() */
+
+/*--------------------------------------------------------------------*/
+
+static void bar_wake (FCMBAR *bar)
+{                               /* --- wake the sleeping threads */
+  #ifdef __linux__
+  syscall(SYS_futex, &bar->phase, FUTEX_WAKE_PRIVATE, INT_MAX,
+          NULL, NULL, 0);
+  #endif
+}  /* bar_wake() */
+
+/*--------------------------------------------------------------------*/
+
+static int bar_arrive (FCMBAR *bar, unsigned *phase)
+{                               /* --- arrive at a barrier */
+  *phase = __atomic_load_n(&bar->phase, __ATOMIC_ACQUIRE);
+  if (__atomic_sub_fetch(&bar->cnt, 1, __ATOMIC_ACQ_REL) > 0)
+    return 0;                   /* if others are still to arrive */
+  __atomic_store_n(&bar->cnt, __atomic_load_n(&bar->n, __ATOMIC_SEQ_CST),
+                   __ATOMIC_RELAXED);
+  __atomic_add_fetch(&bar->phase, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&bar->sleep, __ATOMIC_SEQ_CST) > 0)
+    bar_wake(bar);              /* reinit. the counter for the next */
+  return 1;                     /* phase, release the other threads */
+}  /* bar_arrive() */            /* and wake them if they sleep */
+
+/*--------------------------------------------------------------------*/
+
+void fcm_barinit (FCMBAR *bar, int n)
+{                               /* --- initialize a barrier */
+  long c = sysconf(_SC_NPROCESSORS_ONLN);
+
+  assert(bar && (n > 0));       /* check the function arguments */
+  bar->n     = bar->cnt = n;    /* note the number of threads */
+  bar->phase = 0;               /* and start with the first phase */
+  bar->sleep = 0;               /* polling only pays if all threads */
+  bar->spin  = ((c > 1) && (n <= c)) ? BAR_SPIN : 0;
+}  /* fcm_barinit() */          /* can run at the same time */
+
+/*--------------------------------------------------------------------*/
+
+void fcm_barwait (FCMBAR *bar)
+{                               /* --- wait at a barrier */
+  unsigned phase;               /* phase on arrival */
+  int      i;                   /* loop variable for polling */
+
+  assert(bar);                  /* check the function argument */
+  if (bar_arrive(bar, &phase)) return;
+  for (i = bar->spin; i > 0; i--) {   /* if the last to arrive, */
+    if (__atomic_load_n(&bar->phase, __ATOMIC_ACQUIRE) != phase)
+      return;                   /* the barrier is passed, otherwise */
+    PAUSE();                    /* poll the phase counter for a while */
+  }
+  __atomic_add_fetch(&bar->sleep, 1, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(&bar->phase, __ATOMIC_SEQ_CST) == phase)
+    bar_sleep(bar, phase);      /* then sleep until the last thread */
+  __atomic_sub_fetch(&bar->sleep, 1, __ATOMIC_SEQ_CST);
+}  /* fcm_barwait() */          /* arrives and advances the phase */
+
+/*--------------------------------------------------------------------*/
+
+void fcm_bardrop (FCMBAR *bar)
+{                               /* --- leave a barrier */
+  unsigned phase;               /* phase on arrival (unused) */
+
+  assert(bar && (bar->n > 0));  /* check the function argument */
+  __atomic_sub_fetch(&bar->n, 1, __ATOMIC_SEQ_CST);
+  bar_arrive(bar, &phase);      /* remove the thread from later */
+}  /* fcm_bardrop() */           /* phases and arrive at this one */
+
+#endif  /* #ifndef _WIN32 */
@@ -0,0 +1,84 @@
+/*----------------------------------------------------------------------
+  File    : fcmpool.h
+  Contents: process-wide pool of worker threads (work stealing)
+            and spin-then-futex barriers
+  Author  : agent
+----------------------------------------------------------------------*/
+#ifndef FCMPOOL_H
+#define FCMPOOL_H
+
+#include <stddef.h>
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define FCM_POOLMAX 1024        /* maximum number of pool workers */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef void* FCMTASK (void *data);
+                                /* --- task function (result unused, */
+                                /* same type as a POSIX thread worker) */
+typedef struct {                /* --- a job (set of tasks) */
+  FCMTASK *fn;                  /* task function */
+  char   *data;                 /* array of task data */
+  size_t size;                  /* size of the data of one task */
+  int    n;                     /* number of tasks */
+  int    next;                  /* index of the next task to start */
+  int    done;                  /* number of finished tasks */
+  int    refs;                  /* number of claims held by the pool */
+} FCMJOB;                       /* (task i gets data +i*size) */
+
+typedef struct {                /* --- a barrier */
+  int      n;                   /* number of participating threads */
+  int      cnt;                 /* number of threads yet to arrive */
+  unsigned phase;               /* phase counter (futex word) */
+  int      sleep;               /* number of sleeping threads */
+  int      spin;                /* number of polls before sleeping */
+} FCMBAR;                       /* (sense-reversing: the parity of */
+                                /* the phase counter is the sense) */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+#ifndef _WIN32                  /* not yet available for Windows */
+extern int  fcm_poolpost (FCMJOB *job, FCMTASK *fn, void *data,
+                          size_t size, int n, int par);
+extern int  fcm_poolwait (FCMJOB *job);
+extern int  fcm_poolrun  (FCMTASK *fn, void *data, size_t size,
+                          int n, int par);
+extern int  fcm_poolsize (void);
+extern void fcm_poolexit (void);
+
+extern void fcm_barinit  (FCMBAR *bar, int n);
+extern void fcm_barwait  (FCMBAR *bar);
+extern void fcm_bardrop  (FCMBAR *bar);
+#endif
+
+/*----------------------------------------------------------------------
+  fcm_poolpost() starts the n tasks of a job without waiting for them:
+  task i is executed as fn(data +i*size). At most par tasks of the job
+  are taken up by pool workers at the same time (the pool is grown to
+  par workers if necessary, up to FCM_POOLMAX); the remaining tasks are
+  started by the workers that finish a task of the job or by the caller
+  of fcm_poolwait(), which executes tasks of the job until all of them
+  have been started and then waits for the others to finish. The job
+  structure must not be touched until fcm_poolwait() has returned.
+  fcm_poolrun() posts a job and waits for it, with the calling thread
+  as one of the par threads (so only par-1 pool workers are engaged).
+  Tasks report errors through their data; fcm_poolpost() returns -1
+  if no task could be handed to a pool worker (the tasks are then all
+  executed by the caller of fcm_poolwait()), the others return 0.
+  fcm_poolsize() returns the current number of pool workers and
+  fcm_poolexit() stops them (no job may be pending); the pool is
+  started again on the next call of fcm_poolpost().
+
+  A barrier is passed when all n threads have called fcm_barwait().
+  Waiting threads first poll the phase counter (unless there are more
+  participants than processors) and then sleep on it (with a futex on
+  Linux, otherwise by yielding the processor), so that a barrier that
+  is passed quickly costs no system call. fcm_bardrop() arrives at the
+  barrier without waiting and removes the caller from later phases.
+----------------------------------------------------------------------*/
+#endif  /* #ifndef FCMPOOL_H */
@@ -5,7 +5,6 @@
 ----------------------------------------------------------------------------*/
 #include <stdlib.h>
 #include <stdarg.h>
-#include <pthread.h>
 #include <assert.h>
 #include "cpuinfo.h"
 #include "fcmat.h"
@@ -18,7 +17,6 @@
 /*----------------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------------*/
-#define THREAD    pthread_t               // use the POSIX thread type
 #define THREAD_OK NULL                    // return value is void*
 
 /*----------------------------------------------------------------------------
@@ -31,8 +29,6 @@ typedef struct {                          // --- thread worker data ---
   DIM    *res;                            // result: node degrees
 } WORK;
 
-typedef void* WORKER (void*);
-
 /*----------------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------------*/
@@ -116,7 +112,7 @@ static void* fcm_nodedeg_wrk(void* p)
     int i;
     for (i = w->s; i < w->e; i++) {       // traverse row indices
       for (int j = i+1; j < n; j++) {     // traverse column indices
-        if (fcm_get(w->fcm,i,j) > w->thr) {
+        if (fcm_tget(w->fcm,i,j) > w->thr) {
           w->res[i]++;                    // increment degree values,
           w->res[j]++;                    // if the obtained FC estimate
         }                                 // exceeds the threshold
@@ -154,46 +150,44 @@ int fcm_nodedeg_multi(FCMAT *fcm, REAL thr, DIM *res, int nthd)
 
   int n = fcm_dim(fcm);                   // number of nodes
 
-  // thread, handles, data and worker
+  // worker data (one task per strip pair)
   int k = (n/2 +nthd-1) /nthd;            // compute the number of series
-  if (k <= 0) k = 1;                      // to be processed per thread
-  THREAD *threads = malloc((size_t)nthd *sizeof(THREAD));
-  if (!threads) {
-    DBGMSG("ERROR: malloc failed");
-    return -1; }                          // return 'failure'
+  if (k <= 0) k = 1;                      // to be processed per task
   WORK *w = malloc((size_t)nthd *sizeof(WORK));
   if (!w) {
     DBGMSG("ERROR: malloc failed");
-    free(threads);
     return -1; }                          // return 'failure'
-  WORKER *worker = fcm_nodedeg_wrk;
 
-  // execute the threads
+  // set up the tasks
   int i;                                  // loop variable
   int r = 0;                              // error status
-  for (i = 0; i < nthd; i++) {            // traverse the threads
+  for (i = 0; i < nthd; i++) {            // traverse the tasks
     w[i].fcm = fcm;                       // FC matrix
     w[i].thr = thr;                       // FC threshold
-    w[i].res = malloc((size_t)n*sizeof(DIM)); // partial result
     w[i].s   = (DIM)i*k;                  // compute and store start index
     if (w[i].s >= n/2) break;             // if beyond half, already done
     w[i].e    = w[i].s +k;                // compute and store end index
     if (w[i].e >= n/2) w[i].e = n -w[i].s;
-    if (pthread_create(threads+i, NULL, worker, w+i)) {
-      DBGMSG("ERROR: could not create thread");
-      r = -1;                             // create a thread for each strip
-      break; }                            // to compute the strips in parallel
+    w[i].res = malloc((size_t)n*sizeof(DIM)); // partial result
+    if (!w[i].res) {
+      DBGMSG("ERROR: malloc failed");
+      r = -1;                             // allocate memory for the
+      break; }                            // partial result of the task
   }
+
+  // run the tasks in the shared thread pool
+  // (at most nthd at a time, the calling thread is one of them)
+  fcm_poolrun(fcm_nodedeg_wrk, w, sizeof(WORK), i, nthd);
+
+  // combine the partial results
   for (int j = 0; j < n; j++)             // result: traverse nodes
     res[j] = 0;                           // initialize values
-  while (--i >= 0) {                      // wait for threads to finish
-    pthread_join(threads[i], NULL);       // (join threads with this one)
+  while (--i >= 0) {                      // traverse the tasks
     for (int j = 0; j < n; j++)           // combine partial results
-      res[j] += w[i].res[j];              // from the individual threads
+      res[j] += w[i].res[j];              // from the individual tasks
     free(w[i].res);                       // deallocate partial results
   }
 
-  free(threads);
   free(w);
 
   return r;                               // return error status
@@ -201,6 +195,25 @@ int fcm_nodedeg_multi(FCMAT *fcm, REAL thr, DIM *res, int nthd)
 
 /*--------------------------------------------------------------------------*/
 
+/* fcm_nodedeg_mem
+ * ---------------
+ * memory needed by fcm_nodedeg in addition to the FC matrix
+ *
+ * parameters
+ * N     number of nodes
+ * nthd  number of threads (0: single-threaded version)
+ *
+ * returns
+ * number of bytes (worker data, partial results)
+ */
+size_t fcm_nodedeg_mem(DIM N, int nthd)
+{
+  assert((N > 0) && (nthd >= 0));
+  return (size_t)nthd *(sizeof(WORK) +(size_t)N *sizeof(DIM));
+}  // fcm_nodedeg_mem()
+
+/*--------------------------------------------------------------------------*/
+
 /* fcm_nodedeg
  * -----------
  * compute node degrees based on a FC matrix and a FC threshold
@@ -250,6 +263,11 @@ int fcm_nodedeg(FCMAT *fcm, REAL thr, DIM *res, int mode, ...)
   }
   DBGMSG("N: %d  P: %d  C: %d\n", N, P, C);
 
+  // limit the threads to the memory budget of the matrix
+  if (P > 0)
+    P = fcm_memthd(fcm, fcm_nodedeg_mem(N, 1), P);
+  DBGMSG("N: %d  P: %d  C: %d\n", N, P, C);
+
   // compute degrees
   if      (P >  0)
     return fcm_nodedeg_multi (fcm, thr, res, P);
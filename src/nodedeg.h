@@ -35,4 +35,19 @@
  */
 extern int fcm_nodedeg(FCMAT *fcm, REAL thr, DIM *res, int mode, ...);
 
+/* fcm_nodedeg_mem
+ * ---------------
+ * memory needed by fcm_nodedeg in addition to the FC matrix
+ * (fcm_nodedeg reduces the number of threads if this memory
+ * does not fit into the memory limit of the FC matrix)
+ *
+ * parameters
+ * N     number of nodes
+ * nthd  number of threads (0: single-threaded version)
+ *
+ * returns
+ * number of bytes
+ */
+extern size_t fcm_nodedeg_mem(DIM N, int nthd);
+
 #endif  /* #ifndef NODEDEG_H */
@@ -5,14 +5,22 @@
 ----------------------------------------------------------------------*/
 #ifndef _WIN32                  /* if Linux/Unix system */
 #define _POSIX_C_SOURCE 200809L /* needed for clock_gettime() */
+#define _DEFAULT_SOURCE         /* needed for syscall() */
 #endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdarg.h>
+#include <string.h>
 #include <time.h>
 #include <assert.h>
 #include <math.h>
+#ifdef __linux__                /* for hardware performance counters */
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #ifdef __SSE2__
 #include <emmintrin.h>
@@ -22,11 +30,13 @@
 #endif
 
 #include "cpuinfo.h"
+#include "stats.h"
 #include "binarize.h"
 #include "pcc.h"
 #include "tetracc.h"
 #include "fcmat.h"
 #include "nodedeg.h"
+#include "edgestats.h"
 
 /*----------------------------------------------------------------------
   Preprocessor definitions
@@ -93,10 +103,24 @@
 #define E_ARGCNT     (-8)       /* wrong number of arguments */
 #define E_THREAD     (-9)       /* thread computation error */
 
+/*--------------------------------------------------------------------*/
+#define SUBJ           4        /* number of subjects of a cohort */
+
+/*--------------------------------------------------------------------*/
+#define PMU_CNT        4        /* number of counters per thread */
+#define PMU_THD     1024        /* maximum number of sampled threads */
+#define PMU_LINE      64        /* bytes transferred per cache miss */
+
 /*----------------------------------------------------------------------
   Global Variables
 ----------------------------------------------------------------------*/
 static const char *prgname;     /* program name for error messages */
+static const int  isalvl[] = {  /* instruction sets of the levels */
+  -1,                           /* of the tetrachoric block kernels */
+  ~FCM_ISA_VPOPCNT,             /* (all, AVX-512BW, AVX2, popcnt, */
+  ~(FCM_ISA_VPOPCNT|FCM_ISA_AVX512BW),   /* and lut16 pair kernel) */
+  ~(FCM_ISA_VPOPCNT|FCM_ISA_AVX512BW|FCM_ISA_AVX2),
+  ~(FCM_ISA_VPOPCNT|FCM_ISA_AVX512BW|FCM_ISA_AVX2|FCM_ISA_POPCNT) };
 
 /*----------------------------------------------------------------------
   Constants
@@ -155,6 +179,270 @@ static int error (int code, ...)
   exit(abs(code));              /* abort the program */
 }  /* error() */
 
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static FCMAT* reopen (FCMAT *fcm, const char *fname)
+{                               /* --- save and reopen a matrix */
+  if (fcm_save(fcm, fname) != 0) error(E_FWRITE, fname);
+  fcm_delete(fcm);              /* save the matrix to a file, */
+  fcm = fcm_open(fname);        /* delete it and map the file */
+  if (!fcm) error(E_FOPEN, fname);
+  return fcm;                   /* return the reopened matrix */
+}  /* reopen() */
+
+/*--------------------------------------------------------------------*/
+
+static FCMAT* online (REAL *data, DIM V, DIM T, DIM O, int mode, int P,
+                      double x, double z)
+{                               /* --- create an online matrix */
+  REAL  *buf;                   /* initial scans, then one scan */
+  FCMAT *fcm;                   /* created matrix */
+
+  buf = malloc((size_t)V *(size_t)((O > 0) ? O : 1) *sizeof(REAL));
+  if (!buf) return NULL;        /* allocate a scan buffer */
+  for (DIM i = 0; i < V; i++)   /* copy the initial scans */
+    for (DIM t = 0; t < O; t++)
+      buf [(size_t)i*(size_t)O +(size_t)t]
+        = data[(size_t)i*(size_t)T +(size_t)t];
+  fcm = fcm_online(buf, V, O, mode & (FCM_CORR|FCM_THREAD|FCM_XFORM),
+                   P, x, z);    /* (bound and threshold, if needed) */
+  for (DIM t = O; fcm && (t < T); t++) {
+    for (DIM i = 0; i < V; i++) /* append the remaining scans */
+      buf[i] = data[(size_t)i*(size_t)T +(size_t)t];
+    if (fcm_append(fcm, buf) != 0) { fcm_delete(fcm); fcm = NULL; }
+  }                             /* (one scan at a time, as they */
+  free(buf);                    /* would arrive from a scanner) */
+  return fcm;                   /* return the online matrix */
+}  /* online() */
+
+/*--------------------------------------------------------------------*/
+
+static FCMAT* create (REAL *data, DIM V, DIM T, int mode, int P, DIM C,
+                      double M, const char *dir, int K, DIM O,
+                      int L, int H, double lim, double bin)
+{                               /* --- create a matrix */
+  double x = (mode & FCM_CLAMP) ? lim : bin;
+  if (O >= 0)                   /* get the first transform argument */
+    return online(data, V, T, O, mode, P, x, bin);
+  if (mode & FCM_WINDOW) {      /* (window length and step follow */
+    if (mode & FCM_DISK)        /* the tile slots, if given) */
+      return (mode & FCM_SLOTS)
+           ? fcm_create(data, V, T, mode, P, C, M, dir, K, L, H)
+           : fcm_create(data, V, T, mode, P, C, M, dir, L, H);
+    return (mode & FCM_SLOTS)
+         ? fcm_create(data, V, T, mode, P, C, M, K, L, H)
+         : fcm_create(data, V, T, mode, P, C, M, L, H);
+  }
+  if (mode & FCM_DISK)          /* (the store directory precedes */
+    return (mode & FCM_SLOTS)   /* the number of tile slots, which */
+         ? fcm_create(data, V, T, mode, P, C, M, dir, K, x, bin)
+         : fcm_create(data, V, T, mode, P, C, M, dir, x, bin);
+  return (mode & FCM_SLOTS)     /* precedes the clamping bound and */
+       ? fcm_create(data, V, T, mode, P, C, M, K, x, bin)
+       : fcm_create(data, V, T, mode, P, C, M, x, bin);
+}  /* create() */               /* the threshold; surplus arguments */
+                                /* are ignored by fcm_create()) */
+
+/*--------------------------------------------------------------------*/
+
+static void winref (const REAL *data, REAL *corr, DIM V, DIM T,
+                    int L, int H, int var)
+{                               /* --- summarize windows naively */
+  int    n = (int)(T-L)/H +1;   /* number of windows */
+  double a, b, r;               /* sums of coefficients, coefficient */
+  double mx, my, xx, yy, xy;    /* means and sums of products */
+  const REAL *x, *y;            /* windows of the two series */
+  int    k, t;                  /* loop variables */
+
+  for (DIM i = 0; i < V; i++) { /* traverse the pairs */
+    for (DIM j = i+1; j < V; j++) {
+      for (a = b = 0, k = 0; k < n; k++) {
+        x = data +(size_t)i*(size_t)T +(size_t)(k*H);
+        y = data +(size_t)j*(size_t)T +(size_t)(k*H);
+        for (mx = my = 0, t = 0; t < L; t++) { mx += x[t]; my += y[t]; }
+        mx /= L; my /= L;       /* compute the means of the window */
+        for (xx = yy = xy = 0, t = 0; t < L; t++) {
+          xx += (x[t]-mx)*(x[t]-mx);
+          yy += (y[t]-my)*(y[t]-my);
+          xy += (x[t]-mx)*(y[t]-my);
+        }                       /* compute the correlation coeff. */
+        r  = ((xx > 0) && (yy > 0)) ? xy/sqrt(xx*yy) : 0;
+        a += r; b += r*r;       /* of the window (two passes) */
+      }                         /* and sum the coefficients */
+      a /= n; b = b/n -a*a;     /* store the mean or the variance */
+      corr[INDEX(i,j,V)] = (REAL)((!var) ? a : (b > 0) ? b : 0);
+    }
+  }
+}  /* winref() */
+
+/*--------------------------------------------------------------------*/
+
+static double xref (double r, int mode, double lim, double bin,
+                    double *d)
+{                               /* --- transform a reference coeff. */
+  double x = (sizeof(REAL) > 4) ? 0x1p-49 : 0x1p-20;
+  REAL   c = (REAL)lim;         /* (tolerance of the r-to-z kernels) */
+
+  if (mode & FCM_ABS)           /* same steps as fcm_xval(), */
+    r = fabs(r);                /* but computed in double and */
+  if (mode & FCM_CLAMP)         /* with atanh() as r-to-z */
+    r = (r > c) ? c : (r < -c) ? -c : r;
+  if (mode & FCM_R2Z) {         /* the tolerance *d of the element */
+    if (fabs(r) > (REAL)(1-R2Z_EPS))    /* grows with the slope */
+      r = (r < 0) ? -R2Z_MAX : R2Z_MAX; /* of the transform */
+    else { *d = *d/(1-r*r); r = atanh(r); *d += x*fabs(r); }
+  }
+  if (mode & FCM_BIN) {         /* binarize at the threshold */
+    *d = (fabs(r-(REAL)bin) <= *d) ? 1 : 0;
+    r  = (r >= (REAL)bin) ? 1 : 0;
+  }                             /* (near the threshold either value */
+  return r;                     /* is accepted) */
+}  /* xref() */
+
+/*--------------------------------------------------------------------*/
+
+static void isamask (int mask)
+{                               /* --- restrict the instruction sets */
+  char buf[32];                 /* buffer for the mask */
+
+  snprintf(buf, sizeof(buf), "%d", mask);
+  #ifdef _WIN32                 /* set the environment variable */
+  _putenv_s("FCM_ISA", buf);    /* that is read by fcm_isa() */
+  #else
+  setenv("FCM_ISA", buf, 1);
+  #endif
+}  /* isamask() */
+
+/*----------------------------------------------------------------------
+  Hardware Performance Counters
+----------------------------------------------------------------------*/
+#ifdef __linux__
+
+typedef struct {                /* --- counters of a thread */
+  pid_t  tid;                   /* thread identifier */
+  int    fd [PMU_CNT];          /* file descriptors of the counters */
+  double val[PMU_CNT];          /* (scaled) values of the counters */
+} PMUTHD;                       /* (cycles, instructions, LLC misses, */
+                                /* vector instructions) */
+static PMUTHD pmu[PMU_THD];     /* counters of the threads */
+static int    pmucnt = 0;       /* number of sampled threads */
+static long   pmuvec = 0;       /* raw event code for vector instrs. */
+static double pmubeg;           /* start time of the sampled phase */
+
+/*--------------------------------------------------------------------*/
+
+static void* nop (void *data)
+{ return data; }                /* --- empty pool task */
+
+/*--------------------------------------------------------------------*/
+
+static int pmu_open (pid_t tid, int k)
+{                               /* --- open a counter of a thread */
+  struct perf_event_attr attr;  /* attributes of the event */
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size   = sizeof(attr);   /* k = 0: cycles, 1: instructions, */
+  attr.type   = PERF_TYPE_HARDWARE; /* 2: last level cache misses, */
+  attr.config = (k == 0) ? PERF_COUNT_HW_CPU_CYCLES
+              : (k == 1) ? PERF_COUNT_HW_INSTRUCTIONS
+              :            PERF_COUNT_HW_CACHE_MISSES;
+  if (k == 3) {                 /* 3: vector instructions */
+    if (pmuvec == 0) return -1; /* (a raw event code, as it is */
+    attr.type   = PERF_TYPE_RAW;/* specific to the processor) */
+    attr.config = (uint64_t)pmuvec;
+  }
+  attr.inherit        = 1;      /* add threads created meanwhile */
+  attr.exclude_kernel = 1;      /* count only in user space */
+  attr.exclude_hv     = 1;      /* (allowed with perf_event_paranoid */
+  attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED
+                      | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0UL);
+}  /* pmu_open() */             /* open the counter and return it */
+
+/*--------------------------------------------------------------------*/
+
+static void pmu_start (int P, long vec)
+{                               /* --- start counting for a phase */
+  DIR    *dir;                  /* directory of the threads */
+  struct dirent *d;             /* entry of a thread */
+  PMUTHD *t;                    /* counters of a thread */
+  int    k;                     /* loop variable for counters */
+
+  pmuvec = vec;                 /* note the vector event code */
+  if (P > 1)                    /* start the pool workers, so that */
+    fcm_poolrun(nop, NULL, 0, P, P); /* they are sampled separately */
+  pmucnt = 0;                   /* (threads created later are added */
+  dir = opendir("/proc/self/task");   /* to the counters of their */
+  if (!dir) return;             /* creator when they terminate) */
+  while ((d = readdir(dir)) && (pmucnt < PMU_THD)) {
+    if (d->d_name[0] == '.') continue;
+    t = pmu +pmucnt++;          /* traverse the threads */
+    t->tid = (pid_t)atol(d->d_name);
+    for (k = 0; k < PMU_CNT; k++) /* open the counters */
+      t->fd[k] = pmu_open(t->tid, k);
+  }                             /* (counting starts immediately) */
+  closedir(dir);                /* close the thread directory */
+  pmubeg = timer();             /* note the start time */
+}  /* pmu_start() */
+
+/*--------------------------------------------------------------------*/
+
+static void pmu_stop (void)
+{                               /* --- stop counting and report */
+  PMUTHD   *t;                  /* counters of a thread */
+  int      i, k;                /* loop variables */
+  uint64_t buf[3];              /* value, time enabled, time running */
+  double   sum[PMU_CNT] = {0};  /* sums over the threads */
+  double   span;                /* duration of the phase */
+
+  span = timer() -pmubeg;       /* get the duration of the phase */
+  if ((pmucnt <= 0) || (pmu[0].fd[0] < 0)) {
+    fprintf(stderr, "pmu:    not available (perf_event_paranoid?)\n");
+    for (i = 0; i < pmucnt; i++)
+      for (k = 0; k < PMU_CNT; k++)
+        if (pmu[i].fd[k] >= 0) close(pmu[i].fd[k]);
+    pmucnt = 0; return;         /* close all counters */
+  }                             /* and abort the function */
+  for (i = 0; i < pmucnt; i++) {/* traverse the threads */
+    t = pmu +i;                 /* and their counters */
+    for (k = 0; k < PMU_CNT; k++) {
+      t->val[k] = 0;            /* clear the counter value */
+      if (t->fd[k] < 0) continue;
+      if ((read(t->fd[k], buf, sizeof(buf)) == sizeof(buf))
+      &&  (buf[2] > 0))         /* scale for multiplexing */
+        t->val[k] = (double)buf[0] *(double)buf[1] /(double)buf[2];
+      close(t->fd[k]);          /* read and close the counter */
+      sum[k] += t->val[k];      /* sum the counter values */
+    }
+  }
+  fprintf(stderr, "pmu:    %.3e cycles, %.3e instr. (IPC %.2f)\n",
+          sum[0], sum[1], (sum[0] > 0) ? sum[1]/sum[0] : 0);
+  fprintf(stderr, "        %.3e LLC misses (~%.2f GB/s)",
+          sum[2], sum[2] *PMU_LINE /span /1e9);
+  if (pmuvec != 0)              /* report the vector share */
+    fprintf(stderr, ", %.1f%% vector instr.",
+            (sum[1] > 0) ? 100 *sum[3]/sum[1] : 0);
+  fputc('\n', stderr);         /* print the phase totals */
+  for (i = 0; i < pmucnt; i++) {/* traverse the threads */
+    t = pmu +i;                 /* and print their counters */
+    fprintf(stderr, "  %7ld: %.3e cycles, IPC %.2f, %.3e LLC misses",
+            (long)t->tid, t->val[0],
+            (t->val[0] > 0) ? t->val[1]/t->val[0] : 0, t->val[2]);
+    if (pmuvec != 0)            /* add the vector share */
+      fprintf(stderr, ", %.1f%% vector",
+              (t->val[1] > 0) ? 100 *t->val[3]/t->val[1] : 0);
+    fprintf(stderr, "%s\n", (t->tid == getpid()) ? " (main)" : "");
+  }                             /* (the main thread includes joined */
+  pmucnt = 0;                   /* and dedicated fill threads) */
+}  /* pmu_stop() */
+
+#else                           /* if not Linux */
+#define pmu_start(P,v)          /* hardware performance counters */
+#define pmu_stop()              /* are not supported */
+#endif
+
 /*----------------------------------------------------------------------
   Main Function
 ----------------------------------------------------------------------*/
@@ -168,8 +456,25 @@ int main (int argc, char* argv[])
   DIM     C     = 8192;         /* tile size for caching */
   int     P     = proccnt();    /* number of threads */
   int     mode                  /* computation mode */
-            = FCM_PCC|FCM_THREAD|FCM_CACHE;
+            = FCM_PCC|FCM_THREAD|FCM_CACHE|FCM_MAXMEM;
+  double  M     = -1;           /* memory limit (in MiB, <0: default) */
   int     valid = 0;            /* flag for result validation */
+  int     tune  = 0;            /* flag for tuning tile/partition */
+  int     half  = 0;            /* 16 bit storage (1: fp16, 2: bf16) */
+  char    *fname = NULL;        /* file to save and reopen matrix */
+  char    *dir   = NULL;        /* directory for out-of-core store */
+  int     K     = 0;            /* number of tile slots */
+  DIM     O     = -1;           /* initial scans of online matrix */
+  int     L     = 0;            /* window length (0: no windows) */
+  int     H     = 1;            /* window step */
+  double  lim   = 1;            /* bound for clamping */
+  double  bin   = 0;            /* threshold for binarization */
+  double  tol   = 0;            /* relative tolerance for validation */
+  double  ctol;                 /* rel. tolerance of the cache kernels */
+  double  atol;                 /* abs. tolerance of the cache kernels */
+  double  e, z;                 /* tolerances for the current matrix */
+  int     apx;                  /* flag for a diff. summation order */
+  double  d;                    /* tolerance for the current element */
   long    S     = time(NULL);   /* seed value for random numbers */
   size_t  E     = 0;            /* number of edges of the graph */
   REAL    *data;                /* data array */
@@ -179,8 +484,21 @@ int main (int argc, char* argv[])
   REAL    a, b;                 /* to compare correlation coeffs. */
   int     diff;                 /* indicator for a difference */
   int     n = 1;                /* number of repetitions */
+  int     m;                    /* number of instruction set levels */
   double  t0;                   /* timer for measurements */
   FCMAT   *fcm;                 /* functional connectivity matrix */
+  FCMMEM  mem;                  /* memory usage of the matrix */
+  FCMSTATS st;                  /* runtime statistics of the matrix */
+  REAL    thr   = (REAL)0.01;   /* threshold for node degrees */
+  DIM     *deg;                 /* node degrees and their lower */
+  DIM     *lo, *hi;             /* and upper bounds (tolerance) */
+  REAL    *sub[SUBJ];           /* data and reference coefficients */
+  REAL    *ref[SUBJ];           /* of the subjects of a cohort */
+  FCMAT   *set[SUBJ];           /* matrices of the subjects */
+  FCMCOHORT *coh;               /* cohort of the subjects */
+  MATRIX  *mos;                 /* statistics of the cohort */
+  int     hwc   = 0;            /* flag for hardware perf. counters */
+  long    vec   = 0;            /* raw event code for vector instrs. */
 
   prgname = argv[0];            /* get program name for error msgs. */
 
@@ -192,8 +510,11 @@ int main (int argc, char* argv[])
     printf("usage: %s [options] V T\n", argv[0]);
     printf("%s\n", DESCRIPTION);
     printf("%s\n", VERSION);
-    printf("-v       validate result (compare to pcc)         "
+    printf("-v       validate result (compare to pcc/tcc)     "
            "(default: performance)\n");
+    printf("-T       tetrachoric correlation coefficient      "
+           "(default: Pearson)\n"
+           "         (validated with each set of tcc kernels)\n");
     printf("-s#      seed value for random number generator   "
            "(default: time)\n");
     printf("-t#      number of parallel threads               "
@@ -201,7 +522,55 @@ int main (int argc, char* argv[])
     printf("-c#      size of cache (number of rows/columns)   "
            "(default: 0)\n");
     printf("-j       join and re-create threads               "
-           "(default: blk+sig)\n");
+           "(default: pool)\n");
+    printf("-w       dedicated workers with spin barriers     "
+           "(default: pool)\n");
+    printf("-a       pull sub-blocks of tiles dynamically     "
+           "(default: static split)\n");
+    printf("-u       tune tile size and partition (ignores -c)\n");
+    printf("-f#      16 bit storage of half-stored matrix     "
+           "(default: none)\n"
+           "         (1: fp16, 2: bf16; only if -c equals V)\n");
+    printf("-m file  save half-stored matrix and reopen it    "
+           "(default: none)\n"
+           "         (with fcm_open; only if -v and -c equals V)\n");
+    printf("-M#      memory limit in MiB                      "
+           "(default: 2048)\n");
+    printf("-d dir   out-of-core store in this directory      "
+           "(default: none)\n"
+           "         (only if -c equals V and the matrix exceeds -M)\n");
+    printf("-b       tiled half-stored matrix (64x64 tiles)   "
+           "(default: rows)\n"
+           "         (only if -c equals V)\n");
+    printf("-k#      number of tile slots (0: from -M)        "
+           "(default: 1)\n"
+           "         (only if -c is less than V)\n");
+    printf("-p       fill the next tile while traversing      "
+           "(default: no)\n"
+           "         (only if -c is less than V, not with -j or -k)\n");
+    printf("-o#      online matrix from # scans, append rest  "
+           "(default: none)\n"
+           "         (with fcm_online/fcm_append; ignores -c)\n");
+    printf("-x#      mean of sliding-window correlations      "
+           "(default: none)\n"
+           "         (# window length; not with -o)\n");
+    printf("-y#      step of the sliding windows              "
+           "(default: %d)\n", H);
+    printf("-z       variance instead of mean of the windows  "
+           "(default: mean)\n");
+    printf("-A       absolute value of the coefficients       "
+           "(default: no)\n");
+    printf("-C#      clamp the coefficients to [-#,+#]        "
+           "(default: no)\n");
+    printf("-r       Fisher r-to-z transform                  "
+           "(default: no)\n");
+    printf("-B#      binarize at threshold #                  "
+           "(default: no)\n"
+           "         (transforms are applied in this order; "
+           "not with -x)\n");
+    printf("-e#      sample hardware performance counters     "
+           "(default: no)\n"
+           "         (Linux only; # raw event code for vector instr.)\n");
     printf("V        number of voxels\n");
     printf("T        number of time points\n");
     return 0;                   /* print a usage message */
@@ -215,13 +584,34 @@ int main (int argc, char* argv[])
       while (*s) {              /* traverse the options */
         switch (*s++) {         /* evaluate the options */
           case 'v': valid  = 1;                     break;
+          case 'T': mode   = (mode & ~FCM_CORR) | FCM_TCC; break;
           case 's': S      =      strtol(s, &s, 0); break;
           case 't': P      = (int)strtol(s, &s, 0); break;
           case 'c': C      =      strtodim(s, &s);  break;
           case 'j': mode  |= FCM_JOIN;              break;
-          #if 0
-          case 'x': optarg = &arg;                  break;
-          #endif
+          case 'w': mode  |= FCM_SPIN;              break;
+          case 'a': mode  |= FCM_DYNAMIC;           break;
+          case 'u': tune   = 1;                     break;
+          case 'f': half   = (int)strtol(s, &s, 0); break;
+          case 'm': optarg = &fname;                break;
+          case 'M': M      =      strtod(s, &s);    break;
+          case 'd': optarg = &dir;  mode |= FCM_DISK; break;
+          case 'b': mode  |= FCM_TILED;             break;
+          case 'k': K      = (int)strtol(s, &s, 0);
+                    mode  |= FCM_SLOTS;             break;
+          case 'p': mode  |= FCM_PIPE;              break;
+          case 'o': O      =      strtodim(s, &s);  break;
+          case 'x': L      = (int)strtol(s, &s, 0); break;
+          case 'y': H      = (int)strtol(s, &s, 0); break;
+          case 'z': mode  |= FCM_WVAR;              break;
+          case 'A': mode  |= FCM_ABS;               break;
+          case 'C': lim    =      strtod(s, &s);
+                    mode  |= FCM_CLAMP;             break;
+          case 'r': mode  |= FCM_R2Z;               break;
+          case 'B': bin    =      strtod(s, &s);
+                    mode  |= FCM_BIN;               break;
+          case 'e': vec    =      strtol(s, &s, 0);
+                    hwc    = 1;                     break;
           default : error(E_OPTION, *--s);          break;
         }                       /* set the option variables */
         if (optarg && *s) { *optarg = s; optarg = NULL; break; }
@@ -237,8 +627,38 @@ int main (int argc, char* argv[])
   if (optarg) error(E_OPTARG);  /* check option arguments */
   if (k != 2) error(E_ARGCNT);  /* and number of arguments */
   if (P <  0) error(1, "P < 0");/* and the number of threads */
-  if (C <  0) error(1, "C < 0");/* get the tile size for caching */
-  if (C >  V) error(1, "C > V");
+  if (tune)                     /* if to tune tile and partition, */
+    mode = (mode & ~FCM_CACHE) | FCM_TUNE;   /* do not fix the tile */
+  else {                        /* if to use a fixed tile size */
+    if (C <  0) error(1, "C < 0");
+    if (C >  V) error(1, "C > V");
+  }                             /* check the tile size for caching */
+  if (O >  T) error(1, "O > T");/* and the initial online scans */
+  if ((O >= 0) && ((mode & FCM_CORR) == FCM_TCC))
+    error(1, "online matrix with tcc");
+  if (L >  0) {                 /* if sliding windows are requested */
+    if (L <  2)  error(1, "L < 2");
+    if (L >  T)  error(1, "L > T");
+    if (H <  1)  error(1, "H < 1");
+    if (O >= 0)  error(1, "online matrix with windows");
+    if ((mode & FCM_CORR) == FCM_TCC) error(1, "tcc with windows");
+    if (mode & FCM_XFORM) error(1, "transforms with windows");
+    mode |= FCM_WINDOW;         /* check the window length and step */
+  }                             /* (windows need all scans at once) */
+  else if (mode & FCM_WVAR) error(1, "-z needs -x");
+  if      (half == 1) { mode |= FCM_F16;  tol = 0x1p-10; }
+  else if (half == 2) { mode |= FCM_BF16; tol = 0x1p-7;  }
+  else if (half != 0) error(1, "unknown 16 bit format");
+  ctol = (sizeof(REAL) > 4) ? 0x1p-50 : 0x1p-21;
+  atol = ctol *sqrt((double)T); /* tiles, online moments and windows */
+  if (ctol < tol) ctol = tol;   /* sum in another order than pcc: r */
+                                /* differs by a few ulps of 1, not of */
+                                /* r (cancellation near r = 0), which */
+                                /* grow with sqrt(T) (random rounding */
+                                /* errors), so use a mixed bound of */
+                                /* 4 ulps rel. and 4 sqrt(T) ulps abs. */
+                                /* (errors of about 1e-3 still fail) */
+  if (M >= 0) M /= 1024;       /* convert the memory limit to GiB */
   if (S <  0) error(1, "S < 0");/* get the seed value and */
   srand((unsigned)S);           /* seed the random number generator */
   E = (size_t)V*(size_t)(V-1)/2;/* compute the number of edges */
@@ -252,92 +672,239 @@ int main (int argc, char* argv[])
 
   /* --- validate computation results --- */
   if (valid) {                  /* if to validate the results */
-    fprintf(stderr, "computing reference result using pcc ... ");
+    if ((mode & FCM_CORR) == FCM_TCC) {
+      fprintf(stderr, "computing reference result using tcc ... ");
+      m = (int)(sizeof(isalvl)/sizeof(*isalvl)); }
+    else {                      /* tetrachoric: test all kernels */
+      fprintf(stderr, "computing reference result using pcc ... ");
+      m = 1;                    /* Pearson: test only the kernels */
+    }                           /* of the best instruction sets */
     corr = malloc((size_t)V *(size_t)(V-1)/2 *sizeof(REAL));
     if (!corr) error(E_NOMEM);  /* allocate memory for corr. coeffs. */
-    pccx(data, corr, (int)V, (int)T, PCC_AUTO);
+    if      (L > 0)             /* windows: compute them naively */
+      winref(data, corr, V, T, L, H, (mode & FCM_WVAR) != 0);
+    else if ((mode & FCM_CORR) == FCM_TCC)
+      tetraccx(data, corr, (int)V, (int)T, TCC_AUTO);
+    else pccx(data, corr, (int)V, (int)T, PCC_AUTO);
     fprintf(stderr, "done.\n"); /* compute correlation coefficients */
 
     fprintf(stderr, "test (fcm_get) ... ");
-    fcm = fcm_create(data, V, T, mode, P, C);
-    if (!fcm) error(E_NOMEM);   /* create functional connect. matrix */
     diff = 0;                   /* initialize the difference counter */
-    for (DIM i = 0; i < V; i++) { /* traverse rows and cols */
-      for (DIM j = i+1; j < V; j++) {
-        a = fcm_get(fcm,i,j);
-        b = corr[INDEX(i,j,V)]; /* get correlation coefficients */
-        if (a == b) continue;   /* and compare them */
+    for (int l = 0; l < m; l++) {   /* traverse the kernel levels */
+      if (m > 1) isamask(isalvl[l]);
+      fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
+      if (!fcm) error(E_NOMEM); /* create functional connect. matrix */
+      if (fname) fcm = reopen(fcm, fname);
+      if (tune)                 /* report the tuned setting */
+        fprintf(stderr, "[tile %"DIM_FMT", grid %"DIM_FMT"x%"DIM_FMT"] ",
+                fcm->tile, fcm->gr, fcm->gc);
+      apx = ((fcm->slot.cnt > 1) || (O >= 0) || (L > 0));
+      e = (apx) ? ctol : tol;   /* get the tolerances */
+      z = (apx) ? atol : 0;     /* for the current matrix */
+      for (DIM i = 0; i < V; i++) { /* traverse rows and cols */
+        for (DIM j = i+1; j < V; j++) {
+          a = fcm_get(fcm,i,j);
+          b = corr[INDEX(i,j,V)]; /* get correlation coefficients */
+          d = e*(fabs(b)+1e-4) +z;  /* (fp16: subnormals) */
+          b = (REAL)xref(b, mode, lim, bin, &d);
+          if ((a == b) || (fabs(a-b) <= d))
+            continue;           /* transform and compare them */
+          if (!diff) fprintf(stderr, "\n");
+          fprintf(stderr, "%6"DIM_FMT" %6"DIM_FMT, i, j);
+          fprintf(stderr, ": % 18.16f % 18.16f", a, b);
+          if (m > 1) fprintf(stderr, " [isa %#x]", (unsigned)isalvl[l]);
+          fprintf(stderr, "\n");
+          diff += 1;            /* print any difference and */
+        }                       /* count the number of differences */
+      }
+      fcm_delete(fcm);          /* delete the func. connect. matrix */
+    }
+    if (m > 1) isamask(-1);     /* reset the instruction sets */
+    if (diff) fprintf(stderr, "failed [%d].\n", diff);
+    else      fprintf(stderr, "passed.\n");
+
+    fprintf(stderr, "test (fcm_next) ... ");
+    diff = 0;                   /* initialize the difference counter */
+    for (int l = 0; l < m; l++) {   /* traverse the kernel levels */
+      if (m > 1) isamask(isalvl[l]);
+      fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
+      if (!fcm) error(E_NOMEM); /* create functional connect. matrix */
+      if (fname) fcm = reopen(fcm, fname);
+      apx = (((fcm->tile > 0) && (fcm->tile < V)) || (O >= 0) || (L > 0));
+      e = (apx) ? ctol : tol;   /* get the tolerances */
+      z = (apx) ? atol : 0;     /* (online: moments in double) */
+      for (t = fcm_first(fcm); t == 0; t = fcm_next(fcm)) {
+        r = fcm_row(fcm);       /* traverse the matrix elements */
+        c = fcm_col(fcm);       /* and get their row and column */
+        a = fcm_value(fcm);
+        b = corr[INDEX(r,c,V)]; /* get correlation coefficients */
+        d = e*(fabs(b)+1e-4) +z;
+        b = (REAL)xref(b, mode, lim, bin, &d);
+        if ((a == b) || (fabs(a-b) <= d))
+          continue;             /* transform and compare them */
         if (!diff) fprintf(stderr, "\n");
-        fprintf(stderr, "%6"DIM_FMT" %6"DIM_FMT, i, j);
-        fprintf(stderr, ": % 18.16f % 18.16f\n", a, b);
+        fprintf(stderr, "%6"DIM_FMT" %6"DIM_FMT, r, c);
+        fprintf(stderr, ": % 18.16f % 18.16f", a, b);
+        if (m > 1) fprintf(stderr, " [isa %#x]", (unsigned)isalvl[l]);
+        fprintf(stderr, "\n");
         diff += 1;              /* print any difference and */
       }                         /* count the number of differences */
+      if (t < 0) error(E_THREAD);   /* check for a computation error */
+      fcm_delete(fcm);          /* delete the func. connect. matrix */
     }
-    fcm_delete(fcm);            /* delete the func. connect. matrix */
+    if (m > 1) isamask(-1);     /* reset the instruction sets */
     if (diff) fprintf(stderr, "failed [%d].\n", diff);
     else      fprintf(stderr, "passed.\n");
 
-    fprintf(stderr, "test (fcm_next) ... ");
-    fcm = fcm_create(data, V, T, mode, P, C);
+    fprintf(stderr, "test (nodedeg) ... ");
+    fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
     if (!fcm) error(E_NOMEM);   /* create functional connect. matrix */
-    diff = 0;                   /* initialize the difference flag */
-    for (t = fcm_first(fcm); t > 0; t = fcm_next(fcm)) {
-      r = fcm_row(fcm);         /* traverse the matrix elements */
-      c = fcm_col(fcm);         /* and get their row and column */
-      a = fcm_value(fcm);
-      b = corr[INDEX(r,c,V)];   /* get correlation coefficients */
-      if (a == b) continue;     /* and compare them */
+    if (fname) fcm = reopen(fcm, fname);
+    apx  = ((fcm->slot.cnt > 1) || (O >= 0) || (L > 0));
+    e    = (apx) ? ctol : tol;  /* get the tolerances */
+    z    = (apx) ? atol : 0;    /* for the current matrix */
+    deg  = malloc(3 *(size_t)V *sizeof(DIM));
+    if (!deg) error(E_NOMEM);   /* allocate the node degrees */
+    lo   = deg +V; hi = lo +V;  /* and their bounds */
+    for (DIM i = 0; i < V; i++) lo[i] = hi[i] = 0;
+    for (DIM i = 0; i < V; i++) { /* traverse rows and cols */
+      for (DIM j = i+1; j < V; j++) {
+        b = corr[INDEX(i,j,V)]; /* get correlation coefficient */
+        d = e*(fabs(b)+1e-4) +z;/* and transform it */
+        b = (REAL)xref(b, mode, lim, bin, &d);
+        if      (fabs(b-thr) <= d) {
+          hi[i]++; hi[j]++; }   /* edges near the threshold may be */
+        else if (b > thr) {     /* on either side of it, other edges */
+          lo[i]++; lo[j]++;     /* must be present in both bounds */
+          hi[i]++; hi[j]++;     /* (compute bounds of the degrees */
+        }                       /* from the reference coefficients) */
+      }
+    }
+    if (fcm_nodedeg(fcm, thr, deg, FCM_THREAD, P) != 0)
+      error(1, "error (fcm_nodedeg)");
+    diff = 0;                   /* compute the node degrees */
+    for (DIM i = 0; i < V; i++) { /* with the requested threads */
+      if ((deg[i] >= lo[i]) && (deg[i] <= hi[i]))
+        continue;               /* compare them to the bounds */
       if (!diff) fprintf(stderr, "\n");
-      fprintf(stderr, "%6"DIM_FMT" %6"DIM_FMT, r, c);
-      fprintf(stderr, ": % 18.16f % 18.16f\n", a, b);
+      fprintf(stderr, "%6"DIM_FMT": %6"DIM_FMT" [%"DIM_FMT", %"DIM_FMT"]\n",
+              i, deg[i], lo[i], hi[i]);
       diff += 1;                /* print any difference and */
     }                           /* count the number of differences */
-    if (t < 0) error(E_THREAD); /* check for a computation error */
+    free(deg);                  /* delete the node degrees */
     fcm_delete(fcm);            /* delete the func. connect. matrix */
     if (diff) fprintf(stderr, "failed [%d].\n", diff);
     else      fprintf(stderr, "passed.\n");
 
+    if (((mode & FCM_CORR) == FCM_PCC) && (L <= 0)) {
+      fprintf(stderr, "test (cohort) ... ");
+      sub[0] = data;            /* the first subject has the data */
+      ref[0] = corr;            /* of the tests above */
+      for (int l = 1; l < SUBJ; l++) {
+        sub[l] = malloc((size_t)V *(size_t)T *sizeof(REAL));
+        ref[l] = malloc(E *sizeof(REAL));
+        if (!sub[l] || !ref[l]) error(E_NOMEM);
+        for (size_t i = 0; i < (size_t)(T*V); i++)
+          sub[l][i] = (REAL)(rand()/((double)RAND_MAX+1));
+        pccx(sub[l], ref[l], (int)V, (int)T, PCC_AUTO);
+      }                         /* generate the other subjects */
+      coh = fcm_cohort(sub, SUBJ, V, T,
+                       mode & (FCM_CORR|FCM_THREAD|FCM_MAXMEM|FCM_XFORM),
+                       P, M, (mode & FCM_CLAMP) ? lim : bin, bin);
+      mos = mat_create(V, 0);   /* create the cohort (same transform) */
+      if (!mos) error(E_NOMEM); /* and the matrix of statistics */
+      if (coh && (fcm_cohuni(coh, mean, mos) != 0)) error(E_THREAD);
+      for (int l = 0; l < SUBJ; l++) {
+        set[l] = create(sub[l], V, T, mode, P, C, M, dir, K, O, L, H,
+                        lim, bin);
+        if (!set[l]) error(E_NOMEM);
+      }                         /* create a matrix per subject */
+      diff = 0;                 /* compute the means of the edges */
+      for (DIM i = 0; coh && (i < V); i++) {
+        for (DIM j = i+1; j < V; j++) {
+          double sum = 0, tsum = 0;
+          for (int l = 0; l < SUBJ; l++) {
+            sum += fcm_get(set[l],i,j);
+            b = ref[l][INDEX(i,j,V)];
+            d = ctol*(fabs(b)+1e-4) +atol;
+            xref(b, mode, lim, bin, &d);
+            tsum += d;          /* sum the values of the subjects */
+          }                     /* and the tolerances of the values */
+          a = mat_get(mos,i,j); /* (the cohort normalizes in double, */
+          b = (REAL)(sum/SUBJ); /* so both may deviate from the ref.) */
+          if ((a == b) || (fabs(a-b) <= 2*tsum/SUBJ))
+            continue;           /* compare the means */
+          if (!diff) fprintf(stderr, "\n");
+          fprintf(stderr, "%6"DIM_FMT" %6"DIM_FMT, i, j);
+          fprintf(stderr, ": % 18.16f % 18.16f\n", a, b);
+          diff += 1;            /* print any difference and */
+        }                       /* count the number of differences */
+      }
+      mat_delete(mos);          /* delete the statistics, */
+      if (coh) fcm_cohdel(coh); /* the cohort and the matrices */
+      for (int l = 0; l < SUBJ; l++) fcm_delete(set[l]);
+      for (int l = 1; l < SUBJ; l++) { free(sub[l]); free(ref[l]); }
+      if      (!coh) fprintf(stderr, "skipped (memory limit).\n");
+      else if (diff) fprintf(stderr, "failed [%d].\n", diff);
+      else           fprintf(stderr, "passed.\n");
+    }                           /* (Pearson only, no windows) */
+
     free(corr);                 /* delete correlation coefficients */
   }
 
   /* --- test performance --- */
   else {                        /* if to test performance */
     fprintf(stderr, "perf (fcm_get) ... ");
+    if (hwc) pmu_start(P, vec); /* start the hardware counters */
     t0 = timer();               /* start the timer */
-    fcm = fcm_create(data, V, T, mode, P, C);
+    fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
     if (!fcm) error(E_NOMEM);   /* create functional connect. matrix */
+    if (tune)                   /* report the tuned setting */
+      fprintf(stderr, "[tile %"DIM_FMT", grid %"DIM_FMT"x%"DIM_FMT"] ",
+              fcm->tile, fcm->gr, fcm->gc);
     for (DIM i = 0; i < fcm_dim(fcm); i++)
       for (DIM j = i+1; j < fcm_dim(fcm); j++)
         a = fcm_get(fcm,i,j);
+    fcm_memusage(fcm, &mem);    /* get the memory usage */
     fcm_delete(fcm);            /* delete the func. connect. matrix */
     t0 = (timer()-t0)/(double)n;
     fprintf(stderr, "done.\n");
     fprintf(stderr, "time:   %8.2fs\n", t0);
     fprintf(stderr, "Mccf/s: %8.2f\n", (double)E/t0/1e6);
+    fprintf(stderr, "MiB:    %8.2f (peak %.2f)\n",
+            (double)mem.total/1048576.0, (double)mem.peak/1048576.0);
+    if (hwc) pmu_stop();        /* report the hardware counters */
 
     fprintf(stderr, "perf (fcm_next) ... ");
+    if (hwc) pmu_start(P, vec); /* start the hardware counters */
     t0 = timer();               /* start the timer */
-    fcm = fcm_create(data, V, T, mode, P, C);
+    fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
     if (!fcm) error(E_NOMEM);   /* create functional connect. matrix */
-    for (t = fcm_first(fcm); t > 0; t = fcm_next(fcm)) {
+    for (t = fcm_first(fcm); t == 0; t = fcm_next(fcm)) {
       r = fcm_row(fcm);         /* traverse the matrix elements */
       c = fcm_col(fcm);         /* and get their row and column */
       a = fcm_value(fcm);
     }                           /* get the matrix elements */
     if (t < 0) error(E_THREAD); /* check for a computation error */
+    fcm_stats(fcm, &st, -1);    /* get the runtime statistics */
     fcm_delete(fcm);            /* delete the func. connect. matrix */
     t0 = (timer()-t0)/(double)n;
     fprintf(stderr, "done.\n");
     fprintf(stderr, "time:   %8.2fs\n", t0);
     fprintf(stderr, "Mccf/s: %8.2f\n", (double)E/t0/1e6);
+    fprintf(stderr, "tiles:  %8zu (fill %.2fs, idle %.2fs, sync %.2fs)\n",
+            st.fills, st.time, st.idle, st.sync);
+    fprintf(stderr, "comp:   %8zu (hits %zu, GB read %.2f)\n",
+            st.comp, st.hits, st.bytes/1e9);
+    if (hwc) pmu_stop();        /* report the hardware counters */
 
     fprintf(stderr, "perf (nodedeg) ... ");
-    REAL thr = 0.01f;
     printf("\nthr = %f\n", thr);
     for (int i = 0; i < 5; i++) {
       printf("p: %d\n", i);
+      if (hwc) pmu_start(P, vec);
       t0 = timer();             /* start the timer */
-      fcm = fcm_create(data, V, T, mode, P, C);
+      fcm = create(data, V, T, mode, P, C, M, dir, K, O, L, H, lim, bin);
       if (!fcm) error(E_NOMEM);
       DIM *intres = malloc((size_t)V* sizeof(DIM));
       if (!intres) error(E_NOMEM);
@@ -349,9 +916,13 @@ int main (int argc, char* argv[])
       fprintf(stderr, "done.\n");
       fprintf(stderr, "time:   %8.2fs\n", t0);
       fprintf(stderr, "Mccf/s: %8.2f\n", (double)E/t0/1e6);
+      if (hwc) pmu_stop();
     }
   }
 
   free(data);                   /* delete the generated data */
+  #ifndef _WIN32                /* if Linux/Unix system */
+  fcm_poolexit();               /* stop the shared thread pool */
+  #endif
   return 0;                     /* return 'ok' */
 }  /* main() */